@@ -0,0 +1,48 @@
+// Version directive is set by Warzone when loading the shader
+// (This shader supports GLSL 1.50 core and GLSL ES 3.00, as instancing needs them.)
+// Instanced variant of nolight.frag: the per-instance uniforms come from the vertex shader instead.
+
+//#pragma debug(on)
+
+uniform sampler2D Texture;
+uniform float graphicsCycle; // a periodically cycling value for special effects
+
+uniform int fogEnabled; // whether fog is enabled
+uniform float fogEnd;
+uniform float fogStart;
+uniform vec4 fogColor;
+
+in float vertexDistance;
+in vec2 texCoord;
+flat in vec4 colour;
+flat in float alphaTest;
+
+out vec4 FragColor;
+
+void main()
+{
+	vec4 texColour = texture(Texture, texCoord);
+
+	vec4 fragColour = texColour * colour;
+
+	if ((alphaTest != 0.0) && (fragColour.a <= 0.001))
+	{
+		discard;
+	}
+	
+	if (fogEnabled > 0)
+	{
+		// Calculate linear fog
+		float fogFactor = (fogEnd - vertexDistance) / (fogEnd - fogStart);
+
+		if(fogFactor > 1.f)
+		{
+			discard;
+		}
+
+		// Return fragment color
+		fragColour = mix(fragColour, vec4(fogColor.xyz, fragColour.w), clamp(fogFactor, 0.0, 1.0));
+	}
+
+	FragColor = fragColour;
+}
@@ -0,0 +1,36 @@
+// Version directive is set by Warzone when loading the shader
+// (This shader supports GLSL 1.50 core and GLSL ES 3.00, as instancing needs them.)
+// Instanced variant of nolight.vert: the per-instance uniforms come from per-instance attributes instead.
+
+//#pragma debug(on)
+
+uniform mat4 ProjectionMatrix;
+
+in vec4 vertex;
+in vec2 vertexTexCoord;
+
+in mat4 instanceModelViewMatrix;
+in vec4 instanceColour;
+in vec4 instanceParams; // stretch, ecmEffect, alphaTest
+
+out vec2 texCoord;
+out float vertexDistance;
+flat out vec4 colour;
+flat out float alphaTest;
+
+void main()
+{
+	colour = instanceColour;
+	alphaTest = instanceParams.z;
+
+	// Pass texture coordinates to fragment shader
+	texCoord = vertexTexCoord;
+
+	// Translate every vertex according to the Model View and Projection Matrix
+	mat4 ModelViewProjectionMatrix = ProjectionMatrix * instanceModelViewMatrix;
+	vec4 gposition = ModelViewProjectionMatrix * vertex;
+	gl_Position = gposition;
+
+	// Remember vertex distance
+	vertexDistance = gposition.z;
+}
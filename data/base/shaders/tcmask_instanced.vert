@@ -0,0 +1,77 @@
+// Version directive is set by Warzone when loading the shader
+// (This shader supports GLSL 1.50 core and GLSL ES 3.00, as instancing needs them.)
+// Instanced variant of tcmask.vert: the per-instance uniforms come from per-instance attributes instead.
+
+//#pragma debug(on)
+
+uniform mat4 ProjectionMatrix;
+uniform int hasTangents; // whether tangents were calculated for model
+uniform vec4 lightPosition;
+
+in vec4 vertex;
+in vec3 vertexNormal;
+in vec2 vertexTexCoord;
+in vec4 vertexTangent;
+
+in mat4 instanceModelViewMatrix;
+in mat4 instanceNormalMatrix;
+in vec4 instanceColour;
+in vec4 instanceTeamcolour;
+in vec4 instanceParams; // stretch, ecmEffect, alphaTest
+
+out float vertexDistance;
+out vec3 normal, lightDir, halfVec;
+out vec2 texCoord;
+flat out mat3 NormalMatrix;
+flat out vec4 colour;
+flat out vec4 teamcolour;
+flat out vec2 effects; // ecmEffect, alphaTest
+
+void main()
+{
+	mat4 ModelViewMatrix = instanceModelViewMatrix;
+	float stretch = instanceParams.x;
+	NormalMatrix = mat3(instanceNormalMatrix);
+	colour = instanceColour;
+	teamcolour = instanceTeamcolour;
+	effects = instanceParams.yz;
+
+	// Pass texture coordinates to fragment shader
+	texCoord = vertexTexCoord;
+
+	// Lighting we pass to the fragment shader
+	vec4 viewVertex = ModelViewMatrix * vec4(vertex.xyz, -vertex.w); // FIXME
+	vec3 eyeVec = normalize(-viewVertex.xyz);
+	vec3 n = normalize((instanceNormalMatrix * vec4(vertexNormal, 0.0)).xyz);
+	lightDir = normalize(lightPosition.xyz);
+
+	if (hasTangents != 0)
+	{
+		// Building the matrix Eye Space -> Tangent Space with handness
+		vec3 t = normalize((instanceNormalMatrix * vertexTangent).xyz);
+		vec3 b = cross (n, t) * vertexTangent.w;
+		mat3 TangentSpaceMatrix = mat3(t, n, b);
+
+		// Transform light and eye direction vectors by tangent basis
+		lightDir *= TangentSpaceMatrix;
+		eyeVec *= TangentSpaceMatrix;
+	}
+
+	normal = n;
+	halfVec = lightDir + eyeVec;
+
+	// Implement building stretching to accommodate terrain
+	vec4 position = vertex;
+	if (vertex.y <= 0.0) // use vertex here directly to help shader compiler optimization
+	{
+		position.y -= stretch;
+	}
+
+	// Translate every vertex according to the Model View and Projection Matrix
+	mat4 ModelViewProjectionMatrix = ProjectionMatrix * ModelViewMatrix;
+	vec4 gposition = ModelViewProjectionMatrix * position;
+	gl_Position = gposition;
+
+	// Remember vertex distance
+	vertexDistance = gposition.z;
+}
@@ -0,0 +1,47 @@
+#version 450
+// Instanced variant of nolight.frag: the per-instance uniforms come from the vertex shader instead.
+//#pragma debug(on)
+
+layout(set = 2, binding = 0) uniform sampler2D Texture;
+layout(std140, set = 0, binding = 0) uniform globaluniforms
+{
+	mat4 ProjectionMatrix;
+	vec4 lightPosition;
+	vec4 sceneColor;
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+	vec4 fogColor;
+	float fogEnd;
+	float fogStart;
+	float graphicsCycle;
+	int fogEnabled;
+};
+
+layout(std140, set = 1, binding = 0) uniform meshuniforms
+{
+	int tcmask;
+	int normalmap;
+	int specularmap;
+	int hasTangents;
+};
+
+layout(location = 0) in vec2 texCoord;
+layout(location = 1) flat in vec4 colour;
+layout(location = 2) flat in float alphaTest;
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+	vec4 texColour = texture(Texture, texCoord);
+
+	vec4 fragColour = texColour * colour;
+
+	if (alphaTest > 0.0 && (fragColour.a <= 0.001))
+	{
+		discard;
+	}
+
+	FragColor = fragColour;
+}
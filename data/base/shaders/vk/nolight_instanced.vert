@@ -0,0 +1,52 @@
+#version 450
+// Instanced variant of nolight.vert: the per-instance uniforms come from per-instance attributes instead.
+//#pragma debug(on)
+
+layout(std140, set = 0, binding = 0) uniform globaluniforms
+{
+	mat4 ProjectionMatrix;
+	vec4 lightPosition;
+	vec4 sceneColor;
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+	vec4 fogColor;
+	float fogEnd;
+	float fogStart;
+	float graphicsCycle;
+	int fogEnabled;
+};
+
+layout(std140, set = 1, binding = 0) uniform meshuniforms
+{
+	int tcmask;
+	int normalmap;
+	int specularmap;
+	int hasTangents;
+};
+
+layout(location = 0) in vec4 vertex;
+layout(location = 1) in vec2 vertexTexCoord;
+
+layout(location = 5) in mat4 instanceModelViewMatrix;
+layout(location = 13) in vec4 instanceColour;
+layout(location = 15) in vec4 instanceParams; // stretch, ecmEffect, alphaTest
+
+layout(location = 0) out vec2 texCoord;
+layout(location = 1) flat out vec4 colour;
+layout(location = 2) flat out float alphaTest;
+
+void main()
+{
+	colour = instanceColour;
+	alphaTest = instanceParams.z;
+
+	// Pass texture coordinates to fragment shader
+	texCoord = vertexTexCoord;
+
+	// Translate every vertex according to the Model, View and Projection matrices
+	mat4 ModelViewProjectionMatrix = ProjectionMatrix * instanceModelViewMatrix;
+	gl_Position = ModelViewProjectionMatrix * vertex;
+	gl_Position.y *= -1.;
+	gl_Position.z = (gl_Position.z + gl_Position.w) / 2.0;
+}
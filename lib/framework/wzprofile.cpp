@@ -0,0 +1,178 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * wzprofile.cpp
+ *
+ * CPU zone profiler, with Chrome trace export.
+ */
+
+#include "frame.h"
+#include "wzprofile.h"
+#include "wzapp.h"
+#include "physfs_ext.h"
+
+#include <thread>
+#include <vector>
+
+#define PROFILE_MAX_THREADS 32
+#define PROFILE_RING_SIZE   (1 << 16)  ///< Zones kept per thread.
+
+struct ProfileEvent
+{
+	const char *name;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point end;
+};
+
+struct ProfileThread
+{
+	std::thread::id id;
+	const char *name = nullptr;
+	wz::mutex mutex;                   ///< Only contended while writing the trace.
+	std::vector<ProfileEvent> ring;
+	size_t next = 0;                   ///< Where to write the next zone.
+	size_t count = 0;                  ///< Number of valid zones in the ring.
+};
+
+std::atomic<bool> wzProfileActive(false);
+
+// thread_local is avoided, since it may not be supported properly on all platforms. Instead, threads look themselves
+// up by id. The ids are written once, before increasing profileThreadCount, so the lookup doesn't need a lock.
+static ProfileThread profileThreads[PROFILE_MAX_THREADS];
+static std::atomic<unsigned> profileThreadCount(0);
+static wz::mutex profileRegisterMutex;
+static std::chrono::steady_clock::time_point profileEpoch;
+
+static ProfileThread *profileThisThread()
+{
+	std::thread::id id = std::this_thread::get_id();
+	unsigned count = profileThreadCount.load(std::memory_order_acquire);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		if (profileThreads[i].id == id)
+		{
+			return &profileThreads[i];
+		}
+	}
+
+	std::lock_guard<wz::mutex> lock(profileRegisterMutex);
+	count = profileThreadCount.load(std::memory_order_relaxed);
+	if (count >= PROFILE_MAX_THREADS)
+	{
+		return nullptr;  // Zones on any further threads are not recorded.
+	}
+	ProfileThread &thread = profileThreads[count];
+	thread.id = id;
+	profileThreadCount.store(count + 1, std::memory_order_release);
+	return &thread;
+}
+
+void wzProfileStart()
+{
+	unsigned count = profileThreadCount.load(std::memory_order_acquire);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		std::lock_guard<wz::mutex> lock(profileThreads[i].mutex);
+		profileThreads[i].next = 0;
+		profileThreads[i].count = 0;
+	}
+	profileEpoch = std::chrono::steady_clock::now();
+	wzProfileThreadName("main");
+	wzProfileActive.store(true, std::memory_order_relaxed);
+	debug(LOG_INFO, "Profiling started");
+}
+
+void wzProfileStop()
+{
+	wzProfileActive.store(false, std::memory_order_relaxed);
+	debug(LOG_INFO, "Profiling stopped");
+}
+
+void wzProfileThreadName(const char *name)
+{
+	ProfileThread *thread = profileThisThread();
+	if (thread != nullptr)
+	{
+		std::lock_guard<wz::mutex> lock(thread->mutex);
+		thread->name = name;
+	}
+}
+
+void wzProfileRecord(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	ProfileThread *thread = profileThisThread();
+	if (thread == nullptr)
+	{
+		return;
+	}
+	std::lock_guard<wz::mutex> lock(thread->mutex);
+	if (thread->ring.empty())
+	{
+		thread->ring.resize(PROFILE_RING_SIZE);  // Allocated on first use, so threads which are only named cost nothing.
+	}
+	thread->ring[thread->next] = ProfileEvent{name, start, end};
+	thread->next = (thread->next + 1) % PROFILE_RING_SIZE;
+	thread->count = std::min<size_t>(thread->count + 1, PROFILE_RING_SIZE);
+}
+
+bool wzProfileWriteTrace(const char *filename)
+{
+	auto microseconds = [](std::chrono::steady_clock::duration time) {
+		return std::chrono::duration<double, std::micro>(time).count();
+	};
+
+	std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	char buf[256];
+	unsigned count = profileThreadCount.load(std::memory_order_acquire);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		ProfileThread &thread = profileThreads[i];
+		std::lock_guard<wz::mutex> lock(thread.mutex);
+		if (thread.name != nullptr)
+		{
+			ssprintf(buf, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", i, thread.name);
+			out += buf;
+			first = false;
+		}
+		size_t start = (thread.next + PROFILE_RING_SIZE - thread.count) % PROFILE_RING_SIZE;
+		for (size_t n = 0; n < thread.count; ++n)
+		{
+			ProfileEvent const &event = thread.ring[(start + n) % PROFILE_RING_SIZE];
+			ssprintf(buf, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n", event.name, i, microseconds(event.start - profileEpoch), microseconds(event.end - event.start));
+			out += buf;
+			first = false;
+		}
+	}
+	out += "\n]}\n";
+
+	PHYSFS_file *fileHandle = PHYSFS_openWrite(filename);
+	if (fileHandle == nullptr)
+	{
+		debug(LOG_ERROR, "Could not open %s for writing: %s", filename, WZ_PHYSFS_getLastError());
+		return false;
+	}
+	bool ok = WZ_PHYSFS_writeBytes(fileHandle, out.data(), static_cast<PHYSFS_uint32>(out.size())) == static_cast<PHYSFS_sint64>(out.size());
+	PHYSFS_close(fileHandle);
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Could not write %s: %s", filename, WZ_PHYSFS_getLastError());
+	}
+	return ok;
+}
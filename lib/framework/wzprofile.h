@@ -0,0 +1,87 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  CPU zone profiler.
+ *
+ *  Code marks zones with WZ_PROFILE_ZONE("name"), which times the rest of the enclosing scope. While profiling, each
+ *  thread records its zones in its own ring buffer, keeping the most recent ones. The zones can then be written as a
+ *  Chrome trace (load it in chrome://tracing or https://ui.perfetto.dev). When not profiling, a zone costs a single
+ *  relaxed atomic load.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_WZPROFILE_H__
+#define __INCLUDED_LIB_FRAMEWORK_WZPROFILE_H__
+
+#include <atomic>
+#include <chrono>
+
+extern std::atomic<bool> wzProfileActive;
+
+/// Starts recording zones, discarding any previously recorded zones.
+void wzProfileStart();
+/// Stops recording zones.
+void wzProfileStop();
+static inline bool wzProfileEnabled()
+{
+	return wzProfileActive.load(std::memory_order_relaxed);
+}
+
+/// Names the calling thread in the trace. The name must be a string literal.
+void wzProfileThreadName(const char *name);
+
+/// Writes the recorded zones to a file in the write directory, as Chrome trace event JSON.
+bool wzProfileWriteTrace(const char *filename);
+
+/// Records a zone. The name must be a string literal.
+void wzProfileRecord(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+/// Records the time until going out of scope as a zone, if profiling.
+class WzProfileZone
+{
+public:
+	explicit WzProfileZone(const char *name)
+		: name(wzProfileEnabled() ? name : nullptr)
+	{
+		if (this->name != nullptr)
+		{
+			start = std::chrono::steady_clock::now();
+		}
+	}
+	~WzProfileZone()
+	{
+		if (name != nullptr)
+		{
+			wzProfileRecord(name, start, std::chrono::steady_clock::now());
+		}
+	}
+
+	WzProfileZone(WzProfileZone const &) = delete;
+	WzProfileZone &operator =(WzProfileZone const &) = delete;
+
+private:
+	const char *name;
+	std::chrono::steady_clock::time_point start;
+};
+
+#define WZ_PROFILE_CONCAT2(a, b) a##b
+#define WZ_PROFILE_CONCAT(a, b) WZ_PROFILE_CONCAT2(a, b)
+/// Times the rest of the enclosing scope as a zone called name.
+#define WZ_PROFILE_ZONE(name) WzProfileZone WZ_PROFILE_CONCAT(wzProfileZone_, __LINE__)(name)
+
+#endif // __INCLUDED_LIB_FRAMEWORK_WZPROFILE_H__
@@ -57,6 +57,8 @@ static uint32_t gameQueueTime[MAX_GAMEQUEUE_SLOTS];
 static uint32_t gameQueueCheckTime[MAX_GAMEQUEUE_SLOTS];
 static uint32_t gameQueueCheckCrc[MAX_GAMEQUEUE_SLOTS];
 static bool     crcError = false;
+static unsigned syncErrorCount = 0;
+static uint32_t firstSyncErrorTime = 0;
 
 static uint32_t updateReadyTime = 0;
 static uint32_t updateWantedTime = 0;
@@ -120,6 +122,8 @@ void gameTimeInit(void)
 
 	// Don't let syncDebug from previous games cause a desynch dump at gameTime 102.
 	crcError = false;
+	syncErrorCount = 0;
+	firstSyncErrorTime = 0;
 	resetSyncDebug();
 }
 
@@ -473,6 +477,10 @@ void recvPlayerGameTime(NETQUEUE queue)
 		{
 			debug(LOG_ERROR, "Found CRC error when receiving GAME_GAME_TIME for player: %" PRIu8 " (checkTime: %" PRIu32 ", checkCrc: %" PRIu16 ")", queue.index, checkTime, checkCrc);
 			crcError = true;
+			if (syncErrorCount++ == 0)
+			{
+				firstSyncErrorTime = checkTime;
+			}
 			if (NetPlay.players[queue.index].allocated)
 			{
 				NETsetPlayerConnectionStatus(CONNECTIONSTATUS_DESYNC, queue.index);
@@ -522,3 +530,13 @@ void setPlayerGameTime(unsigned player, uint32_t time)
 		gameQueueTime[player] = time;
 	}
 }
+
+unsigned gtimeSyncErrorCount()
+{
+	return syncErrorCount;
+}
+
+uint32_t gtimeFirstSyncErrorTime()
+{
+	return firstSyncErrorTime;
+}
@@ -205,4 +205,7 @@ void setPlayerGameTime(unsigned player, uint32_t time);   ///< Sets the player's
 
 bool gtimeShouldWaitForPlayer(unsigned player);
 
+unsigned gtimeSyncErrorCount();                           ///< Number of GAME_GAME_TIME CRCs which didn't match ours, since gameTimeInit().
+uint32_t gtimeFirstSyncErrorTime();                       ///< Game time of the first CRC which didn't match ours.
+
 #endif
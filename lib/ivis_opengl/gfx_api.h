@@ -217,12 +217,19 @@ namespace gfx_api
 		{}
 	};
 
+	enum class vertex_input_rate
+	{
+		per_vertex,
+		per_instance,
+	};
+
 	struct vertex_buffer
 	{
 		const std::size_t stride;
 		const std::vector<vertex_buffer_input> attributes;
-		vertex_buffer(std::size_t _stride, std::vector<vertex_buffer_input>&& _attributes)
-		: stride(_stride), attributes(std::forward<std::vector<vertex_buffer_input>>(_attributes))
+		const vertex_input_rate rate;
+		vertex_buffer(std::size_t _stride, std::vector<vertex_buffer_input>&& _attributes, vertex_input_rate _rate = vertex_input_rate::per_vertex)
+		: stride(_stride), attributes(std::forward<std::vector<vertex_buffer_input>>(_attributes)), rate(_rate)
 		{}
 	};
 
@@ -297,6 +304,7 @@ namespace gfx_api
 		virtual void set_uniforms(const size_t& first, const std::vector<std::tuple<const void*, size_t>>& uniform_blocks) = 0;
 		virtual void draw(const std::size_t& offset, const std::size_t&, const primitive_type&) = 0;
 		virtual void draw_elements(const std::size_t& offset, const std::size_t&, const primitive_type&, const index_type&) = 0;
+		virtual void draw_elements_instanced(const std::size_t& offset, const std::size_t&, const primitive_type&, const index_type&, const std::size_t& instance_count) = 0;
 		virtual void set_polygon_offset(const float& offset, const float& slope) = 0;
 		virtual void set_depth_range(const float& min, const float& max) = 0;
 		virtual int32_t get_context_value(const context_value property) = 0;
@@ -307,6 +315,7 @@ namespace gfx_api
 		virtual void debugSceneBegin(const char *descr) = 0;
 		virtual void debugSceneEnd(const char *descr) = 0;
 		virtual bool debugPerfAvailable() = 0;
+		virtual bool supportsInstancedRendering() = 0;
 		virtual bool debugPerfStart(size_t sample) = 0;
 		virtual void debugPerfStop() = 0;
 		virtual void debugPerfBegin(PERF_POINT pp, const char *descr) = 0;
@@ -347,6 +356,18 @@ namespace gfx_api
 		}
 	};
 
+	/**
+	 * Like vertex_buffer_description, but the attributes advance once per instance instead of once per vertex.
+	 */
+	template<std::size_t stride, typename... input_description>
+	struct instance_buffer_description
+	{
+		static vertex_buffer get_desc()
+		{
+			return { stride, { input_description::get_desc()...}, vertex_input_rate::per_instance };
+		}
+	};
+
 	template<std::size_t texture_unit, sampler_type sampler>
 	struct texture_description
 	{
@@ -436,6 +457,11 @@ namespace gfx_api
 		{
 			context::get().draw_elements(offset, count, primitive, index);
 		}
+
+		void draw_elements_instanced(const std::size_t& count, const std::size_t& offset, const std::size_t& instance_count)
+		{
+			context::get().draw_elements_instanced(offset, count, primitive, index, instance_count);
+		}
 	private:
 		pipeline_state_object* pso;
 		pipeline_state_helper()
@@ -475,6 +501,12 @@ namespace gfx_api
 	constexpr std::size_t color = 2;
 	constexpr std::size_t normal = 3;
 	constexpr std::size_t tangent = 4;
+	// Per-instance attributes of instanced 3D shapes. Each matrix takes 4 consecutive attribute locations.
+	constexpr std::size_t instance_modelViewMatrix = 5;
+	constexpr std::size_t instance_normalMatrix = 9;
+	constexpr std::size_t instance_colour = 13;
+	constexpr std::size_t instance_teamcolour = 14;
+	constexpr std::size_t instance_params = 15;
 
 	using notexture = std::tuple<>;
 
@@ -618,6 +650,52 @@ namespace gfx_api
 	texture_description<3, sampler_type::anisotropic> // specular map
 	>, shader>;
 
+	// Per-instance data of instanced 3D shapes, read as vertex attributes
+	struct Draw3DShapeInstanceData
+	{
+		glm::mat4 ModelViewMatrix;
+		glm::mat4 NormalMatrix;
+		glm::vec4 colour;
+		glm::vec4 teamcolour;
+		float shaderStretch;
+		float ecmState;
+		float alphaTest;
+		float unused;
+	};
+	static_assert(sizeof(Draw3DShapeInstanceData) == 176, "The instance attribute offsets of Draw3DShapeInstanced expect a tightly packed Draw3DShapeInstanceData");
+
+	// Draws many copies of the same mesh at once, taking Draw3DShapePerInstanceUniforms from an instance buffer instead
+	template<REND_MODE render_mode, SHADER_MODE shader>
+	using Draw3DShapeInstanced = typename gfx_api::pipeline_state_helper<rasterizer_state<render_mode, DEPTH_CMP_LEQ_WRT_ON, 255, polygon_offset::disabled, stencil_mode::stencil_disabled, cull_mode::back>, primitive_type::triangles, index_type::u16,
+	std::tuple<
+	Draw3DShapeGlobalUniforms,
+	Draw3DShapePerMeshUniforms
+	>,
+	std::tuple<
+	vertex_buffer_description<12, vertex_attribute_description<position, gfx_api::vertex_attribute_type::float3, 0>>,
+	vertex_buffer_description<12, vertex_attribute_description<normal, gfx_api::vertex_attribute_type::float3, 0>>,
+	vertex_buffer_description<8, vertex_attribute_description<texcoord, gfx_api::vertex_attribute_type::float2, 0>>,
+	vertex_buffer_description<16, vertex_attribute_description<tangent, gfx_api::vertex_attribute_type::float4, 0>>,
+	instance_buffer_description<sizeof(Draw3DShapeInstanceData),
+	vertex_attribute_description<instance_modelViewMatrix, gfx_api::vertex_attribute_type::float4, 0>,
+	vertex_attribute_description<instance_modelViewMatrix + 1, gfx_api::vertex_attribute_type::float4, 16>,
+	vertex_attribute_description<instance_modelViewMatrix + 2, gfx_api::vertex_attribute_type::float4, 32>,
+	vertex_attribute_description<instance_modelViewMatrix + 3, gfx_api::vertex_attribute_type::float4, 48>,
+	vertex_attribute_description<instance_normalMatrix, gfx_api::vertex_attribute_type::float4, 64>,
+	vertex_attribute_description<instance_normalMatrix + 1, gfx_api::vertex_attribute_type::float4, 80>,
+	vertex_attribute_description<instance_normalMatrix + 2, gfx_api::vertex_attribute_type::float4, 96>,
+	vertex_attribute_description<instance_normalMatrix + 3, gfx_api::vertex_attribute_type::float4, 112>,
+	vertex_attribute_description<instance_colour, gfx_api::vertex_attribute_type::float4, 128>,
+	vertex_attribute_description<instance_teamcolour, gfx_api::vertex_attribute_type::float4, 144>,
+	vertex_attribute_description<instance_params, gfx_api::vertex_attribute_type::float4, 160>>
+	>,
+	std::tuple<
+	texture_description<0, sampler_type::anisotropic>, // diffuse
+	texture_description<1, sampler_type::bilinear>, // team color mask
+	texture_description<2, sampler_type::anisotropic>, // normal map
+	texture_description<3, sampler_type::anisotropic> // specular map
+	>, shader>;
+
 	using Draw3DButtonPSO = Draw3DShape<REND_OPAQUE, SHADER_BUTTON>;
 	using Draw3DShapeOpaque = Draw3DShape<REND_OPAQUE, SHADER_COMPONENT>;
 	using Draw3DShapeAlpha = Draw3DShape<REND_ALPHA, SHADER_COMPONENT>;
@@ -627,6 +705,14 @@ namespace gfx_api
 	using Draw3DShapeNoLightAlpha = Draw3DShape<REND_ALPHA, SHADER_NOLIGHT>;
 	using Draw3DShapeNoLightPremul = Draw3DShape<REND_PREMULTIPLIED, SHADER_NOLIGHT>;
 	using Draw3DShapeNoLightAdditive = Draw3DShape<REND_ADDITIVE, SHADER_NOLIGHT>;
+	using Draw3DShapeInstancedOpaque = Draw3DShapeInstanced<REND_OPAQUE, SHADER_COMPONENT_INSTANCED>;
+	using Draw3DShapeInstancedAlpha = Draw3DShapeInstanced<REND_ALPHA, SHADER_COMPONENT_INSTANCED>;
+	using Draw3DShapeInstancedPremul = Draw3DShapeInstanced<REND_PREMULTIPLIED, SHADER_COMPONENT_INSTANCED>;
+	using Draw3DShapeInstancedAdditive = Draw3DShapeInstanced<REND_ADDITIVE, SHADER_COMPONENT_INSTANCED>;
+	using Draw3DShapeInstancedNoLightOpaque = Draw3DShapeInstanced<REND_OPAQUE, SHADER_NOLIGHT_INSTANCED>;
+	using Draw3DShapeInstancedNoLightAlpha = Draw3DShapeInstanced<REND_ALPHA, SHADER_NOLIGHT_INSTANCED>;
+	using Draw3DShapeInstancedNoLightPremul = Draw3DShapeInstanced<REND_PREMULTIPLIED, SHADER_NOLIGHT_INSTANCED>;
+	using Draw3DShapeInstancedNoLightAdditive = Draw3DShapeInstanced<REND_ADDITIVE, SHADER_NOLIGHT_INSTANCED>;
 
 	template<>
 	struct constant_buffer_type<SHADER_GENERIC_COLOR>
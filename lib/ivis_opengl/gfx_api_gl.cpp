@@ -325,6 +325,20 @@ static const std::map<SHADER_MODE, program_data> shader_to_file_table =
 			// per-instance uniforms
 			"ModelViewMatrix", "NormalMatrix", "colour", "teamcolour", "stretch", "ecmEffect", "alphaTest"
 		} }),
+	std::make_pair(SHADER_COMPONENT_INSTANCED, program_data{ "Instanced component program", "shaders/tcmask_instanced.vert", "shaders/tcmask_instanced.frag",
+		{
+			// per-frame global uniforms
+			"ProjectionMatrix", "lightPosition", "sceneColor", "ambient", "diffuse", "specular", "fogColor", "fogEnd", "fogStart", "graphicsCycle", "fogEnabled",
+			// per-mesh uniforms
+			"tcmask", "normalmap", "specularmap", "hasTangents"
+		} }),
+	std::make_pair(SHADER_NOLIGHT_INSTANCED, program_data{ "Instanced plain program", "shaders/nolight_instanced.vert", "shaders/nolight_instanced.frag",
+		{
+			// per-frame global uniforms
+			"ProjectionMatrix", "lightPosition", "sceneColor", "ambient", "diffuse", "specular", "fogColor", "fogEnd", "fogStart", "graphicsCycle", "fogEnabled",
+			// per-mesh uniforms
+			"tcmask", "normalmap", "specularmap", "hasTangents"
+		} }),
 	std::make_pair(SHADER_TERRAIN, program_data{ "terrain program", "shaders/terrain_water.vert", "shaders/terrain.frag",
 		{ "ModelViewProjectionMatrix", "paramx1", "paramy1", "paramx2", "paramy2", "tex", "lightmap_tex", "textureMatrix1", "textureMatrix2",
 			"fogColor", "fogEnabled", "fogEnd", "fogStart" } }),
@@ -923,6 +937,11 @@ void gl_pipeline_state_object::build_program(bool fragmentHighpFloatAvailable, b
 	glBindAttribLocation(program, 2, "vertexColor");
 	glBindAttribLocation(program, 3, "vertexNormal");
 	glBindAttribLocation(program, 4, "vertexTangent");
+	glBindAttribLocation(program, static_cast<GLuint>(gfx_api::instance_modelViewMatrix), "instanceModelViewMatrix");
+	glBindAttribLocation(program, static_cast<GLuint>(gfx_api::instance_normalMatrix), "instanceNormalMatrix");
+	glBindAttribLocation(program, static_cast<GLuint>(gfx_api::instance_colour), "instanceColour");
+	glBindAttribLocation(program, static_cast<GLuint>(gfx_api::instance_teamcolour), "instanceTeamcolour");
+	glBindAttribLocation(program, static_cast<GLuint>(gfx_api::instance_params), "instanceParams");
 	ASSERT_OR_RETURN(, program, "Could not create shader program!");
 
 	char* vertexShaderContents = nullptr;
@@ -1431,6 +1450,18 @@ inline void gl_context::disableVertexAttribArray(GLuint index)
 	glDisableVertexAttribArray(index);
 	ASSERT(enabledVertexAttribIndexes.size() >= static_cast<size_t>(index), "Insufficient room in enabledVertexAttribIndexes for: %u", (unsigned int) index);
 	enabledVertexAttribIndexes[static_cast<size_t>(index)] = false;
+	setVertexAttribDivisor(index, 0);
+}
+
+inline void gl_context::setVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+	// Only touch the divisor when it changes, so that contexts without instancing never call glVertexAttribDivisor
+	ASSERT_OR_RETURN(, instancedVertexAttribIndexes.size() > static_cast<size_t>(index), "Insufficient room in instancedVertexAttribIndexes for: %u", (unsigned int) index);
+	if (instancedVertexAttribIndexes[static_cast<size_t>(index)] != (divisor != 0))
+	{
+		glVertexAttribDivisor(index, divisor);
+		instancedVertexAttribIndexes[static_cast<size_t>(index)] = (divisor != 0);
+	}
 }
 
 void gl_context::bind_vertex_buffers(const std::size_t& first, const std::vector<std::tuple<gfx_api::buffer*, std::size_t>>& vertex_buffers_offset)
@@ -1450,6 +1481,11 @@ void gl_context::bind_vertex_buffers(const std::size_t& first, const std::vector
 		{
 			enableVertexAttribArray(static_cast<GLuint>(attribute.id));
 			glVertexAttribPointer(static_cast<GLuint>(attribute.id), get_size(attribute.type), get_type(attribute.type), get_normalisation(attribute.type), static_cast<GLsizei>(buffer_desc.stride), reinterpret_cast<void*>(attribute.offset + std::get<1>(vertex_buffers_offset[i])));
+			if (buffer_desc.rate == gfx_api::vertex_input_rate::per_instance)
+			{
+				ASSERT(instancedRendering, "Per-instance vertex buffer bound, but instanced rendering is not supported");
+				setVertexAttribDivisor(static_cast<GLuint>(attribute.id), 1);
+			}
 		}
 	}
 }
@@ -1599,6 +1635,14 @@ void gl_context::draw_elements(const size_t& offset, const size_t &count, const
 	glDrawElements(to_gl(primitive), static_cast<GLsizei>(count), to_gl(index), reinterpret_cast<void*>(offset));
 }
 
+void gl_context::draw_elements_instanced(const size_t& offset, const size_t &count, const gfx_api::primitive_type &primitive, const gfx_api::index_type& index, const size_t& instance_count)
+{
+	ASSERT_OR_RETURN(, instancedRendering, "Instanced rendering is not supported");
+	ASSERT(count <= static_cast<size_t>(std::numeric_limits<GLsizei>::max()), "count (%zu) exceeds GLsizei max", count);
+	ASSERT(instance_count <= static_cast<size_t>(std::numeric_limits<GLsizei>::max()), "instance_count (%zu) exceeds GLsizei max", instance_count);
+	glDrawElementsInstanced(to_gl(primitive), static_cast<GLsizei>(count), to_gl(index), reinterpret_cast<void*>(offset), static_cast<GLsizei>(instance_count));
+}
+
 void gl_context::set_polygon_offset(const float& offset, const float& slope)
 {
 	glPolygonOffset(offset, slope);
@@ -1654,6 +1698,11 @@ bool gl_context::debugPerfAvailable()
 	return GLAD_GL_ARB_timer_query;
 }
 
+bool gl_context::supportsInstancedRendering()
+{
+	return instancedRendering;
+}
+
 bool gl_context::debugPerfStart(size_t sample)
 {
 	if (GLAD_GL_ARB_timer_query)
@@ -2016,6 +2065,43 @@ bool gl_context::isBlocklistedGraphicsDriver() const
 	return false;
 }
 
+bool gl_context::initInstancedRendering(GLADloadproc func_GLGetProcAddress, const std::vector<std::string>& glExtensions, GLint maxVertexAttribs)
+{
+	// The instanced shaders need GLSL 1.50 / GLSL ES 3.00, and their per-instance attributes use locations up to instance_params
+	if (maxVertexAttribs <= static_cast<GLint>(gfx_api::instance_params))
+	{
+		return false;
+	}
+	if (gles)
+	{
+		// Loaded by glad as part of OpenGL ES 3.0
+		return GLAD_GL_ES_VERSION_3_0 && glDrawElementsInstanced && glVertexAttribDivisor;
+	}
+	if (getMaximumShaderVersionForCurrentGLContext(VERSION_120, VERSION_150_CORE) < VERSION_150_CORE)
+	{
+		return false;
+	}
+
+	// glad only loads OpenGL up to 3.0, so fetch the entry points of OpenGL 3.3 / GL_ARB_instanced_arrays here
+	auto hasExtension = [&glExtensions](const char *name) {
+		return std::find(glExtensions.begin(), glExtensions.end(), name) != glExtensions.end();
+	};
+	GLint gl_majorversion = wz_GetGLIntegerv(GL_MAJOR_VERSION, 0);
+	GLint gl_minorversion = wz_GetGLIntegerv(GL_MINOR_VERSION, 0);
+	if ((gl_majorversion > 3) || ((gl_majorversion == 3) && (gl_minorversion >= 3)))
+	{
+		glad_glDrawElementsInstanced = reinterpret_cast<PFNGLDRAWELEMENTSINSTANCEDPROC>(func_GLGetProcAddress("glDrawElementsInstanced"));
+		glad_glVertexAttribDivisor = reinterpret_cast<PFNGLVERTEXATTRIBDIVISORPROC>(func_GLGetProcAddress("glVertexAttribDivisor"));
+	}
+	else if (hasExtension("GL_ARB_instanced_arrays"))
+	{
+		// OpenGL 3.2 has glDrawElementsInstanced, but needs the extension for the divisor
+		glad_glDrawElementsInstanced = reinterpret_cast<PFNGLDRAWELEMENTSINSTANCEDPROC>(func_GLGetProcAddress("glDrawElementsInstanced"));
+		glad_glVertexAttribDivisor = reinterpret_cast<PFNGLVERTEXATTRIBDIVISORPROC>(func_GLGetProcAddress("glVertexAttribDivisorARB"));
+	}
+	return glDrawElementsInstanced != nullptr && glVertexAttribDivisor != nullptr;
+}
+
 bool gl_context::initGLContext()
 {
 	frameNum = 1;
@@ -2208,6 +2294,10 @@ bool gl_context::initGLContext()
 		glmaxVertexAttribs = 8;
 	}
 	enabledVertexAttribIndexes.resize(static_cast<size_t>(glmaxVertexAttribs), false);
+	instancedVertexAttribIndexes.resize(static_cast<size_t>(glmaxVertexAttribs), false);
+
+	instancedRendering = initInstancedRendering(func_GLGetProcAddress, glExtensions, glmaxVertexAttribs);
+	debug(LOG_3D, "  * Instanced rendering %s supported.", instancedRendering ? "is" : "is NOT");
 
 	if (khr_debug)
 	{
@@ -200,6 +200,7 @@ struct gl_context final : public gfx_api::context
 	virtual void set_uniforms(const size_t& first, const std::vector<std::tuple<const void*, size_t>>& uniform_blocks) override;
 	virtual void draw(const size_t& offset, const size_t &count, const gfx_api::primitive_type &primitive) override;
 	virtual void draw_elements(const size_t& offset, const size_t &count, const gfx_api::primitive_type &primitive, const gfx_api::index_type& index) override;
+	virtual void draw_elements_instanced(const size_t& offset, const size_t &count, const gfx_api::primitive_type &primitive, const gfx_api::index_type& index, const size_t& instance_count) override;
 	virtual void set_polygon_offset(const float& offset, const float& slope) override;
 	virtual void set_depth_range(const float& min, const float& max) override;
 	virtual int32_t get_context_value(const context_value property) override;
@@ -209,6 +210,7 @@ struct gl_context final : public gfx_api::context
 	virtual void debugSceneBegin(const char *descr) override;
 	virtual void debugSceneEnd(const char *descr) override;
 	virtual bool debugPerfAvailable() override;
+	virtual bool supportsInstancedRendering() override;
 	virtual bool debugPerfStart(size_t sample) override;
 	virtual void debugPerfStop() override;
 	virtual void debugPerfBegin(PERF_POINT pp, const char *descr) override;
@@ -226,12 +228,16 @@ private:
 	virtual bool _initialize(const gfx_api::backend_Impl_Factory& impl, int32_t antialiasing, swap_interval_mode mode) override;
 private:
 	bool initGLContext();
+	bool initInstancedRendering(GLADloadproc func_GLGetProcAddress, const std::vector<std::string>& glExtensions, GLint maxVertexAttribs);
 	void enableVertexAttribArray(GLuint index);
 	void disableVertexAttribArray(GLuint index);
+	void setVertexAttribDivisor(GLuint index, GLuint divisor);
 	std::string calculateFormattedRendererInfoString() const;
 	bool isBlocklistedGraphicsDriver() const;
 
 	std::vector<bool> enabledVertexAttribIndexes;
+	std::vector<bool> instancedVertexAttribIndexes;  ///< Attributes with a non-zero divisor.
+	bool instancedRendering = false;
 	size_t frameNum = 0;
 	std::string formattedRendererInfoString;
 };
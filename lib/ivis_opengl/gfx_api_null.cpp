@@ -224,6 +224,11 @@ void null_context::draw_elements(const size_t& offset, const size_t &count, cons
 	// no-op
 }
 
+void null_context::draw_elements_instanced(const size_t& offset, const size_t &count, const gfx_api::primitive_type &primitive, const gfx_api::index_type& index, const size_t& instance_count)
+{
+	// no-op
+}
+
 void null_context::set_polygon_offset(const float& offset, const float& slope)
 {
 	// no-op
@@ -274,6 +279,11 @@ bool null_context::debugPerfAvailable()
 	return false;
 }
 
+bool null_context::supportsInstancedRendering()
+{
+	return false;
+}
+
 bool null_context::debugPerfStart(size_t sample)
 {
 	return false;
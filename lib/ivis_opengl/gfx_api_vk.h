@@ -496,6 +496,7 @@ public:
 
 	virtual void draw(const std::size_t& offset, const std::size_t& count, const gfx_api::primitive_type&) override;
 	virtual void draw_elements(const std::size_t& offset, const std::size_t& count, const gfx_api::primitive_type&, const gfx_api::index_type&) override;
+	virtual void draw_elements_instanced(const std::size_t& offset, const std::size_t& count, const gfx_api::primitive_type&, const gfx_api::index_type&, const std::size_t& instance_count) override;
 	virtual void bind_vertex_buffers(const std::size_t& first, const std::vector<std::tuple<gfx_api::buffer*, std::size_t>>& vertex_buffers_offset) override;
 	virtual void unbind_vertex_buffers(const std::size_t& first, const std::vector<std::tuple<gfx_api::buffer*, std::size_t>>& vertex_buffers_offset) override;
 	virtual void disable_all_vertex_buffers() override;
@@ -571,6 +572,7 @@ public:
 	virtual void debugSceneBegin(const char *descr) override;
 	virtual void debugSceneEnd(const char *descr) override;
 	virtual bool debugPerfAvailable() override;
+	virtual bool supportsInstancedRendering() override;
 	virtual bool debugPerfStart(size_t sample) override;
 	virtual void debugPerfStop() override;
 	virtual void debugPerfBegin(PERF_POINT pp, const char *descr) override;
@@ -38,6 +38,13 @@
 
 struct iIMDShape;
 
+/** How stencil shadow volumes are kept between frames. */
+enum class SHADOW_CACHE
+{
+	frame,          ///< Volumes are only reused within a frame, for exactly the same light.
+	persistent,     ///< Volumes are kept for a while after their last use, and missing ones are built on several threads.
+};
+
 /***************************************************************************/
 /*
  *	Global ProtoTypes
@@ -45,17 +52,27 @@ struct iIMDShape;
 /***************************************************************************/
 bool pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int pieFlag, int pieFlagData, const glm::mat4 &modelView);
 
-void pie_GetResetCounts(size_t *pPieCount, size_t *pPolyCount);
+/** Returns and resets the number of shapes, polygons and shape draw calls since the last call. With instanced rendering, a draw call can draw many shapes. */
+void pie_GetResetCounts(size_t *pPieCount, size_t *pPolyCount, size_t *pDrawCount);
 
 /** Setup stencil shadows and OpenGL lighting. */
 void pie_BeginLighting(const Vector3f &light);
 void pie_setShadows(bool drawShadows);
+void pie_setShadowCache(SHADOW_CACHE mode);
+SHADOW_CACHE pie_getShadowCache();
+/** Forgets all cached shadow volumes. Must be called before freeing any models. */
+void pie_ClearShadowCache();
 
 /** Set light parameters */
 void pie_InitLighting();
 void pie_Lighting0(LIGHTING_TYPE entry, const float value[4]);
 
-void pie_RemainingPasses(uint64_t currentGameFrame);
+/** Draws the queued opaque shapes. */
+void pie_DrawOpaqueShapes();
+/** Draws the shadows of the queued opaque shapes, if shadows are enabled. */
+void pie_DrawShadows(uint64_t currentGameFrame);
+/** Draws the queued translucent shapes, and empties the queues. */
+void pie_DrawTranslucentShapes();
 
 void pie_CleanUp();
 
@@ -23,8 +23,12 @@
 
 #include <unordered_map>
 #include <string.h>
+#include <atomic>
+#include <thread>
 
 #include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/framework/wzprofile.h"
 #include "lib/ivis_opengl/ivisdef.h"
 #include "lib/ivis_opengl/imd.h"
 #include "lib/ivis_opengl/piefunc.h"
@@ -47,6 +51,13 @@
 
 #define BUFFER_OFFSET(i) (reinterpret_cast<char *>(i))
 #define SHADOW_END_DISTANCE (8000*8000) // Keep in sync with lighting.c:FOG_END
+/// Flags which change how a queued shape is drawn. Shapes which only differ in other flags can share an instanced draw.
+#define pie_DRAW_STATE_FLAGS (pie_ECM | pie_TRANSLUCENT | pie_ADDITIVE | pie_FORCE_FOG | pie_PREMULTIPLIED)
+#define INSTANCE_BUFFER_MIN_SIZE 256  ///< Smallest number of instances an instance buffer is allocated for.
+#define SHADOW_LIGHT_QUANTUM 16.f     ///< With a persistent shadow cache, model space lights are rounded to multiples of this. The sun is 4096 long.
+#define SHADOW_CACHE_KEEP_FRAMES 30   ///< Frames a shadow volume is kept after its last use, with a persistent shadow cache.
+#define SHADOW_MAX_THREADS 4          ///< Most threads building shadow volumes, besides the main thread.
+#define SHADOW_PARALLEL_MIN_JOBS 8    ///< Fewer missing shadow volumes than this are built on the main thread only.
 
 /*
  *	Local Variables
@@ -54,7 +65,9 @@
 
 static size_t pieCount = 0;
 static size_t polyCount = 0;
+static size_t drawCount = 0;
 static bool shadows = false;
+static SHADOW_CACHE shadowCacheMode = SHADOW_CACHE::persistent;
 static gfx_api::gfxFloat lighting0[LIGHT_MAX][4];
 static gfx_api::gfxFloat lightingDefault[LIGHT_MAX][4];
 
@@ -89,6 +102,16 @@ void pie_setShadows(bool drawShadows)
 	shadows = drawShadows;
 }
 
+void pie_setShadowCache(SHADOW_CACHE mode)
+{
+	shadowCacheMode = mode;
+}
+
+SHADOW_CACHE pie_getShadowCache()
+{
+	return shadowCacheMode;
+}
+
 static Vector3f currentSunPosition(0.f, 0.f, 0.f);
 
 void pie_BeginLighting(const Vector3f &light)
@@ -187,6 +210,7 @@ static void pie_Draw3DButton(iIMDShape *shape, PIELIGHT teamcolour, const glm::m
 	gfx_api::context::get().bind_index_buffer(*shape->buffers[VBO_INDEX], gfx_api::index_type::u16);
 	gfx_api::Draw3DShapeOpaque::get().draw_elements(shape->polys.size() * 3, 0);
 	polyCount += shape->polys.size();
+	++drawCount;
 	gfx_api::Draw3DShapeOpaque::get().unbind_vertex_buffers(shape->buffers[VBO_VERTEX], shape->buffers[VBO_NORMAL], shape->buffers[VBO_TEXCOORD], pTangentBuffer);
 	gfx_api::context::get().unbind_index_buffer(*shape->buffers[VBO_INDEX]);
 }
@@ -404,12 +428,200 @@ static templatedState pie_Draw3DShape2(const templatedState &lastState, ShaderOn
 	}
 
 	polyCount += shape->polys.size();
+	++drawCount;
 
 	pie_SetShaderEcmEffect(false);
 
 	return currentState;
 }
 
+/***************************************************************************
+ * Instanced drawing
+ *
+ * When the backend supports it, the queued shapes are grouped into batches
+ * which share a mesh, animation frame and draw state, and each batch is
+ * drawn with a single instanced draw call. The per-instance uniforms of all
+ * batches are uploaded into one instance buffer per pass.
+ ***************************************************************************/
+
+struct InstancedBatch
+{
+	const SHAPE *shape;    ///< First shape of the batch. All the others share its mesh, frame and draw state.
+	size_t firstInstance;  ///< Index of the first instance in instanceData.
+	size_t instanceCount;
+};
+
+static std::vector<gfx_api::Draw3DShapeInstanceData> instanceData;
+static std::vector<InstancedBatch> opaqueBatches;
+static std::vector<InstancedBatch> translucentBatches;
+// A buffer may only be uploaded once per frame, so each pie_DrawOpaqueShapes() in a frame gets its own one.
+static std::vector<gfx_api::buffer *> instanceBuffers;
+static size_t instanceBuffersUsed = 0;
+static size_t instanceBuffersFrame = 0;
+
+static inline int pie_ShapeFrame(SHAPE const &shape)
+{
+	return shape.frame % std::max<int>(1, shape.shape->numFrames);
+}
+
+static inline bool pie_SameInstancedBatch(SHAPE const &a, SHAPE const &b)
+{
+	return a.shape == b.shape && pie_ShapeFrame(a) == pie_ShapeFrame(b) && (a.flag & pie_DRAW_STATE_FLAGS) == (b.flag & pie_DRAW_STATE_FLAGS);
+}
+
+/// The same per-instance values as pie_Draw3DShape2() sets as uniforms.
+static gfx_api::Draw3DShapeInstanceData pie_InstanceData(SHAPE const &shape)
+{
+	PIELIGHT colour = shape.colour;
+	if (shape.flag & (pie_ADDITIVE | pie_TRANSLUCENT))
+	{
+		colour.byte.a = (UBYTE)shape.flag_data;
+	}
+	return gfx_api::Draw3DShapeInstanceData {
+		shape.matrix,
+		glm::transpose(glm::inverse(shape.matrix)),
+		pal_PIELIGHTtoVec4(colour), pal_PIELIGHTtoVec4(shape.teamcolour),
+		shape.stretch, (shape.flag & pie_ECM) ? 1.f : 0.f, (shape.flag & pie_PREMULTIPLIED) ? 0.f : 1.f, 0.f
+	};
+}
+
+/// Groups runs of consecutive shapes which can be drawn together, appending their instance data to instanceData.
+static void pie_BuildInstancedBatches(std::vector<SHAPE> const &queue, std::vector<InstancedBatch> &batches)
+{
+	batches.clear();
+	for (SHAPE const &shape : queue)
+	{
+		if (batches.empty() || !pie_SameInstancedBatch(*batches.back().shape, shape))
+		{
+			batches.push_back(InstancedBatch{&shape, instanceData.size(), 0});
+		}
+		instanceData.push_back(pie_InstanceData(shape));
+		++batches.back().instanceCount;
+	}
+}
+
+static gfx_api::buffer *pie_UploadInstanceData()
+{
+	size_t frameNum = gfx_api::context::get().current_FrameNum();
+	if (frameNum != instanceBuffersFrame)
+	{
+		instanceBuffersFrame = frameNum;
+		instanceBuffersUsed = 0;
+	}
+	if (instanceBuffersUsed == instanceBuffers.size())
+	{
+		instanceBuffers.push_back(gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::stream_draw));
+	}
+	gfx_api::buffer *buffer = instanceBuffers[instanceBuffersUsed++];
+
+	// Round the size up, so that the buffer isn't reallocated whenever the number of shapes changes
+	size_t capacity = INSTANCE_BUFFER_MIN_SIZE;
+	while (capacity < instanceData.size())
+	{
+		capacity *= 2;
+	}
+	instanceData.resize(capacity);
+	buffer->upload(capacity * sizeof(gfx_api::Draw3DShapeInstanceData), instanceData.data());
+	return buffer;
+}
+
+static gfx_api::Draw3DShapeGlobalUniforms pie_InstancedGlobalUniforms()
+{
+	const auto &renderState = getCurrentRenderState();
+	const glm::vec4 fogColor = renderState.fogEnabled ? glm::vec4(
+		renderState.fogColour.vector[0] / 255.f,
+		renderState.fogColour.vector[1] / 255.f,
+		renderState.fogColour.vector[2] / 255.f,
+		renderState.fogColour.vector[3] / 255.f
+	) : glm::vec4(0.f);
+
+	return gfx_api::Draw3DShapeGlobalUniforms {
+		pie_PerspectiveGet(),
+		glm::vec4(currentSunPosition, 0.f),
+		glm::vec4(lighting0[LIGHT_EMISSIVE][0], lighting0[LIGHT_EMISSIVE][1], lighting0[LIGHT_EMISSIVE][2], lighting0[LIGHT_EMISSIVE][3]),
+		glm::vec4(lighting0[LIGHT_AMBIENT][0], lighting0[LIGHT_AMBIENT][1], lighting0[LIGHT_AMBIENT][2], lighting0[LIGHT_AMBIENT][3]),
+		glm::vec4(lighting0[LIGHT_DIFFUSE][0], lighting0[LIGHT_DIFFUSE][1], lighting0[LIGHT_DIFFUSE][2], lighting0[LIGHT_DIFFUSE][3]),
+		glm::vec4(lighting0[LIGHT_SPECULAR][0], lighting0[LIGHT_SPECULAR][1], lighting0[LIGHT_SPECULAR][2], lighting0[LIGHT_SPECULAR][3]),
+		fogColor,
+		renderState.fogBegin, renderState.fogEnd, pie_GetShaderTime(), renderState.fogEnabled
+	};
+}
+
+template<typename PSO>
+static void draw3dShapeInstanced(ShaderOnce& globalsOnce, const gfx_api::Draw3DShapeGlobalUniforms &globalUniforms, const iIMDShape *shape, int frame, gfx_api::buffer *instanceBuffer, InstancedBatch const &batch)
+{
+	auto* tcmask = shape->tcmaskpage != iV_TEX_INVALID ? &pie_Texture(shape->tcmaskpage) : nullptr;
+	auto* normalmap = shape->normalpage != iV_TEX_INVALID ? &pie_Texture(shape->normalpage) : nullptr;
+	auto* specularmap = shape->specularpage != iV_TEX_INVALID ? &pie_Texture(shape->specularpage) : nullptr;
+
+	gfx_api::Draw3DShapePerMeshUniforms meshUniforms {
+		tcmask ? 1 : 0, normalmap != nullptr, specularmap != nullptr, shape->buffers[VBO_TANGENT] != nullptr
+	};
+
+	gfx_api::buffer* pTangentBuffer = (shape->buffers[VBO_TANGENT] != nullptr) ? shape->buffers[VBO_TANGENT] : getZeroedVertexBuffer(shape->vertexCount * 4 * sizeof(gfx_api::gfxFloat));
+
+	PSO::get().bind();
+	globalsOnce.perform_once<PSO>([&globalUniforms]{
+		PSO::get().set_uniforms_at(0, globalUniforms);
+	});
+	PSO::get().set_uniforms_at(1, meshUniforms);
+	PSO::get().bind_textures(&pie_Texture(shape->texpage), tcmask, normalmap, specularmap);
+	gfx_api::context::get().bind_vertex_buffers(0, {
+		std::make_tuple(shape->buffers[VBO_VERTEX], 0), std::make_tuple(shape->buffers[VBO_NORMAL], 0), std::make_tuple(shape->buffers[VBO_TEXCOORD], 0), std::make_tuple(pTangentBuffer, 0),
+		std::make_tuple(instanceBuffer, batch.firstInstance * sizeof(gfx_api::Draw3DShapeInstanceData))
+	});
+	gfx_api::context::get().bind_index_buffer(*shape->buffers[VBO_INDEX], gfx_api::index_type::u16);
+	PSO::get().draw_elements_instanced(shape->polys.size() * 3, frame * shape->polys.size() * 3 * sizeof(uint16_t), batch.instanceCount);
+}
+
+template<typename AdditivePSO, typename AlphaPSO, typename PremultipliedPSO, typename OpaquePSO>
+static void draw3dShapeInstancedTemplated(ShaderOnce& globalsOnce, const gfx_api::Draw3DShapeGlobalUniforms &globalUniforms, const iIMDShape *shape, int pieFlag, int frame, gfx_api::buffer *instanceBuffer, InstancedBatch const &batch)
+{
+	if (pieFlag & pie_ADDITIVE)
+	{
+		draw3dShapeInstanced<AdditivePSO>(globalsOnce, globalUniforms, shape, frame, instanceBuffer, batch);
+	}
+	else if (pieFlag & pie_TRANSLUCENT)
+	{
+		draw3dShapeInstanced<AlphaPSO>(globalsOnce, globalUniforms, shape, frame, instanceBuffer, batch);
+	}
+	else if (pieFlag & pie_PREMULTIPLIED)
+	{
+		draw3dShapeInstanced<PremultipliedPSO>(globalsOnce, globalUniforms, shape, frame, instanceBuffer, batch);
+	}
+	else
+	{
+		draw3dShapeInstanced<OpaquePSO>(globalsOnce, globalUniforms, shape, frame, instanceBuffer, batch);
+	}
+}
+
+static void pie_DrawInstancedBatches(ShaderOnce& globalsOnce, std::vector<InstancedBatch> const &batches, gfx_api::buffer *instanceBuffer)
+{
+	for (InstancedBatch const &batch : batches)
+	{
+		const iIMDShape *shape = batch.shape->shape;
+		const int pieFlag = batch.shape->flag;
+
+		// Same fog and lighting choices as pie_Draw3DShape2()
+		const bool translucent = pieFlag & (pie_ADDITIVE | pie_TRANSLUCENT | pie_PREMULTIPLIED);
+		pie_SetFogStatus(!translucent || (pieFlag & pie_FORCE_FOG));
+		const bool light = !translucent || (pieFlag & pie_ECM);
+
+		const gfx_api::Draw3DShapeGlobalUniforms globalUniforms = pie_InstancedGlobalUniforms();
+		if (light)
+		{
+			draw3dShapeInstancedTemplated<gfx_api::Draw3DShapeInstancedAdditive, gfx_api::Draw3DShapeInstancedAlpha, gfx_api::Draw3DShapeInstancedPremul, gfx_api::Draw3DShapeInstancedOpaque>(globalsOnce, globalUniforms, shape, pieFlag, pie_ShapeFrame(*batch.shape), instanceBuffer, batch);
+		}
+		else
+		{
+			draw3dShapeInstancedTemplated<gfx_api::Draw3DShapeInstancedNoLightAdditive, gfx_api::Draw3DShapeInstancedNoLightAlpha, gfx_api::Draw3DShapeInstancedNoLightPremul, gfx_api::Draw3DShapeInstancedNoLightOpaque>(globalsOnce, globalUniforms, shape, pieFlag, pie_ShapeFrame(*batch.shape), instanceBuffer, batch);
+		}
+
+		polyCount += shape->polys.size() * batch.instanceCount;
+		++drawCount;
+	}
+}
+
 static inline bool edgeLessThan(EDGE const &e1, EDGE const &e2)
 {
 	if (e1.from != e2.from)
@@ -572,7 +784,8 @@ struct ShadowCache {
 		_currentFrame = currentFrame;
 	}
 
-	size_t removeUnused()
+	/// Removes the volumes which weren't used in the last keepFrames frames.
+	size_t removeUnused(uint64_t keepFrames)
 	{
 		std::vector<ShapeMap::iterator> unusedShapes;
 		size_t oldItemsRemoved = 0;
@@ -581,7 +794,7 @@ struct ShadowCache {
 			std::vector<ShadowDrawParametersToCachedDataMap::iterator> unusedBuffersForShape;
 			for (auto it_shadowDrawParams = it_shape->second.begin(); it_shadowDrawParams != it_shape->second.end(); ++it_shadowDrawParams)
 			{
-				if (it_shadowDrawParams->second.lastQueriedFrameCount != _currentFrame)
+				if (_currentFrame - it_shadowDrawParams->second.lastQueriedFrameCount >= keepFrames)
 				{
 					unusedBuffersForShape.push_back(it_shadowDrawParams);
 				}
@@ -603,124 +816,236 @@ struct ShadowCache {
 		}
 		return oldItemsRemoved;
 	}
+
+	void clear()
+	{
+		shapeMap.clear();
+	}
 private:
 	uint64_t _currentFrame = 0;
 	ShapeMap shapeMap;
 	std::vector<Vector3f> vertexes;
 };
 
-enum DrawShadowResult {
-	DRAW_SUCCESS_CACHED,
-	DRAW_SUCCESS_UNCACHED
+static ShadowCache shadowCache;
+
+void pie_ClearShadowCache()
+{
+	shadowCache.clear();
+}
+
+/// Scratch space for building shadow volumes, one per thread, to save allocations.
+struct ShadowBuildScratch
+{
+	std::vector<EDGE> edgelist;
+	std::vector<EDGE> edgelistFlipped;
+	std::vector<EDGE> edgelistFiltered;
 };
 
-/// Draw the shadow for a shape
-/// Prequisite:
-///		Caller must call the following before all calls to pie_DrawShadow():
-///			const auto &program = pie_ActivateShader(SHADER_GENERIC_COLOR, pie_PerspectiveGet(), glm::vec4());
-///			glEnableVertexAttribArray(program.locVertex);
-///		and must call the following after all calls to pie_DrawShadow():
-///			glDisableVertexAttribArray(program.locVertex);
-///			pie_DeactivateShader();
-///		The only place this is currently called is pie_ShadowDrawLoop(), which handles this properly.
-static inline DrawShadowResult pie_DrawShadow(ShadowCache &shadowCache, iIMDShape *shape, int flag, int flag_data, const glm::vec4 &light, const glm::mat4 &modelViewMatrix)
-{
-	static std::vector<EDGE> edgelist;  // Static, to save allocations.
-	static std::vector<EDGE> edgelistFlipped;  // Static, to save allocations.
-	static std::vector<EDGE> edgelistFiltered;  // Static, to save allocations.
-	EDGE *drawlist = nullptr;
+/// A shadow volume missing from the cache.
+struct ShadowBuildJob
+{
+	iIMDShape *shape;
+	int flag;
+	int flag_data;
+	glm::vec4 light;
+	ShadowCache::CachedShadowData *cache;  ///< Cache entry to fill in. Entries don't move when others are added.
+	std::vector<EDGE> staticEdges;         ///< Silhouette to store in the shape afterwards, if pie_STATIC_SHADOW.
+};
 
+static std::vector<ShadowBuildJob> shadowJobs;
+static std::atomic<size_t> shadowJobNext(0);  ///< Next job for a thread to pick up.
+static ShadowBuildScratch shadowMainScratch;
+static std::vector<WZ_THREAD *> shadowThreads;
+static WZ_SEMAPHORE *shadowStart = nullptr;
+static WZ_SEMAPHORE *shadowDone = nullptr;
+static volatile bool shadowQuit = false;
+
+/// Builds the shadow volume of a job, in model space.
+/// Only reads the shape, so may run on several threads at once. Silhouettes of pie_STATIC_SHADOW shapes are left in
+/// job.staticEdges, for the main thread to store.
+static void pie_BuildShadowVolume(ShadowBuildJob &job, ShadowBuildScratch &scratch)
+{
+	const iIMDShape *shape = job.shape;
+	const int flag = job.flag;
+	const int flag_data = job.flag_data;
+	const glm::vec4 &light = job.light;
+	const EDGE *drawlist = nullptr;
 	size_t edge_count;
-	DrawShadowResult result;
 
-	// Find cached data (if available)
-	// Note: The modelViewMatrix is not used for calculating the sorted / filtered vertices, so it's not included
-	const ShadowCache::CachedShadowData *pCached = shadowCache.findCacheForShadowDraw(shape, flag, flag_data, light);
-	if (pCached == nullptr)
+	const Vector3f *pVertices = shape->pShadowPoints->data();
+	if (flag & pie_STATIC_SHADOW && shape->shadowEdgeList)
 	{
-		const Vector3f *pVertices = shape->pShadowPoints->data();
-		if (flag & pie_STATIC_SHADOW && shape->shadowEdgeList)
-		{
-			drawlist = shape->shadowEdgeList;
-			edge_count = shape->nShadowEdges;
-		}
-		else
+		drawlist = shape->shadowEdgeList;
+		edge_count = shape->nShadowEdges;
+	}
+	else
+	{
+		std::vector<EDGE> &edgelist = scratch.edgelist;
+		std::vector<EDGE> &edgelistFlipped = scratch.edgelistFlipped;
+		std::vector<EDGE> &edgelistFiltered = scratch.edgelistFiltered;
+		edgelist.clear();
+		glm::vec3 p[3];
+		for (const iIMDPoly &poly : *(shape->pShadowPolys))
 		{
-			edgelist.clear();
-			glm::vec3 p[3];
-			for (const iIMDPoly &poly : *(shape->pShadowPolys))
+			for (int j = 0; j < 3; ++j)
 			{
-				for (int j = 0; j < 3; ++j)
-				{
-					uint32_t current = poly.pindex[j];
-					p[j] = glm::vec3(pVertices[current].x, scale_y(pVertices[current].y, flag, flag_data), pVertices[current].z);
-				}
-				if (glm::dot(glm::cross(p[2] - p[0], p[1] - p[0]), glm::vec3(light)) > 0.0f)
-				{
-					for (int n = 0; n < 3; ++n)
-					{
-						// Add the edges
-						edgelist.push_back({poly.pindex[n], poly.pindex[(n + 1)%3]});
-					}
-				}
+				uint32_t current = poly.pindex[j];
+				p[j] = glm::vec3(pVertices[current].x, scale_y(pVertices[current].y, flag, flag_data), pVertices[current].z);
 			}
-
-			// Remove duplicate pairs from the edge list. For example, in the list ((1 2), (2 6), (6 2), (3, 4)), remove (2 6) and (6 2).
-			edgelistFlipped = edgelist;
-			std::for_each(edgelistFlipped.begin(), edgelistFlipped.end(), flipEdge);
-			std::sort(edgelist.begin(), edgelist.end(), edgeLessThan);
-			std::sort(edgelistFlipped.begin(), edgelistFlipped.end(), edgeLessThan);
-			edgelistFiltered.resize(edgelist.size());
-			edgelistFiltered.erase(std::set_difference(edgelist.begin(), edgelist.end(), edgelistFlipped.begin(), edgelistFlipped.end(), edgelistFiltered.begin(), edgeLessThan), edgelistFiltered.end());
-
-			edge_count = edgelistFiltered.size();
-			drawlist = edgelistFiltered.data();
-			//debug(LOG_WARNING, "we have %i edges", edge_count);
-
-			if (flag & pie_STATIC_SHADOW)
+			if (glm::dot(glm::cross(p[2] - p[0], p[1] - p[0]), glm::vec3(light)) > 0.0f)
 			{
-				// then store it in the imd
-				shape->nShadowEdges = edge_count;
-				if (edge_count > 0)
+				for (int n = 0; n < 3; ++n)
 				{
-					shape->shadowEdgeList = (EDGE *)realloc(shape->shadowEdgeList, sizeof(EDGE) * shape->nShadowEdges);
-					std::copy(drawlist, drawlist + edge_count, shape->shadowEdgeList);
+					// Add the edges
+					edgelist.push_back({poly.pindex[n], poly.pindex[(n + 1)%3]});
 				}
 			}
 		}
 
-		std::vector<Vector3f> vertexes;
-		vertexes.reserve(edge_count * 6);
-		for (size_t i = 0; i < edge_count; i++)
+		// Remove duplicate pairs from the edge list. For example, in the list ((1 2), (2 6), (6 2), (3, 4)), remove (2 6) and (6 2).
+		edgelistFlipped = edgelist;
+		std::for_each(edgelistFlipped.begin(), edgelistFlipped.end(), flipEdge);
+		std::sort(edgelist.begin(), edgelist.end(), edgeLessThan);
+		std::sort(edgelistFlipped.begin(), edgelistFlipped.end(), edgeLessThan);
+		edgelistFiltered.resize(edgelist.size());
+		edgelistFiltered.erase(std::set_difference(edgelist.begin(), edgelist.end(), edgelistFlipped.begin(), edgelistFlipped.end(), edgelistFiltered.begin(), edgeLessThan), edgelistFiltered.end());
+
+		edge_count = edgelistFiltered.size();
+		drawlist = edgelistFiltered.data();
+		//debug(LOG_WARNING, "we have %i edges", edge_count);
+
+		if (flag & pie_STATIC_SHADOW)
 		{
-			int a = drawlist[i].from, b = drawlist[i].to;
+			job.staticEdges.assign(drawlist, drawlist + edge_count);
+		}
+	}
+
+	std::vector<Vector3f> &vertexes = job.cache->vertexes;
+	vertexes.clear();
+	vertexes.reserve(edge_count * 6);
+	for (size_t i = 0; i < edge_count; i++)
+	{
+		int a = drawlist[i].from, b = drawlist[i].to;
+
+		glm::vec3 v1(pVertices[b].x, scale_y(pVertices[b].y, flag, flag_data), pVertices[b].z);
+		glm::vec3 v3(pVertices[a].x + light[0], scale_y(pVertices[a].y, flag, flag_data) + light[1], pVertices[a].z + light[2]);
 
-			glm::vec3 v1(pVertices[b].x, scale_y(pVertices[b].y, flag, flag_data), pVertices[b].z);
-			glm::vec3 v3(pVertices[a].x + light[0], scale_y(pVertices[a].y, flag, flag_data) + light[1], pVertices[a].z + light[2]);
+		vertexes.push_back(v1);
+		vertexes.push_back(glm::vec3(pVertices[b].x + light[0], scale_y(pVertices[b].y, flag, flag_data) + light[1], pVertices[b].z + light[2])); //v2
+		vertexes.push_back(v3);
 
-			vertexes.push_back(v1);
-			vertexes.push_back(glm::vec3(pVertices[b].x + light[0], scale_y(pVertices[b].y, flag, flag_data) + light[1], pVertices[b].z + light[2])); //v2
-			vertexes.push_back(v3);
+		vertexes.push_back(v3);
+		vertexes.push_back(glm::vec3(pVertices[a].x, scale_y(pVertices[a].y, flag, flag_data), pVertices[a].z)); //v4
+		vertexes.push_back(v1);
+	}
+}
 
-			vertexes.push_back(v3);
-			vertexes.push_back(glm::vec3(pVertices[a].x, scale_y(pVertices[a].y, flag, flag_data), pVertices[a].z)); //v4
-			vertexes.push_back(v1);
+/// Builds shadow volumes until there are none left.
+static void pie_ShadowWork(ShadowBuildScratch &scratch)
+{
+	WZ_PROFILE_ZONE("pie_ShadowWork");
+
+	size_t end = shadowJobs.size();
+	for (size_t i = shadowJobNext++; i < end; i = shadowJobNext++)
+	{
+		pie_BuildShadowVolume(shadowJobs[i], scratch);
+	}
+}
+
+static int pie_ShadowThreadFunc(void *)
+{
+	wzProfileThreadName("shadow volumes");
+	ShadowBuildScratch scratch;
+	while (true)
+	{
+		wzSemaphoreWait(shadowStart);
+		if (shadowQuit)
+		{
+			break;
 		}
+		pie_ShadowWork(scratch);
+		wzSemaphorePost(shadowDone);
+	}
+	return 0;
+}
 
-		ShadowCache::CachedShadowData& cache = shadowCache.createCacheForShadowDraw(shape, flag, flag_data, light);
-		cache.vertexes = std::move(vertexes);
-		result = DRAW_SUCCESS_UNCACHED;
-		pCached = &cache;
+static void pie_StartShadowThreads()
+{
+	shadowQuit = false;
+	shadowStart = wzSemaphoreCreate(0);
+	shadowDone = wzSemaphoreCreate(0);
+	unsigned count = std::min<unsigned>(std::max<int>(std::thread::hardware_concurrency(), 2) - 1, SHADOW_MAX_THREADS);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		WZ_THREAD *thread = wzThreadCreate(pie_ShadowThreadFunc, nullptr);
+		shadowThreads.push_back(thread);
+		wzThreadStart(thread);
 	}
-	else
+	debug(LOG_3D, "Building shadow volumes on %u extra threads", count);
+}
+
+static void pie_StopShadowThreads()
+{
+	shadowQuit = true;
+	for (size_t i = 0; i < shadowThreads.size(); ++i)
 	{
-		result = DRAW_SUCCESS_CACHED;
+		wzSemaphorePost(shadowStart);  // Wake up threads.
 	}
+	for (WZ_THREAD *thread : shadowThreads)
+	{
+		wzThreadJoin(thread);
+	}
+	shadowThreads.clear();
+	if (shadowStart != nullptr)
+	{
+		wzSemaphoreDestroy(shadowStart);
+		shadowStart = nullptr;
+		wzSemaphoreDestroy(shadowDone);
+		shadowDone = nullptr;
+	}
+	shadowJobs.clear();
+}
 
-	// Aggregate the vertexes (pre-computed with the modelViewMatrix)
-	shadowCache.addPremultipliedVertexes(*pCached, modelViewMatrix);
+/// Builds the shadow volumes in shadowJobs, on several threads if the cache is persistent and there are enough of them.
+static void pie_BuildShadowVolumes()
+{
+	if (shadowCacheMode == SHADOW_CACHE::persistent && shadowJobs.size() >= SHADOW_PARALLEL_MIN_JOBS)
+	{
+		if (shadowStart == nullptr)
+		{
+			pie_StartShadowThreads();
+		}
+		shadowJobNext = 0;
+		for (size_t i = 0; i < shadowThreads.size(); ++i)
+		{
+			wzSemaphorePost(shadowStart);
+		}
+		pie_ShadowWork(shadowMainScratch);  // Help out, rather than just waiting.
+		for (size_t i = 0; i < shadowThreads.size(); ++i)
+		{
+			wzSemaphoreWait(shadowDone);
+		}
+	}
+	else
+	{
+		for (ShadowBuildJob &job : shadowJobs)
+		{
+			pie_BuildShadowVolume(job, shadowMainScratch);
+		}
+	}
 
-	return result;
+	// Only the main thread changes the shapes.
+	for (ShadowBuildJob &job : shadowJobs)
+	{
+		iIMDShape *shape = job.shape;
+		if ((job.flag & pie_STATIC_SHADOW) && shape->shadowEdgeList == nullptr && !job.staticEdges.empty())
+		{
+			shape->nShadowEdges = job.staticEdges.size();
+			shape->shadowEdgeList = (EDGE *)malloc(sizeof(EDGE) * shape->nShadowEdges);
+			std::copy(job.staticEdges.begin(), job.staticEdges.end(), shape->shadowEdgeList);
+		}
+	}
 }
 
 void pie_CleanUp()
@@ -733,6 +1058,17 @@ void pie_CleanUp()
 		delete pZeroedVertexBuffer;
 		pZeroedVertexBuffer = nullptr;
 	}
+	for (gfx_api::buffer *buffer : instanceBuffers)
+	{
+		delete buffer;
+	}
+	instanceBuffers.clear();
+	instanceBuffersUsed = 0;
+	instanceData.clear();
+	opaqueBatches.clear();
+	translucentBatches.clear();
+	pie_StopShadowThreads();
+	shadowCache.clear();
 }
 
 bool pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int pieFlag, int pieFlagData, const glm::mat4 &modelView)
@@ -788,11 +1124,15 @@ bool pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int
 				// if object is too far in the fog don't generate a shadow.
 				if (distance < SHADOW_END_DISTANCE)
 				{
-					// Calculate the light position relative to the object
-					glm::vec4 pos_light0 = glm::vec4(currentSunPosition, 0.f);
-					glm::mat4 invmat = glm::inverse(scshape.matrix);
+					// Calculate the light position relative to the object. The sun is a direction, so the translation doesn't matter.
+					glm::vec3 light = glm::inverse(glm::mat3(scshape.matrix)) * currentSunPosition;
+					if (shadowCacheMode == SHADOW_CACHE::persistent)
+					{
+						// Otherwise, the light of an object which didn't move would change slightly whenever the camera moves.
+						light = glm::round(light * (1.f / SHADOW_LIGHT_QUANTUM)) * SHADOW_LIGHT_QUANTUM;
+					}
 
-					scshape.light = invmat * pos_light0;
+					scshape.light = glm::vec4(light, 0.f);
 					scshape.shape = shape;
 					scshape.flag = pieFlag;
 					scshape.flag_data = pieFlagData;
@@ -809,20 +1149,31 @@ bool pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int
 
 static void pie_ShadowDrawLoop(ShadowCache &shadowCache)
 {
-	size_t cachedShadowDraws = 0;
-	size_t uncachedShadowDraws = 0;
+	static std::vector<const ShadowCache::CachedShadowData *> volumes;  // Static, to save allocations.
+	WZ_PROFILE_ZONE("pie_ShadowDrawLoop");
+
+	// Find cached data (if available), and queue the missing volumes to be built
+	// Note: The modelViewMatrix is not used for calculating the sorted / filtered vertices, so it's not included
+	shadowJobs.clear();
+	volumes.resize(scshapes.size());
 	for (unsigned i = 0; i < scshapes.size(); i++)
 	{
-		DrawShadowResult result = pie_DrawShadow(shadowCache, scshapes[i].shape, scshapes[i].flag, scshapes[i].flag_data, scshapes[i].light, scshapes[i].matrix);
-		if (result == DRAW_SUCCESS_CACHED)
+		ShadowcastingShape const &scshape = scshapes[i];
+		volumes[i] = shadowCache.findCacheForShadowDraw(scshape.shape, scshape.flag, scshape.flag_data, scshape.light);
+		if (volumes[i] == nullptr)
 		{
-			++cachedShadowDraws;
-		}
-		else
-		{
-			++uncachedShadowDraws;
+			ShadowCache::CachedShadowData &cache = shadowCache.createCacheForShadowDraw(scshape.shape, scshape.flag, scshape.flag_data, scshape.light);
+			shadowJobs.push_back(ShadowBuildJob{scshape.shape, scshape.flag, scshape.flag_data, scshape.light, &cache, {}});
+			volumes[i] = &cache;
 		}
 	}
+	pie_BuildShadowVolumes();
+
+	// Aggregate the vertexes (pre-computed with the modelViewMatrix)
+	for (unsigned i = 0; i < scshapes.size(); i++)
+	{
+		shadowCache.addPremultipliedVertexes(*volumes[i], scshapes[i].matrix);
+	}
 
 	const auto &premultipliedVertexes = shadowCache.getPremultipliedVertexes();
 	if (premultipliedVertexes.size() > 0)
@@ -847,13 +1198,17 @@ static void pie_ShadowDrawLoop(ShadowCache &shadowCache)
 
 	shadowCache.clearPremultipliedVertexes();
 
-//	debug(LOG_INFO, "Cached shadow draws: %lu, uncached shadow draws: %lu", cachedShadowDraws, uncachedShadowDraws);
+//	debug(LOG_INFO, "Cached shadow draws: %zu, uncached shadow draws: %zu", scshapes.size() - shadowJobs.size(), shadowJobs.size());
 }
 
-static ShadowCache shadowCache;
-
-static void pie_DrawShadows(uint64_t currentGameFrame)
+void pie_DrawShadows(uint64_t currentGameFrame)
 {
+	if (!shadows)
+	{
+		return;
+	}
+	gfx_api::context::get().debugStringMarker("Remaining passes - shadows");
+
 	const int width = pie_GetVideoBufferWidth();
 	const int height = pie_GetVideoBufferHeight();
 	shadowCache.setCurrentFrame(currentGameFrame);
@@ -865,32 +1220,62 @@ static void pie_DrawShadows(uint64_t currentGameFrame)
 	pie_BoxFill_alpha(0, 0, width, height, grey);
 
 	scshapes.resize(0);
-	shadowCache.removeUnused();
+	shadowCache.removeUnused(shadowCacheMode == SHADOW_CACHE::persistent ? SHADOW_CACHE_KEEP_FRAMES : 1);
 }
 
 struct less_than_shape
 {
 	inline bool operator() (const SHAPE& shape1, const SHAPE& shape2)
 	{
-		return (shape1.shape < shape2.shape);
+		if (shape1.shape != shape2.shape)
+		{
+			return (shape1.shape < shape2.shape);
+		}
+		// Keep shapes which can be drawn as one instanced batch together
+		if ((shape1.flag & pie_DRAW_STATE_FLAGS) != (shape2.flag & pie_DRAW_STATE_FLAGS))
+		{
+			return (shape1.flag & pie_DRAW_STATE_FLAGS) < (shape2.flag & pie_DRAW_STATE_FLAGS);
+		}
+		return pie_ShapeFrame(shape1) < pie_ShapeFrame(shape2);
 	}
 };
 
 static ShaderOnce perFrameUniformsShaderOnce;
+static gfx_api::buffer *currentInstanceBuffer = nullptr;  ///< Instance data of both the opaque and the translucent shapes.
 
-void pie_RemainingPasses(uint64_t currentGameFrame)
+void pie_DrawOpaqueShapes()
 {
 	perFrameUniformsShaderOnce.reset();
+	const bool instanced = gfx_api::context::get().supportsInstancedRendering();
 
 	// Draw models
 	// sort list to reduce state changes
 	std::sort(shapes.begin(), shapes.end(), less_than_shape());
+	currentInstanceBuffer = nullptr;
+	if (instanced)
+	{
+		// The translucent models keep their order, so only consecutive ones are batched
+		instanceData.clear();
+		pie_BuildInstancedBatches(shapes, opaqueBatches);
+		pie_BuildInstancedBatches(tshapes, translucentBatches);
+		if (!instanceData.empty())
+		{
+			currentInstanceBuffer = pie_UploadInstanceData();
+		}
+	}
 	gfx_api::context::get().debugStringMarker("Remaining passes - opaque models");
 	templatedState lastState;
-	for (SHAPE const &shape : shapes)
+	if (instanced)
 	{
-		pie_SetShaderStretchDepth(shape.stretch);
-		lastState = pie_Draw3DShape2(lastState, perFrameUniformsShaderOnce, shape.shape, shape.frame, shape.colour, shape.teamcolour, shape.flag, shape.flag_data, shape.matrix);
+		pie_DrawInstancedBatches(perFrameUniformsShaderOnce, opaqueBatches, currentInstanceBuffer);
+	}
+	else
+	{
+		for (SHAPE const &shape : shapes)
+		{
+			pie_SetShaderStretchDepth(shape.stretch);
+			lastState = pie_Draw3DShape2(lastState, perFrameUniformsShaderOnce, shape.shape, shape.frame, shape.colour, shape.teamcolour, shape.flag, shape.flag_data, shape.matrix);
+		}
 	}
 	gfx_api::context::get().disable_all_vertex_buffers();
 	if (!shapes.empty())
@@ -898,20 +1283,27 @@ void pie_RemainingPasses(uint64_t currentGameFrame)
 		// unbind last index buffer bound inside pie_Draw3DShape2
 		gfx_api::context::get().unbind_index_buffer(*((shapes.back().shape)->buffers[VBO_INDEX]));
 	}
-	gfx_api::context::get().debugStringMarker("Remaining passes - shadows");
-	// Draw shadows
-	if (shadows)
-	{
-		pie_DrawShadows(currentGameFrame);
-	}
+}
+
+void pie_DrawTranslucentShapes()
+{
+	const bool instanced = gfx_api::context::get().supportsInstancedRendering();
+
 	// Draw translucent models last
 	// TODO, sort list by Z order to do translucency correctly
 	gfx_api::context::get().debugStringMarker("Remaining passes - translucent models");
-	lastState = templatedState();
-	for (SHAPE const &shape : tshapes)
+	templatedState lastState;
+	if (instanced)
 	{
-		pie_SetShaderStretchDepth(shape.stretch);
-		lastState = pie_Draw3DShape2(lastState, perFrameUniformsShaderOnce, shape.shape, shape.frame, shape.colour, shape.teamcolour, shape.flag, shape.flag_data, shape.matrix);
+		pie_DrawInstancedBatches(perFrameUniformsShaderOnce, translucentBatches, currentInstanceBuffer);
+	}
+	else
+	{
+		for (SHAPE const &shape : tshapes)
+		{
+			pie_SetShaderStretchDepth(shape.stretch);
+			lastState = pie_Draw3DShape2(lastState, perFrameUniformsShaderOnce, shape.shape, shape.frame, shape.colour, shape.teamcolour, shape.flag, shape.flag_data, shape.matrix);
+		}
 	}
 	gfx_api::context::get().disable_all_vertex_buffers();
 	if (!tshapes.empty())
@@ -922,14 +1314,19 @@ void pie_RemainingPasses(uint64_t currentGameFrame)
 	pie_SetShaderStretchDepth(0);
 	tshapes.clear();
 	shapes.clear();
+	opaqueBatches.clear();
+	translucentBatches.clear();
+	currentInstanceBuffer = nullptr;
 	gfx_api::context::get().debugStringMarker("Remaining passes - done");
 }
 
-void pie_GetResetCounts(size_t *pPieCount, size_t *pPolyCount)
+void pie_GetResetCounts(size_t *pPieCount, size_t *pPolyCount, size_t *pDrawCount)
 {
 	*pPieCount  = pieCount;
 	*pPolyCount = polyCount;
+	*pDrawCount = drawCount;
 
 	pieCount = 0;
 	polyCount = 0;
+	drawCount = 0;
 }
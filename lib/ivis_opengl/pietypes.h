@@ -95,6 +95,8 @@ enum SHADER_MODE
 	SHADER_COMPONENT,
 	SHADER_BUTTON,
 	SHADER_NOLIGHT,
+	SHADER_COMPONENT_INSTANCED,
+	SHADER_NOLIGHT_INSTANCED,
 	SHADER_TERRAIN,
 	SHADER_TERRAIN_DEPTH,
 	SHADER_DECALS,
@@ -110,7 +110,7 @@ void wzPerfWriteOut(const std::vector<PERF_STORE> &list, const WzString &outfile
 	PHYSFS_file *fileHandle = PHYSFS_openWrite(outfile.toUtf8().c_str());
 	if (fileHandle)
 	{
-		const char fileHeader[] = "START, EFF, TERRAIN, SKY, LOAD, PRTCL, WATER, MODELS, MISC, GUI\n";
+		const char fileHeader[] = "START, EFF, TERRAIN, SKY, LOAD, PRTCL, WATER, MODELS, SHADOWS, TRANSL, MISC, GUI\n";
 		if (WZ_PHYSFS_writeBytes(fileHandle, fileHeader, sizeof(fileHeader)) != sizeof(fileHeader))
 		{
 			// Failed to write header to file
@@ -77,6 +77,8 @@ enum PERF_POINT
 	PERF_PARTICLES,
 	PERF_WATER,
 	PERF_MODELS,
+	PERF_SHADOWS,
+	PERF_TRANSLUCENT,
 	PERF_MISC,
 	PERF_GUI,
 	PERF_COUNT
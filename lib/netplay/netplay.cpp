@@ -42,6 +42,7 @@
 #include <thread>
 #include <atomic>
 #include <limits>
+#include <unordered_map>
 #include <sodium.h>
 #include <re2/re2.h>
 
@@ -1686,6 +1687,17 @@ size_t NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 
 
 // ////////////////////////////////////////////////////////////////////////
+static std::vector<uint8_t> netSendBuffer;
+
+/// Takes netSendBuffer for the lifetime of the object. A nested NETsend() finds netSendBuffer empty, and uses its own.
+struct NetSendBuffer
+{
+	NetSendBuffer() { data.swap(netSendBuffer); }
+	~NetSendBuffer() { data.swap(netSendBuffer); }
+
+	std::vector<uint8_t> data;
+};
+
 // Send a message to a player, option to guarantee message
 bool NETsend(NETQUEUE queue, NetMessage const *message)
 {
@@ -1717,6 +1729,20 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 		ASSERT_OR_RETURN(false, false, "Wrong queue type.");
 	}
 
+	// Serialized once, and shared by all recipients of a broadcast. The buffer is reused between calls, so sending
+	// doesn't allocate once it has grown to fit the largest message. (The bytes can't be compressed once and shared,
+	// since each socket has its own zlib stream, see writeAll().)
+	// NETsend() can be re-entered, when a failed write disconnects a player and that is broadcast, so the buffer is
+	// taken out of netSendBuffer for the duration of the call, instead of being used in place.
+	NetSendBuffer buffer;
+	std::vector<uint8_t> &rawData = buffer.data;
+	rawData.clear();
+	if (NetPlay.isHost || player == NetPlay.hostPlayer)
+	{
+		message->rawDataAppendToVector(rawData);
+	}
+	ssize_t rawLen = rawData.size();
+
 	if (NetPlay.isHost)
 	{
 		int firstPlayer = player == NET_ALL_PLAYERS ? 0                         : player;
@@ -1726,16 +1752,8 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 			// We are the host, send directly to player.
 			if (sockets[player] != nullptr && player != queue.exclude)
 			{
-				uint8_t *rawData = message->rawDataDup();
-				if (!rawData)
-				{
-					debug(LOG_FATAL, "Failed to allocate raw data (message type: %" PRIu8 ", player: %d)", message->type, player);
-					abort();
-				}
-				ssize_t rawLen   = message->rawLen();
 				size_t compressedRawLen;
-				result = writeAll(sockets[player], rawData, rawLen, &compressedRawLen);
-				delete[] rawData;  // Done with the data.
+				result = writeAll(sockets[player], rawData.data(), rawLen, &compressedRawLen);
 
 				if (result == rawLen)
 				{
@@ -1762,11 +1780,8 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 		// We are a client, send directly to player, who happens to be the host.
 		if (bsocket)
 		{
-			uint8_t *rawData = message->rawDataDup();
-			ssize_t rawLen   = message->rawLen();
 			size_t compressedRawLen;
-			result = writeAll(bsocket, rawData, rawLen, &compressedRawLen);
-			delete[] rawData;  // Done with the data.
+			result = writeAll(bsocket, rawData.data(), rawLen, &compressedRawLen);
 
 			if (result == rawLen)
 			{
@@ -4727,6 +4742,9 @@ bool NETcheckPlayerConnectionStatus(CONNECTION_STATUS status, unsigned player)
 	return realTime < NET_PlayerConnectionStatus[status][player];
 }
 
+#define MAX_LEN_LOG_LINE 512  // From debug.c - no use printing something longer.
+#define SYNC_DEBUG_MAX_INTS 40  // Most ints snprintfInts() can format.
+
 struct SyncDebugEntry
 {
 	char const *function;
@@ -4775,13 +4793,63 @@ struct SyncDebugValueChange : public SyncDebugEntry
 	char const *variableName;
 };
 
+/// Formats a string which takes numInts ints, like snprintf.
+static int snprintfInts(char *buf, size_t bufSize, char const *string, int const *ints, unsigned numInts)
+{
+	switch (numInts)
+	{
+	case  0: return snprintf(buf, bufSize, "%s", string);
+	case  1: return snprintf(buf, bufSize, string, ints[0]);
+	case  2: return snprintf(buf, bufSize, string, ints[0], ints[1]);
+	case  3: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2]);
+	case  4: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3]);
+	case  5: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4]);
+	case  6: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5]);
+	case  7: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6]);
+	case  8: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7]);
+	case  9: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8]);
+	case 10: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9]);
+	case 11: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10]);
+	case 12: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11]);
+	case 13: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12]);
+	case 14: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13]);
+	case 15: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14]);
+	case 16: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15]);
+	case 17: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16]);
+	case 18: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17]);
+	case 19: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18]);
+	case 20: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19]);
+	case 21: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20]);
+	case 22: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21]);
+	case 23: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22]);
+	case 24: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23]);
+	case 25: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24]);
+	case 26: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25]);
+	case 27: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26]);
+	case 28: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27]);
+	case 29: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28]);
+	case 30: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29]);
+	case 31: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30]);
+	case 32: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31]);
+	case 33: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32]);
+	case 34: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33]);
+	case 35: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34]);
+	case 36: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35]);
+	case 37: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36]);
+	case 38: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37]);
+	case 39: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38]);
+	case 40: return snprintf(buf, bufSize, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38], ints[39]);
+	default: return snprintf(buf, bufSize, "Too many ints in intlist.");
+	}
+}
+
 struct SyncDebugIntList : public SyncDebugEntry
 {
 	void set(uint32_t &crc, char const *f, char const *s, int const *ints, size_t num)
 	{
 		function = f;
 		string = s;
-		uint32_t valueBytes[40];
+		uint32_t valueBytes[SYNC_DEBUG_MAX_INTS];
 		numInts = std::min(num, ARRAY_SIZE(valueBytes));
 		for (unsigned n = 0; n < numInts; ++n)
 		{
@@ -4798,51 +4866,7 @@ struct SyncDebugIntList : public SyncDebugEntry
 		}
 		if (index < bufSize)
 		{
-			switch (numInts)
-			{
-			case  0: index += snprintf(buf + index, bufSize - index, "%s", string); break;
-			case  1: index += snprintf(buf + index, bufSize - index, string, ints[0]); break;
-			case  2: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1]); break;
-			case  3: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2]); break;
-			case  4: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3]); break;
-			case  5: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4]); break;
-			case  6: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5]); break;
-			case  7: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6]); break;
-			case  8: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7]); break;
-			case  9: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8]); break;
-			case 10: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9]); break;
-			case 11: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10]); break;
-			case 12: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11]); break;
-			case 13: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12]); break;
-			case 14: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13]); break;
-			case 15: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14]); break;
-			case 16: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15]); break;
-			case 17: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16]); break;
-			case 18: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17]); break;
-			case 19: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18]); break;
-			case 20: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19]); break;
-			case 21: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20]); break;
-			case 22: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21]); break;
-			case 23: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22]); break;
-			case 24: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23]); break;
-			case 25: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24]); break;
-			case 26: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25]); break;
-			case 27: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26]); break;
-			case 28: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27]); break;
-			case 29: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28]); break;
-			case 30: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29]); break;
-			case 31: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30]); break;
-			case 32: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31]); break;
-			case 33: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32]); break;
-			case 34: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33]); break;
-			case 35: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34]); break;
-			case 36: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35]); break;
-			case 37: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36]); break;
-			case 38: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37]); break;
-			case 39: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38]); break;
-			case 40: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38], ints[39]); break;
-			default: index += snprintf(buf + index, bufSize - index, "Too many ints in intlist."); break;
-			}
+			index += snprintfInts(buf + index, bufSize - index, string, ints, numInts);
 		}
 		if (index < bufSize)
 		{
@@ -4856,6 +4880,35 @@ struct SyncDebugIntList : public SyncDebugEntry
 	unsigned numInts;
 };
 
+/// A syncDebug() call with a format string which only takes ints, which is only formatted if dumped.
+struct SyncDebugFormat : public SyncDebugEntry
+{
+	void set(uint32_t &crc, char const *f, char const *s, uint32_t formatCrc, int const *ints, size_t num)
+	{
+		function = f;
+		string = s;
+		numInts = num;
+		uint32_t valueBytes[1 + SYNC_DEBUG_MAX_INTS];
+		valueBytes[0] = htonl(formatCrc);
+		for (unsigned n = 0; n < numInts; ++n)
+		{
+			valueBytes[1 + n] = htonl(ints[n]);
+		}
+		crc = crcSum(crc, valueBytes, 4 * (1 + numInts));
+	}
+	int snprint(char *buf, size_t bufSize, int const *&ints) const
+	{
+		// Same output as SyncDebugString, including truncating long lines.
+		char outputBuffer[MAX_LEN_LOG_LINE];
+		snprintfInts(outputBuffer, sizeof(outputBuffer), string, ints, numInts);
+		ints += numInts;
+		return snprintf(buf, bufSize, "[%s] %s\n", function, outputBuffer);
+	}
+
+	char const *string;
+	unsigned numInts;
+};
+
 struct SyncDebugLog
 {
 	SyncDebugLog() : time(0), crc(0x00000000) {}
@@ -4868,6 +4921,7 @@ struct SyncDebugLog
 		strings.clear();
 		valueChanges.clear();
 		intLists.clear();
+		formats.clear();
 		chars.clear();
 		ints.clear();
 	}
@@ -4900,11 +4954,21 @@ struct SyncDebugLog
 		intLists.back().set(crc, f, s, buf, num);
 		log.push_back('i');
 	}
+	void format(char const *f, char const *s, uint32_t formatCrc, int const *begin, size_t num)
+	{
+		size_t offset = ints.size();
+		ints.insert(ints.end(), begin, begin + num);
+
+		formats.resize(formats.size() + 1);
+		formats.back().set(crc, f, s, formatCrc, &ints[offset], num);
+		log.push_back('f');
+	}
 	int snprint(char *buf, size_t bufSize)
 	{
 		SyncDebugString const *stringPtr = strings.empty() ? nullptr : &strings[0]; // .empty() check, since &strings[0] is undefined if strings is empty(), even if it's likely to work, anyway.
 		SyncDebugValueChange const *valueChangePtr = valueChanges.empty() ? nullptr : &valueChanges[0];
 		SyncDebugIntList const *intListPtr = intLists.empty() ? nullptr : &intLists[0];
+		SyncDebugFormat const *formatPtr = formats.empty() ? nullptr : &formats[0];
 		char const *charPtr = chars.empty() ? nullptr : &chars[0];
 		int const *intPtr = ints.empty() ? nullptr : &ints[0];
 
@@ -4923,6 +4987,9 @@ struct SyncDebugLog
 			case 'i':
 				index += intListPtr++->snprint(buf + index, bufSize - index, intPtr);
 				break;
+			case 'f':
+				index += formatPtr++->snprint(buf + index, bufSize - index, intPtr);
+				break;
 			default:
 				abort();
 				break;
@@ -4959,6 +5026,7 @@ private:
 	std::vector<SyncDebugString> strings;
 	std::vector<SyncDebugValueChange> valueChanges;
 	std::vector<SyncDebugIntList> intLists;
+	std::vector<SyncDebugFormat> formats;
 
 	std::vector<char> chars;
 	std::vector<int> ints;
@@ -4968,7 +5036,6 @@ private:
 	SyncDebugLog &operator =(SyncDebugLog const &)/* = delete*/;
 };
 
-#define MAX_LEN_LOG_LINE 512  // From debug.c - no use printing something longer.
 #define MAX_SYNC_HISTORY 12
 
 static unsigned syncDebugNext = 0;
@@ -4978,6 +5045,74 @@ static uint32_t syncDebugExtraCrc;
 
 static uint32_t syncDebugNumDumps = 0;
 
+struct SyncDebugFormatKey
+{
+	bool operator ==(SyncDebugFormatKey const &b) const
+	{
+		return function == b.function && format == b.format;
+	}
+
+	char const *function;
+	char const *format;
+};
+
+struct SyncDebugFormatKeyHash
+{
+	size_t operator ()(SyncDebugFormatKey const &k) const
+	{
+		return std::hash<char const *>()(k.function) ^ std::hash<char const *>()(k.format) * 31;
+	}
+};
+
+struct SyncDebugFormatInfo
+{
+	bool intsOnly;   ///< True if the format only takes ints (including chars and unsigned), so can be formatted later.
+	unsigned numInts;
+	uint32_t crc;    ///< CRC of the function name and format string.
+};
+
+/// Parsed syncDebug() format strings, by function name and format string. Both are string literals, so the pointers identify them.
+static std::unordered_map<SyncDebugFormatKey, SyncDebugFormatInfo, SyncDebugFormatKeyHash> syncDebugFormats;
+
+static SyncDebugFormatInfo parseSyncDebugFormat(char const *function, char const *str)
+{
+	SyncDebugFormatInfo info = {true, 0, 0};
+	info.crc = crcSum(info.crc, function, strlen(function) + 1);
+	info.crc = crcSum(info.crc, str,      strlen(str) + 1);
+
+	for (char const *c = str; *c != '\0'; ++c)
+	{
+		if (*c != '%')
+		{
+			continue;
+		}
+		++c;
+		if (*c == '%')
+		{
+			continue;
+		}
+		c += strspn(c, "-+ #0");
+		c += strspn(c, "0123456789");
+		if (*c == '.')
+		{
+			++c;
+			c += strspn(c, "0123456789");
+		}
+		c += std::min<size_t>(strspn(c, "h"), 2);
+		if (*c == '\0' || strchr("diouxXc", *c) == nullptr)
+		{
+			info.intsOnly = false;  // Strings, floats, pointers, longs, '*' widths or something unexpected.
+			break;
+		}
+		++info.numInts;
+	}
+	if (info.numInts > SYNC_DEBUG_MAX_INTS || (info.numInts == 0 && strchr(str, '%') != nullptr))
+	{
+		info.intsOnly = false;  // Too many ints, or "%%" which snprintfInts() wouldn't unescape without any ints.
+	}
+	return info;
+}
+
 void _syncDebug(const char *function, const char *str, ...)
 {
 #ifdef WZ_CC_MSVC
@@ -4987,10 +5122,30 @@ void _syncDebug(const char *function, const char *str, ...)
 		}
 #endif
 
-	va_list ap;
-	char outputBuffer[MAX_LEN_LOG_LINE];
+	SyncDebugFormatKey key = {function, str};
+	auto i = syncDebugFormats.find(key);
+	if (i == syncDebugFormats.end())
+	{
+		i = syncDebugFormats.emplace(key, parseSyncDebugFormat(function, str)).first;
+	}
+	SyncDebugFormatInfo const &info = i->second;
 
+	va_list ap;
 	va_start(ap, str);
+	if (info.intsOnly)
+	{
+		// Just record the values, only format them if dumping the log.
+		int ints[SYNC_DEBUG_MAX_INTS];
+		for (unsigned n = 0; n < info.numInts; ++n)
+		{
+			ints[n] = static_cast<int>(va_arg(ap, unsigned));  // Chars and shorts are promoted to int, so this works for all of "diouxXc".
+		}
+		va_end(ap);
+		syncDebugLog[syncDebugNext].format(function, str, info.crc, ints, info.numInts);
+		return;
+	}
+
+	char outputBuffer[MAX_LEN_LOG_LINE];
 	vssprintf(outputBuffer, str, ap);
 	va_end(ap);
 
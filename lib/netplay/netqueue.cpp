@@ -154,49 +154,76 @@ size_t NetMessage::rawLen() const
 NetQueue::NetQueue()
 	: canGetMessagesForNet(true)
 	, canGetMessages(true)
+	, dataPos(0)
+	, messagePos(0)
 	, pendingGameTimeUpdateMessages(0)
+{}
+
+NetMessage &NetQueue::pushNewMessage(uint8_t type)
 {
-	dataPos = messages.end();
-	messagePos = messages.end();
+	messages.emplace_back(type);
+	NetMessage &message = messages.back();
+	if (!spareMessageData.empty())
+	{
+		message.data = std::move(spareMessageData.back());
+		spareMessageData.pop_back();
+	}
+	if (type == GAME_GAME_TIME)
+	{
+		++pendingGameTimeUpdateMessages;
+	}
+	return message;
 }
 
-void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
+size_t NetQueue::extractMessages(const uint8_t *netData, size_t netLen)
 {
 	size_t used = 0;
-	std::vector<uint8_t> &buffer = incompleteReceivedMessageData;  // Short alias.
-
-	// Insert the data.
-	buffer.insert(buffer.end(), netData, netData + netLen);
 
-	// Extract the messages.
-	while (buffer.size() - used > 1)
+	while (netLen - used > 1)
 	{
-		uint8_t type = buffer[used];
+		uint8_t type = netData[used];
 
 		uint32_t len = 0;
 		bool moreBytes = true;
 		unsigned n;
-		for (n = 0; moreBytes && buffer.size() - used > 1 + n; ++n)
+		for (n = 0; moreBytes && netLen - used > 1 + n; ++n)
 		{
-			moreBytes = decode_uint32_t(buffer[used + 1 + n], len, n);
+			moreBytes = decode_uint32_t(netData[used + 1 + n], len, n);
 		}
 		unsigned headerLen = 1 + n;
 
 		ASSERT(len < 40000000, "Trying to write a very large packet (%u bytes) to the queue.", len);
-		if (buffer.size() - used - headerLen < len)
+		if (netLen - used - headerLen < len)
 		{
 			break;  // Don't have a whole message ready yet.
 		}
 
-		messages.push_front(NetMessage(type));
-		messages.front().data.assign(buffer.begin() + used + headerLen, buffer.begin() + used + headerLen + len);
-		if (type == GAME_GAME_TIME)
-		{
-			++pendingGameTimeUpdateMessages;
-		}
+		NetMessage &message = pushNewMessage(type);
+		message.data.assign(netData + used + headerLen, netData + used + headerLen + len);
 		used += headerLen + len;
 	}
 
+	return used;
+}
+
+void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
+{
+	std::vector<uint8_t> &buffer = incompleteReceivedMessageData;  // Short alias.
+
+	if (buffer.empty())
+	{
+		// Extract the messages straight from the network data, only keeping any incomplete message at the end.
+		size_t used = extractMessages(netData, netLen);
+		buffer.assign(netData + used, netData + netLen);
+		return;
+	}
+
+	// Insert the data.
+	buffer.insert(buffer.end(), netData, netData + netLen);
+
+	// Extract the messages.
+	size_t used = extractMessages(buffer.data(), buffer.size());
+
 	// Recycle old data.
 	buffer.erase(buffer.begin(), buffer.begin() + used);
 }
@@ -211,10 +238,7 @@ unsigned NetQueue::numMessagesForNet() const
 	unsigned count = 0;
 	if (canGetMessagesForNet)
 	{
-		for (List::iterator i = dataPos; i != messages.begin(); --i)
-		{
-			++count;
-		}
+		count = messages.size() - dataPos;
 	}
 
 	return count;
@@ -223,7 +247,7 @@ unsigned NetQueue::numMessagesForNet() const
 const NetMessage &NetQueue::getMessageForNet() const
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for getMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to get!");
+	ASSERT(dataPos != messages.size(), "No message to get!");
 
 	// Return the message.
 	return internal_getMessageForNet();
@@ -232,9 +256,9 @@ const NetMessage &NetQueue::getMessageForNet() const
 void NetQueue::popMessageForNet()
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for popMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to pop!");
+	ASSERT(dataPos != messages.size(), "No message to pop!");
 
-	if (messagePos != messages.begin() && internal_getMessageForNet().type == GAME_GAME_TIME)
+	if (messagePos != messages.size() && internal_getMessageForNet().type == GAME_GAME_TIME)
 	{
 		if (pendingGameTimeUpdateMessages > 0)
 		{
@@ -243,7 +267,7 @@ void NetQueue::popMessageForNet()
 	}
 
 	// Pop the message.
-	--dataPos;
+	++dataPos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -251,11 +275,13 @@ void NetQueue::popMessageForNet()
 
 void NetQueue::pushMessage(const NetMessage &message)
 {
-	if (message.type == GAME_GAME_TIME)
-	{
-		++pendingGameTimeUpdateMessages;
-	}
-	messages.push_front(message);
+	pushMessage(message.type, message.data.data(), message.data.size());
+}
+
+void NetQueue::pushMessage(uint8_t type, const uint8_t *data, size_t size)
+{
+	NetMessage &newMessage = pushNewMessage(type);
+	newMessage.data.assign(data, data + size);
 }
 
 void NetQueue::setWillNeverGetMessages()
@@ -266,13 +292,13 @@ void NetQueue::setWillNeverGetMessages()
 bool NetQueue::haveMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for haveMessage.");
-	return messagePos != messages.begin();
+	return messagePos != messages.size();
 }
 
 const NetMessage &NetQueue::getMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for getMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to get!");
+	ASSERT(messagePos != messages.size(), "No message to get!");
 
 	// Return the message.
 	return internal_getMessage();
@@ -281,9 +307,9 @@ const NetMessage &NetQueue::getMessage() const
 void NetQueue::popMessage()
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for popMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to pop!");
+	ASSERT(messagePos != messages.size(), "No message to pop!");
 
-	if (messagePos != messages.begin() && internal_getMessage().type == GAME_GAME_TIME)
+	if (messagePos != messages.size() && internal_getMessage().type == GAME_GAME_TIME)
 	{
 		if (pendingGameTimeUpdateMessages > 0)
 		{
@@ -292,7 +318,7 @@ void NetQueue::popMessage()
 	}
 
 	// Pop the message.
-	--messagePos;
+	++messagePos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -302,27 +328,24 @@ void NetQueue::popOldMessages()
 {
 	if (!canGetMessagesForNet)
 	{
-		dataPos = messages.begin();
+		dataPos = messages.size();
 	}
 	if (!canGetMessages)
 	{
-		messagePos = messages.begin();
-	}
-
-	List::iterator i = messages.end();
-	while (i != dataPos && i != messagePos)
-	{
-		--i;
+		messagePos = messages.size();
 	}
 
-	if (i == dataPos)
+	size_t numOld = std::min(dataPos, messagePos);
+	for (size_t n = 0; n < numOld; ++n)
 	{
-		dataPos = messages.end();  // Old iterator will become invalid.
-	}
-	if (i == messagePos)
-	{
-		messagePos = messages.end();  // Old iterator will become invalid.
+		std::vector<uint8_t> &data = messages.front().data;
+		if (spareMessageData.size() < 64 && data.capacity() <= 65536)
+		{
+			data.clear();
+			spareMessageData.push_back(std::move(data));
+		}
+		messages.pop_front();
 	}
-
-	messages.erase(i, messages.end());
+	dataPos -= numOld;
+	messagePos -= numOld;
 }
@@ -26,7 +26,6 @@
 
 #include "lib/framework/frame.h"
 #include <vector>
-#include <list>
 #include <deque>
 #include <unordered_map>
 
@@ -113,6 +112,7 @@ public:
 	// All game clients should check game messages from all queues, including their own, and only the net messages sent to them.
 	// Message related, storing.
 	void pushMessage(const NetMessage &message);                       ///< Adds a message to the queue.
+	void pushMessage(uint8_t type, const uint8_t *data, size_t size);  ///< Adds a message with a copy of the given data to the queue.
 	// Message related, extracting.
 	void setWillNeverGetMessages();                                    ///< Marks that we will not be reading any of the messages (only sending over the network).
 	bool haveMessage() const;                                          ///< Return true if we have a message ready to return.
@@ -126,6 +126,8 @@ public:
 
 private:
 	void popOldMessages();                                             ///< Pops any messages that are no longer needed.
+	NetMessage &pushNewMessage(uint8_t type);                          ///< Adds an empty message, reusing the data buffer of an old message if possible.
+	size_t extractMessages(const uint8_t *netData, size_t netLen);     ///< Adds the complete messages at the start of netData, returning the number of bytes used.
 
 	bool canGetMessagesForNet;                                         ///< True if we will send the messages over the network, false if we don't.
 	bool canGetMessages;                                               ///< True if we will get the messages, false if we don't use them ourselves.
@@ -133,23 +135,22 @@ private:
 	inline const NetMessage &internal_getMessageForNet() const
 	{
 		// Return the message.
-		List::iterator i = dataPos;
-		--i;
-		return *i;
+		return messages[dataPos];
 	};
 
 	inline const NetMessage &internal_getMessage() const
 	{
 		// Return the message.
-		List::iterator i = messagePos;
-		--i;
-		return *i;
+		return messages[messagePos];
 	};
 
-	using List = std::list<NetMessage>;
-	List::iterator                dataPos;                             ///< Last message which was sent over the network.
-	List::iterator                messagePos;                          ///< Last message which was popped.
-	List                          messages;                            ///< List of messages. Messages are added to the front and read from the back.
+	// A deque, since adding messages at the back and popping them from the front doesn't move the other messages, so
+	// references returned by getMessage() and getMessageForNet() stay valid until the message is popped.
+	using List = std::deque<NetMessage>;
+	size_t                        dataPos;                             ///< Index of the next message to send over the network.
+	size_t                        messagePos;                          ///< Index of the next message to return.
+	List                          messages;                            ///< Queue of messages. Messages are added to the back and read from the front.
+	std::vector<std::vector<uint8_t>> spareMessageData;                ///< Data buffers of popped messages, to reuse for new messages.
 	std::vector<uint8_t>          incompleteReceivedMessageData;       ///< Data from network which has not yet formed an entire message.
 	size_t                        pendingGameTimeUpdateMessages;       ///< Pending GAME_GAME_TIME messages added to this queue
 };
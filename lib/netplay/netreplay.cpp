@@ -57,6 +57,16 @@ static const uint32_t currentReplayFormatVer = 2;
 static const size_t DefaultReplayBufferSize = 32768;
 static const size_t MaxReplayBufferSize = 2 * 1024 * 1024;
 
+// Replays are always played from the start, there is no index or snapshot to seek with. The messages only reproduce the
+// game when applied to exactly the state they were recorded on, and savegames don't keep all of it (the synchronised
+// random number state isn't saved, and object ids are rounded up on loading), so a game resumed from a snapshot would
+// desync from the recorded messages.
+
+// The whole message stream is read at once when loading, instead of reading each message (and each length byte) from the file.
+static std::vector<uint8_t> replayLoadData;
+static size_t replayLoadPos = 0;
+static size_t replayLoadEnd = 0;
+
 typedef std::vector<uint8_t> SerializedNetMessagesBuffer;
 static moodycamel::BlockingReaderWriterQueue<SerializedNetMessagesBuffer> serializedBufferWriteQueue(256);
 static SerializedNetMessagesBuffer latestWriteBuffer;
@@ -275,6 +285,40 @@ void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player)
 	}
 }
 
+static uint32_t replayLoadUBE32(size_t pos)
+{
+	return uint32_t(replayLoadData[pos]) << 24 | uint32_t(replayLoadData[pos + 1]) << 16 | uint32_t(replayLoadData[pos + 2]) << 8 | uint32_t(replayLoadData[pos + 3]);
+}
+
+/// Reads the end of game info (v2+), which is preceded and followed by its size, and stops the message stream before it.
+/// If the file is truncated, the info is just ignored, and the missing REPLAY_ENDED message is noticed later.
+static void replayLoadEndOfGameInfo()
+{
+	size_t size = replayLoadData.size();
+	if (size < 8)
+	{
+		return;
+	}
+	uint32_t infoSize = replayLoadUBE32(size - 4);
+	if (infoSize > size - 8 || replayLoadUBE32(size - 8 - infoSize) != infoSize)
+	{
+		debug(LOG_WARNING, "Replay end of game info not found");
+		return;
+	}
+	size_t infoStart = size - 4 - infoSize;
+	replayLoadEnd = infoStart - 4;
+
+	try
+	{
+		nlohmann::json info = nlohmann::json::parse(replayLoadData.begin() + infoStart, replayLoadData.begin() + infoStart + infoSize);
+		debug(LOG_INFO, "Replay is %u game ticks long", info.at("gameTimeElapsed").get<uint32_t>());
+	}
+	catch (const std::exception& e)
+	{
+		debug(LOG_WARNING, "Error parsing replay end of game info JSON (\"%s\")", e.what());
+	}
+}
+
 bool NETreplayLoadStart(std::string const &filename, ReplayOptionsHandler& optionsHandler, uint32_t& output_replayFormatVer)
 {
 	auto onFail = [&](char const *reason) {
@@ -384,60 +428,78 @@ bool NETreplayLoadStart(std::string const &filename, ReplayOptionsHandler& optio
 		return onFail(parseError.c_str());
 	}
 
+	// Read the rest of the file (the messages and the end of game info) in one go.
+	PHYSFS_sint64 streamStart = PHYSFS_tell(replayLoadHandle);
+	PHYSFS_sint64 fileLength = PHYSFS_fileLength(replayLoadHandle);
+	if (streamStart < 0 || fileLength < streamStart)
+	{
+		return onFail("error getting file length");
+	}
+	replayLoadData.resize(static_cast<size_t>(fileLength - streamStart));
+	if (!replayLoadData.empty() && WZ_PHYSFS_readBytes(replayLoadHandle, replayLoadData.data(), static_cast<PHYSFS_uint32>(replayLoadData.size())) != static_cast<PHYSFS_sint64>(replayLoadData.size()))
+	{
+		replayLoadData.clear();
+		return onFail("error reading messages");
+	}
+	PHYSFS_close(replayLoadHandle);
+	replayLoadHandle = nullptr;
+	replayLoadPos = 0;
+	replayLoadEnd = replayLoadData.size();
+
+	if (output_replayFormatVer >= 2)
+	{
+		replayLoadEndOfGameInfo();
+	}
+
 	debug(LOG_INFO, "Started reading replay file \"%s\".", filename.c_str());
 	return true;
 }
 
-bool NETreplayLoadNetMessage(std::unique_ptr<NetMessage> &message, uint8_t &player)
+bool NETreplayLoadNetMessage(ReplayNetMessageView &message, uint8_t &player)
 {
-	if (!replayLoadHandle)
+	if (replayLoadPos + 2 > replayLoadEnd)
 	{
 		return false;
 	}
 
-	WZ_PHYSFS_readBytes(replayLoadHandle, &player, 1);
-
-	uint8_t type;
-	WZ_PHYSFS_readBytes(replayLoadHandle, &type, 1);
+	player = replayLoadData[replayLoadPos++];
+	uint8_t type = replayLoadData[replayLoadPos++];
 
 	uint32_t len = 0;
-	uint8_t b;
 	unsigned n = 0;
-	bool rd;
+	bool more;
 	do
 	{
-		rd = WZ_PHYSFS_readBytes(replayLoadHandle, &b, 1);
-	} while (decode_uint32_t(b, len, n++));
+		if (replayLoadPos >= replayLoadEnd)
+		{
+			return false;
+		}
+		more = decode_uint32_t(replayLoadData[replayLoadPos++], len, n++);
+	} while (more);
 
-	if (!rd)
+	if (len > replayLoadEnd - replayLoadPos)
 	{
 		return false;
 	}
 
-	message = std::unique_ptr<NetMessage>(new NetMessage(type));
-	message->data.resize(len);
-	size_t messageRead = WZ_PHYSFS_readBytes(replayLoadHandle, message->data.data(), message->data.size());
-	if (messageRead != message->data.size())
-	{
-		return false;
-	}
+	message.type = type;
+	message.data = replayLoadData.data() + replayLoadPos;
+	message.size = len;
+	replayLoadPos += len;
 
-	return (message->type > GAME_MIN_TYPE && message->type < GAME_MAX_TYPE) || message->type == REPLAY_ENDED;
+	return (type > GAME_MIN_TYPE && type < GAME_MAX_TYPE) || type == REPLAY_ENDED;
 }
 
 bool NETreplayLoadStop()
 {
-	if (!replayLoadHandle)
+	if (replayLoadData.empty())
 	{
 		return false;
 	}
 
-	if (!PHYSFS_close(replayLoadHandle))
-	{
-		debug(LOG_ERROR, "Could not close replay file: %s", WZ_PHYSFS_getLastError());
-		return false;
-	}
-	replayLoadHandle = nullptr;
+	replayLoadData = std::vector<uint8_t>();
+	replayLoadPos = 0;
+	replayLoadEnd = 0;
 
 	return true;
 }
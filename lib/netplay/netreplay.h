@@ -29,8 +29,16 @@ bool NETreplaySaveStart(std::string const& subdir, ReplayOptionsHandler const &o
 bool NETreplaySaveStop();
 void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player);
 
+/// A message of the replay being loaded. data points into the loaded replay, and is valid until NETreplayLoadStop().
+struct ReplayNetMessageView
+{
+	uint8_t type = 0xFF;
+	uint8_t const *data = nullptr;
+	size_t size = 0;
+};
+
 bool NETreplayLoadStart(std::string const &filename, ReplayOptionsHandler& optionsHandler, uint32_t& output_replayFormatVer);
-bool NETreplayLoadNetMessage(std::unique_ptr<NetMessage> &message, uint8_t &player);
+bool NETreplayLoadNetMessage(ReplayNetMessageView &message, uint8_t &player);
 bool NETreplayLoadStop();
 
 #endif // _NETREPLAY_H
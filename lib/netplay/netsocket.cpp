@@ -26,6 +26,7 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/wzapp.h"
 #include "netsocket.h"
+#include "netsocketpoller.h"
 
 #include <vector>
 #include <algorithm>
@@ -81,7 +82,12 @@ struct Socket
 
 struct SocketSet
 {
+	SocketSet() = default;
+	SocketSet(std::vector<Socket *> fds_) : fds(std::move(fds_)) {}  ///< A temporary set, which has no poller.
+
 	std::vector<Socket *> fds;
+	std::unique_ptr<SocketPoller> poller;      ///< Watches fds for reading, if allocated by allocSocketSet(). Otherwise checkSockets() uses select.
+	mutable std::vector<void *> ready;         ///< Results of poller->wait().
 };
 
 
@@ -91,6 +97,11 @@ static WZ_THREAD *socketThread = nullptr;
 static bool socketThreadQuit;
 typedef std::map<Socket *, std::vector<uint8_t>> SocketThreadWriteMap;
 static SocketThreadWriteMap socketThreadWrites;
+/// Watches the sockets in socketThreadWrites for becoming writable.
+static std::unique_ptr<SocketPoller> socketThreadPoller;
+
+/// epoll scales with the number of ready sockets instead of all of them, and has no FD_SETSIZE limit, which matters for hosts with many connections.
+static SOCKET_POLLER socketPollerType = socketPollerAvailable(SOCKET_POLLER::epoll) ? SOCKET_POLLER::epoll : SOCKET_POLLER::select;
 
 
 static void socketCloseNow(Socket *sock);
@@ -392,102 +403,112 @@ static bool connectionIsOpen(Socket *sock)
 	return true;
 }
 
-static int socketThreadFunction(void *)
+/// Queues data to be written by the socket thread. Must be called with socketThreadMutex locked.
+static void socketThreadQueueWrite(Socket *sock, uint8_t const *begin, uint8_t const *end)
 {
-	wzMutexLock(socketThreadMutex);
-	while (!socketThreadQuit)
+	if (socketThreadWrites.empty())
 	{
-#if   defined(WZ_OS_UNIX)
-		SOCKET maxfd = INT_MIN;
-#elif defined(WZ_OS_WIN)
-		SOCKET maxfd = 0;
-#endif
-		fd_set fds;
-		FD_ZERO(&fds);
-		for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
+		wzSemaphorePost(socketThreadSemaphore);
+	}
+	auto inserted = socketThreadWrites.insert(std::make_pair(sock, std::vector<uint8_t>()));
+	std::vector<uint8_t> &writeQueue = inserted.first->second;
+	writeQueue.insert(writeQueue.end(), begin, end);
+	if (inserted.second)
+	{
+		socketThreadPoller->add(sock->fd[SOCK_CONNECTION], sock);
+	}
+}
+
+/// Stops writing to a socket, because everything was written, or because of an error. Must be called with socketThreadMutex locked.
+static void socketThreadWriteDone(SocketThreadWriteMap::iterator w)
+{
+	Socket *sock = w->first;
+	socketThreadPoller->remove(sock->fd[SOCK_CONNECTION]);
+	socketThreadWrites.erase(w);
+	if (sock->deleteLater)
+	{
+		socketCloseNow(sock);
+	}
+}
+
+/// Writes queued data to a socket which is ready for writing. If drain, keeps writing until the socket would block,
+/// as needed for edge triggered readiness. Must be called with socketThreadMutex locked.
+static void socketThreadWrite(SocketThreadWriteMap::iterator w, bool drain)
+{
+	Socket *sock = w->first;
+	std::vector<uint8_t> &writeQueue = w->second;
+	ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
+
+	bool sentAny = false;
+	do
+	{
+		// Write data.
+		// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
+		ssize_t retSent = send(sock->fd[SOCK_CONNECTION], reinterpret_cast<char *>(&writeQueue[0]), writeQueue.size(), MSG_NOSIGNAL);
+		if (retSent != SOCKET_ERROR)
 		{
-			if (!i->second.empty())
+			// Erase as much data as written.
+			writeQueue.erase(writeQueue.begin(), writeQueue.begin() + retSent);
+			if (writeQueue.empty())
 			{
-				SOCKET fd = i->first->fd[SOCK_CONNECTION];
-				maxfd = std::max(maxfd, fd);
-				ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
-				FD_SET(fd, &fds);
+				socketThreadWriteDone(w);  // Nothing left to write, delete from pending list.
+				return;
 			}
+			sentAny = true;
+			continue;
 		}
-		struct timeval tv = {0, 50 * 1000};
 
+		switch (getSockErr())
+		{
+		case EAGAIN:
+#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
+		case EWOULDBLOCK:
+#endif
+			if (sentAny)
+			{
+				return;  // Wrote as much as fits, wait for the socket to become writable again.
+			}
+			if (!connectionIsOpen(sock))
+			{
+				debug(LOG_NET, "Socket error");
+				sock->writeError = true;
+				socketThreadWriteDone(w);  // Socket broken, don't try writing to it again.
+				return;
+			}
+			return;
+		case EINTR:
+			break;
+#if defined(EPIPE)
+		case EPIPE:
+#endif
+		default:
+			sock->writeError = true;
+			socketThreadWriteDone(w);  // Socket broken, don't try writing to it again.
+			return;
+		}
+	}
+	while (drain);
+}
+
+static int socketThreadFunction(void *)
+{
+	std::vector<void *> ready;
+
+	wzMutexLock(socketThreadMutex);
+	while (!socketThreadQuit)
+	{
 		// Check if we can write to any sockets.
 		wzMutexUnlock(socketThreadMutex);
-		int ret = select(maxfd + 1, nullptr, &fds, nullptr, &tv);
+		socketThreadPoller->wait(50, ready);
 		wzMutexLock(socketThreadMutex);
 
-		// We can write to some sockets. (Ignore errors from select, we may have deleted the socket after unlocking the mutex, and before calling select.)
-		if (ret > 0)
+		// We can write to some sockets. (Ignore errors, and sockets we are no longer writing to, we may have deleted the socket after unlocking the mutex, and before waiting.)
+		for (void *data : ready)
 		{
-			for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end();)
+			SocketThreadWriteMap::iterator w = socketThreadWrites.find(static_cast<Socket *>(data));
+			if (w != socketThreadWrites.end())
 			{
-				SocketThreadWriteMap::iterator w = i;
-				++i;
-
-				Socket *sock = w->first;
-				std::vector<uint8_t> &writeQueue = w->second;
-				ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
-
-				if (!FD_ISSET(sock->fd[SOCK_CONNECTION], &fds))
-				{
-					continue;  // This socket is not ready for writing, or we don't have anything to write.
-				}
-
-				// Write data.
-				// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
-				ssize_t retSent = send(sock->fd[SOCK_CONNECTION], reinterpret_cast<char *>(&writeQueue[0]), writeQueue.size(), MSG_NOSIGNAL);
-				if (retSent != SOCKET_ERROR)
-				{
-					// Erase as much data as written.
-					writeQueue.erase(writeQueue.begin(), writeQueue.begin() + retSent);
-					if (writeQueue.empty())
-					{
-						socketThreadWrites.erase(w);  // Nothing left to write, delete from pending list.
-						if (sock->deleteLater)
-						{
-							socketCloseNow(sock);
-						}
-					}
-				}
-				else
-				{
-					switch (getSockErr())
-					{
-					case EAGAIN:
-#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
-					case EWOULDBLOCK:
-#endif
-						if (!connectionIsOpen(sock))
-						{
-							debug(LOG_NET, "Socket error");
-							sock->writeError = true;
-							socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-							if (sock->deleteLater)
-							{
-								socketCloseNow(sock);
-							}
-							break;
-						}
-					case EINTR:
-						break;
-#if defined(EPIPE)
-					case EPIPE:
-#endif
-					default:
-						sock->writeError = true;
-						socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-						if (sock->deleteLater)
-						{
-							socketCloseNow(sock);
-						}
-						break;
-					}
-				}
+				socketThreadWrite(w, socketThreadPoller->isEdgeTriggered());
 			}
 		}
 
@@ -632,12 +653,7 @@ ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCoun
 		if (!sock->isCompressed)
 		{
 			wzMutexLock(socketThreadMutex);
-			if (socketThreadWrites.empty())
-			{
-				wzSemaphorePost(socketThreadSemaphore);
-			}
-			std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-			writeQueue.insert(writeQueue.end(), static_cast<char const *>(buf), static_cast<char const *>(buf) + size);
+			socketThreadQueueWrite(sock, static_cast<uint8_t const *>(buf), static_cast<uint8_t const *>(buf) + size);
 			wzMutexUnlock(socketThreadMutex);
 			rawBytes = size;
 		}
@@ -729,12 +745,7 @@ void socketFlush(Socket *sock, uint8_t player, size_t *rawByteCount)
 	}
 
 	wzMutexLock(socketThreadMutex);
-	if (socketThreadWrites.empty())
-	{
-		wzSemaphorePost(socketThreadSemaphore);
-	}
-	std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-	writeQueue.insert(writeQueue.end(), sock->zDeflateOutBuf.begin(), sock->zDeflateOutBuf.end());
+	socketThreadQueueWrite(sock, sock->zDeflateOutBuf.data(), sock->zDeflateOutBuf.data() + sock->zDeflateOutBuf.size());
 	wzMutexUnlock(socketThreadMutex);
 
 	// Primitive network logging, uncomment to use.
@@ -789,7 +800,9 @@ Socket::~Socket()
 
 SocketSet *allocSocketSet()
 {
-	return new SocketSet;
+	SocketSet *set = new SocketSet;
+	set->poller = makeSocketPoller(socketPollerType, SOCKET_POLL_EVENT::read);
+	return set;
 }
 
 void deleteSocketSet(SocketSet *set)
@@ -816,6 +829,8 @@ void SocketSet_AddSocket(SocketSet *set, Socket *socket)
 
 	set->fds.push_back(socket);
 	debug(LOG_NET, "Socket added: set->fds[%lu] = %p", (unsigned long)i, static_cast<void *>(socket));
+
+	set->poller->add(socket->fd[SOCK_CONNECTION], socket);
 }
 
 /**
@@ -828,6 +843,7 @@ void SocketSet_DelSocket(SocketSet *set, Socket *socket)
 	{
 		debug(LOG_NET, "Socket %p erased (set->fds[%lu])", static_cast<void *>(socket), (unsigned long)i);
 		set->fds.erase(set->fds.begin() + i);
+		set->poller->remove(socket->fd[SOCK_CONNECTION]);
 	}
 }
 
@@ -931,12 +947,6 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 		return 0;
 	}
 
-#if   defined(WZ_OS_UNIX)
-	SOCKET maxfd = INT_MIN;
-#elif defined(WZ_OS_WIN)
-	SOCKET maxfd = 0;
-#endif
-
 	bool compressedReady = false;
 	for (size_t i = 0; i < set->fds.size(); ++i)
 	{
@@ -947,8 +957,6 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 			compressedReady = true;
 			break;
 		}
-
-		maxfd = std::max(maxfd, set->fds[i]->fd[SOCK_CONNECTION]);
 	}
 
 	if (compressedReady)
@@ -964,33 +972,33 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 		return ret;
 	}
 
-	int ret;
-	fd_set fds;
-	do
+	std::unique_ptr<SocketPoller> temporaryPoller;
+	SocketPoller *poller = set->poller.get();
+	if (poller == nullptr)
 	{
-		struct timeval tv = {(int)(timeout / 1000), (int)(timeout % 1000) * 1000};  // Cast to int to avoid narrowing needed for C++11.
-
-		FD_ZERO(&fds);
-		for (size_t i = 0; i < set->fds.size(); ++i)
+		// A temporary set, built on the stack.
+		temporaryPoller = makeSocketPoller(SOCKET_POLLER::select, SOCKET_POLL_EVENT::read);
+		for (Socket *sock : set->fds)
 		{
-			const SOCKET fd = set->fds[i]->fd[SOCK_CONNECTION];
-
-			FD_SET(fd, &fds);
+			temporaryPoller->add(sock->fd[SOCK_CONNECTION], sock);
 		}
-
-		ret = select(maxfd + 1, &fds, nullptr, nullptr, &tv);
+		poller = temporaryPoller.get();
 	}
-	while (ret == SOCKET_ERROR && getSockErr() == EINTR);
 
+	int ret = poller->wait(timeout, set->ready);
 	if (ret == SOCKET_ERROR)
 	{
-		debug(LOG_ERROR, "select failed: %s", strSockError(getSockErr()));
+		debug(LOG_ERROR, "Waiting for sockets failed: %s", strSockError(getSockErr()));
 		return SOCKET_ERROR;
 	}
 
 	for (size_t i = 0; i < set->fds.size(); ++i)
 	{
-		set->fds[i]->ready = FD_ISSET(set->fds[i]->fd[SOCK_CONNECTION], &fds);
+		set->fds[i]->ready = false;
+	}
+	for (void *data : set->ready)
+	{
+		static_cast<Socket *>(data)->ready = true;
 	}
 
 	return ret;
@@ -1699,6 +1707,7 @@ void SOCKETinit()
 		socketThreadQuit = false;
 		socketThreadMutex = wzMutexCreate();
 		socketThreadSemaphore = wzSemaphoreCreate(0);
+		socketThreadPoller = makeSocketPoller(socketPollerType, SOCKET_POLL_EVENT::write);
 		socketThread = wzThreadCreate(socketThreadFunction, nullptr);
 		wzThreadStart(socketThread);
 	}
@@ -1717,6 +1726,7 @@ void SOCKETshutdown()
 		wzMutexDestroy(socketThreadMutex);
 		wzSemaphoreDestroy(socketThreadSemaphore);
 		socketThread = nullptr;
+		socketThreadPoller.reset();
 	}
 
 #if defined(WZ_OS_WIN)
@@ -1731,3 +1741,14 @@ void SOCKETshutdown()
 	}
 #endif
 }
+
+void socketSetPoller(SOCKET_POLLER type)
+{
+	ASSERT_OR_RETURN(, socketPollerAvailable(type), "Socket poller %d not available", (int)type);
+	socketPollerType = type;
+}
+
+SOCKET_POLLER socketGetPoller()
+{
+	return socketPollerType;
+}
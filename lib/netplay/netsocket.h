@@ -80,11 +80,23 @@ typedef struct addrinfo SocketAddress;
 static const int SOCKET_ERROR = -1;
 #endif
 
+/// How to wait for sockets to become ready.
+enum class SOCKET_POLLER
+{
+	select,     ///< Available everywhere. Rescans every socket on each call.
+	epoll,      ///< Linux only.
+};
+
 
 // Init/shutdown.
 void SOCKETinit();
 void SOCKETshutdown();
 
+// Waiting for sockets.
+bool socketPollerAvailable(SOCKET_POLLER type);                         ///< Returns whether the poller type can be used on this platform.
+void socketSetPoller(SOCKET_POLLER type);                               ///< Selects the poller for SocketSets allocated from now on, and for the socket write thread when SOCKETinit() next starts it.
+SOCKET_POLLER socketGetPoller();
+
 // General.
 int getSockErr();                                                       ///< Gets last socket error. (May be overwritten by functions that set errno.)
 void setSockErr(int error);                                             ///< Sets last socket error.
@@ -0,0 +1,237 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file netsocketpoller.cpp
+ *
+ * Waiting for sockets to become ready, with select or epoll.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "netsocketpoller.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(WZ_OS_LINUX)
+# include <sys/epoll.h>
+# define WZ_SOCKET_EPOLL
+#endif
+
+/// Rebuilds an fd_set of every socket on each call. Can't watch file descriptors at or above FD_SETSIZE.
+class SelectSocketPoller : public SocketPoller
+{
+public:
+	explicit SelectSocketPoller(SOCKET_POLL_EVENT event) : event(event) {}
+
+	void add(SOCKET fd, void *data) override
+	{
+		std::lock_guard<wz::mutex> lock(mutex);
+		ASSERT(std::find_if(sockets.begin(), sockets.end(), [fd](Watched const &w) { return w.fd == fd; }) == sockets.end(), "Duplicate file descriptor!");
+		sockets.push_back({fd, data});
+	}
+
+	void remove(SOCKET fd) override
+	{
+		std::lock_guard<wz::mutex> lock(mutex);
+		sockets.erase(std::remove_if(sockets.begin(), sockets.end(), [fd](Watched const &w) { return w.fd == fd; }), sockets.end());
+	}
+
+	int wait(unsigned timeout, std::vector<void *> &ready) override
+	{
+		ready.clear();
+		{
+			// Sockets may be added or removed while waiting, so wait for the ones watched now.
+			std::lock_guard<wz::mutex> lock(mutex);
+			waiting = sockets;
+		}
+		if (waiting.empty())
+		{
+			return 0;
+		}
+
+		int ret;
+		fd_set fds;
+		do
+		{
+			struct timeval tv = {(int)(timeout / 1000), (int)(timeout % 1000) * 1000};  // Cast to int to avoid narrowing needed for C++11.
+
+#if   defined(WZ_OS_UNIX)
+			SOCKET maxfd = INT_MIN;
+#elif defined(WZ_OS_WIN)
+			SOCKET maxfd = 0;
+#endif
+			FD_ZERO(&fds);
+			for (Watched const &w : waiting)
+			{
+				maxfd = std::max(maxfd, w.fd);
+				FD_SET(w.fd, &fds);
+			}
+
+			if (event == SOCKET_POLL_EVENT::read)
+			{
+				ret = select(maxfd + 1, &fds, nullptr, nullptr, &tv);
+			}
+			else
+			{
+				ret = select(maxfd + 1, nullptr, &fds, nullptr, &tv);
+			}
+		}
+		while (ret == SOCKET_ERROR && getSockErr() == EINTR);
+
+		if (ret == SOCKET_ERROR)
+		{
+			return SOCKET_ERROR;
+		}
+		for (Watched const &w : waiting)
+		{
+			if (FD_ISSET(w.fd, &fds))
+			{
+				ready.push_back(w.data);
+			}
+		}
+		return static_cast<int>(ready.size());
+	}
+
+	bool isEdgeTriggered() const override
+	{
+		return false;
+	}
+
+private:
+	struct Watched
+	{
+		SOCKET fd;
+		void *data;
+	};
+	SOCKET_POLL_EVENT event;
+	wz::mutex mutex;                ///< Protects sockets.
+	std::vector<Watched> sockets;
+	std::vector<Watched> waiting;   ///< Copy of sockets, for wait().
+};
+
+#if defined(WZ_SOCKET_EPOLL)
+/// Keeps the watched sockets in the kernel, so waiting only costs as much as the number of ready sockets.
+/// Writes are edge triggered, so that sockets with a backlog aren't reported on every call.
+class EpollSocketPoller : public SocketPoller
+{
+public:
+	explicit EpollSocketPoller(SOCKET_POLL_EVENT event)
+		: event(event)
+		, epollFd(epoll_create1(EPOLL_CLOEXEC))
+	{}
+
+	~EpollSocketPoller() override
+	{
+		if (epollFd != -1)
+		{
+			close(epollFd);
+		}
+	}
+
+	bool valid() const
+	{
+		return epollFd != -1;
+	}
+
+	void add(SOCKET fd, void *data) override
+	{
+		epoll_event ev;
+		ev.events = event == SOCKET_POLL_EVENT::read ? EPOLLIN : EPOLLOUT | EPOLLET;  // Adding a writable socket triggers an edge straight away.
+		ev.data.ptr = data;
+		if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+		{
+			debug(LOG_ERROR, "epoll_ctl failed: %s", strSockError(getSockErr()));
+			return;
+		}
+		++watched;
+	}
+
+	void remove(SOCKET fd) override
+	{
+		if (epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr) == 0)  // Fails harmlessly if the socket was already closed.
+		{
+			--watched;
+		}
+	}
+
+	int wait(unsigned timeout, std::vector<void *> &ready) override
+	{
+		ready.clear();
+		events.resize(std::max<size_t>(watched.load(), 1));
+		int ret;
+		do
+		{
+			ret = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), static_cast<int>(timeout));
+		}
+		while (ret == SOCKET_ERROR && getSockErr() == EINTR);
+
+		for (int n = 0; n < ret; ++n)
+		{
+			ready.push_back(events[n].data.ptr);  // Also reported on errors and hangups, like select.
+		}
+		return ret;
+	}
+
+	bool isEdgeTriggered() const override
+	{
+		return event == SOCKET_POLL_EVENT::write;
+	}
+
+private:
+	SOCKET_POLL_EVENT event;
+	int epollFd;
+	std::atomic<size_t> watched {0};
+	std::vector<epoll_event> events;  ///< Results of epoll_wait.
+};
+#endif
+
+std::unique_ptr<SocketPoller> makeSocketPoller(SOCKET_POLLER type, SOCKET_POLL_EVENT event)
+{
+#if defined(WZ_SOCKET_EPOLL)
+	if (type == SOCKET_POLLER::epoll)
+	{
+		std::unique_ptr<EpollSocketPoller> poller(new EpollSocketPoller(event));
+		if (poller->valid())
+		{
+			return std::unique_ptr<SocketPoller>(poller.release());
+		}
+		debug(LOG_WARNING, "epoll_create1 failed, using select: %s", strSockError(getSockErr()));
+	}
+#else
+	(void)type;
+#endif
+	return std::unique_ptr<SocketPoller>(new SelectSocketPoller(event));
+}
+
+bool socketPollerAvailable(SOCKET_POLLER type)
+{
+	switch (type)
+	{
+	case SOCKET_POLLER::select:
+		return true;
+	case SOCKET_POLLER::epoll:
+#if defined(WZ_SOCKET_EPOLL)
+		return true;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
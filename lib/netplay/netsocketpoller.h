@@ -0,0 +1,59 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file netsocketpoller.h
+ *
+ * Waiting for sockets to become ready, with select or epoll.
+ */
+#ifndef _net_socket_poller_h
+#define _net_socket_poller_h
+
+#include "netsocket.h"
+
+#include <memory>
+#include <vector>
+
+enum class SOCKET_POLL_EVENT
+{
+	read,       ///< Level triggered, a socket is ready while it has data (or an error) to read.
+	write,      ///< A socket is ready when it can be written to. Edge triggered if isEdgeTriggered().
+};
+
+/// Watches a set of sockets, and waits for some of them to become ready.
+/// Sockets may be added and removed by other threads during wait(), but a removed socket may still be reported by that call.
+class SocketPoller
+{
+public:
+	virtual ~SocketPoller() = default;
+
+	/// Starts watching fd. data is what wait() reports when it is ready.
+	virtual void add(SOCKET fd, void *data) = 0;
+	/// Stops watching fd. Must be called before closing it.
+	virtual void remove(SOCKET fd) = 0;
+	/// Waits up to timeout milliseconds for watched sockets to become ready, and sets ready to their data.
+	/// Returns the number of ready sockets, or SOCKET_ERROR.
+	virtual int wait(unsigned timeout, std::vector<void *> &ready) = 0;
+	/// If true, a ready socket is only reported again after it has been written to until it would block.
+	virtual bool isEdgeTriggered() const = 0;
+};
+
+/// Makes a poller of the given type, or a select poller if that type isn't available here.
+std::unique_ptr<SocketPoller> makeSocketPoller(SOCKET_POLLER type, SOCKET_POLL_EVENT event);
+
+#endif //_net_socket_poller_h
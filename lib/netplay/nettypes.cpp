@@ -63,7 +63,7 @@ static NetQueue *broadcastQueue = nullptr;
 // Only used between NETbegin{Encode,Decode} and NETend calls.
 static MessageWriter writer;  ///< Used when serialising a message.
 static MessageReader reader;  ///< Used when deserialising a message.
-static NetMessage message;    ///< A message which is being serialised or deserialised.
+static NetMessage message;    ///< A message which is being serialised.
 static NETQUEUE queueInfo;    ///< Indicates which queue is currently being (de)serialised.
 static PACKETDIR NetDir;      ///< Indicates whether a message is being serialised (PACKET_ENCODE) or deserialised (PACKET_DECODE), or not doing anything (PACKET_INVALID).
 
@@ -503,7 +503,8 @@ void NETbeginEncode(NETQUEUE queue, uint8_t type)
 	NETsetPacketDir(PACKET_ENCODE);
 
 	queueInfo = queue;
-	message = type;
+	message.type = type;
+	message.data.clear();  // Keeps the capacity, so serialising doesn't allocate once the buffer is big enough.
 	writer = MessageWriter(message);
 }
 
@@ -512,10 +513,9 @@ void NETbeginDecode(NETQUEUE queue, uint8_t type)
 	NETsetPacketDir(PACKET_DECODE);
 
 	queueInfo = queue;
-	message = receiveQueue(queueInfo)->getMessage();
-	reader = MessageReader(message);
+	reader = MessageReader(receiveQueue(queueInfo)->getMessage());  // Read in place, the message stays in the queue until NETpop().
 
-	assert(type == message.type);
+	assert(type == reader.message->type);
 }
 
 bool NETend()
@@ -861,33 +861,34 @@ bool NETloadReplay(std::string const &filename, ReplayOptionsHandler& optionsHan
 	{
 		return false;
 	}
-	std::unique_ptr<NetMessage> newMessage;
+	ReplayNetMessageView replayMessage;
 	uint8_t player;
 	bool gotReplayEnded = false;
-	while (NETreplayLoadNetMessage(newMessage, player))
+	while (NETreplayLoadNetMessage(replayMessage, player))
 	{
 		if ((player >= MAX_PLAYERS && player != NetPlay.hostPlayer) || gameQueues[player] == nullptr)
 		{
-			debug((newMessage->type != GAME_GAME_TIME) ? LOG_ERROR : LOG_INFO, "Skipping message to player %d in replay.", player);
+			debug((replayMessage.type != GAME_GAME_TIME) ? LOG_ERROR : LOG_INFO, "Skipping message to player %d in replay.", player);
 			continue;
 		}
-		if (newMessage->type == REPLAY_ENDED)
+		if (replayMessage.type == REPLAY_ENDED)
 		{
 			gotReplayEnded = true;
 			break;
 		}
-		gameQueues[player]->pushMessage(*newMessage);
+		// Copied straight from the loaded replay into the queue.
+		gameQueues[player]->pushMessage(replayMessage.type, replayMessage.data, replayMessage.size);
 	}
 	if (!gotReplayEnded && replayFormatVer >= 2)
 	{
 		debug(LOG_POPUP, _("Unable to load replay: The replay file is incomplete or corrupted."));
+		NETreplayLoadStop();
 		bIsReplay = true;
 		NETshutdownReplay();
 		return false;
 	}
 	// Add special REPLAY_ENDED message to the end of the host's gameQueue
-	newMessage = std::unique_ptr<NetMessage>(new NetMessage(REPLAY_ENDED));
-	gameQueues[NetPlay.hostPlayer]->pushMessage(*newMessage);
+	gameQueues[NetPlay.hostPlayer]->pushMessage(NetMessage(REPLAY_ENDED));
 	NETreplayLoadStop();
 	bIsReplay = true;
 	return true;
@@ -32,6 +32,7 @@
 #include "lib/netplay/netplay.h"
 
 #include "action.h"
+#include "ai.h"
 #include "combat.h"
 #include "geometry.h"
 #include "mission.h"
@@ -665,6 +666,48 @@ void actionSanity(DROID *psDroid)
 	}
 }
 
+// Queue the target searches actionUpdateDroid makes for droids which have nothing to shoot at, so that gridPrefetch can
+// run them in parallel. Uses the droid's action before this tick's update, so it is only a good guess.
+void actionPrefetchDroid(DROID *psDroid)
+{
+	if (psDroid->died || psDroid->numWeaps == 0 || isVtolDroid(psDroid) || psDroid->lastHitWeapon == WSC_EMP)
+	{
+		return;
+	}
+
+	const DROID_ORDER order = psDroid->order.type;
+	for (unsigned i = 0; i < psDroid->numWeaps; ++i)
+	{
+		if (psDroid->asWeaps[i].nStat == 0)
+		{
+			continue;
+		}
+		WEAPON_STATS const *psWeapStats = &asWeaponStats[psDroid->asWeaps[i].nStat];
+		bool search = false;
+		switch (psDroid->action)
+		{
+		case DACTION_NONE:
+		case DACTION_WAITFORREPAIR:
+			search = psWeapStats->rotate && (order == DORDER_NONE || order == DORDER_HOLD || order == DORDER_RTR || order == DORDER_GUARD);
+			break;
+		case DACTION_MOVE:
+		case DACTION_RETURNTOPOS:
+		case DACTION_FIRESUPPORT_RETREAT:
+			search = !DROID_STOPPED(psDroid) && psWeapStats->rotate && psWeapStats->fireOnMove;
+			break;
+		case DACTION_MOVEFIRE:
+			search = !DROID_STOPPED(psDroid) && psDroid->psActionTarget[i] == nullptr;
+			break;
+		default:
+			break;
+		}
+		if (search)
+		{
+			aiQueueTargetSearch(psDroid, i);
+		}
+	}
+}
+
 // Update the action state for a droid
 void actionUpdateDroid(DROID *psDroid)
 {
@@ -64,6 +64,9 @@ const char *getDroidActionName(DROID_ACTION action);
  */
 void actionUpdateDroid(DROID *psDroid);
 
+/** Queue the target searches actionUpdateDroid is likely to make this tick, see gridPrefetch(). */
+void actionPrefetchDroid(DROID *psDroid);
+
 /** Do sanity update only. Called from actionUpdateDroid() normally. */
 void actionSanity(DROID *psDroid);
 
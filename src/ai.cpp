@@ -540,6 +540,13 @@ static SDWORD targetAttackWeight(BASE_OBJECT *psTarget, BASE_OBJECT *psAttacker,
 }
 
 
+// Range searched by aiBestNearestTarget.
+static int aiBestNearestTargetRange(DROID *psDroid, int weapon_slot, int extraRange)
+{
+	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
+	return std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
+}
+
 // Find the best nearest target for a droid.
 // If extraRange is higher than zero, then this is the range it accepts for movement to target.
 // Returns integer representing target priority, -1 if failed
@@ -578,8 +585,7 @@ int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, i
 
 	electronic = electronicDroid(psDroid);
 
-	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
-	int droidRange = std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
+	int droidRange = aiBestNearestTargetRange(psDroid, weapon_slot, extraRange);
 
 	static GridList gridList;  // static to avoid allocations.
 	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, droidRange);
@@ -1076,22 +1082,9 @@ static bool updateAttackTarget(BASE_OBJECT *psAttacker, SDWORD weapon_slot)
 	return false;
 }
 
-/* Do the AI for a droid */
-void aiUpdateDroid(DROID *psDroid)
+/* Work out whether aiUpdateDroid looks for a new target (lookForTarget) or checks for a better one (updateTarget). */
+static void aiDroidTargetState(DROID *psDroid, bool &lookForTarget, bool &updateTarget)
 {
-	bool		lookForTarget, updateTarget;
-
-	ASSERT(psDroid != nullptr, "Invalid droid pointer");
-	if (!psDroid || isDead((BASE_OBJECT *)psDroid))
-	{
-		return;
-	}
-
-	if (psDroid->droidType != DROID_SENSOR && psDroid->numWeaps == 0)
-	{
-		return;
-	}
-
 	lookForTarget = false;
 	updateTarget = false;
 
@@ -1169,10 +1162,35 @@ void aiUpdateDroid(DROID *psDroid)
 	{
 		lookForTarget = false;
 	}
+}
+
+/* Whether aiUpdateDroid looks for a better target this tick. Only done once in a while. */
+static bool aiDroidUpdatesTargetNow(DROID const *psDroid, bool lookForTarget, bool updateTarget)
+{
+	return !lookForTarget && updateTarget && psDroid->numWeaps > 0 && !hasCommander(psDroid)
+	       && (psDroid->id + gameTime) / TARGET_UPD_SKIP_FRAMES != (psDroid->id + gameTime - deltaGameTime) / TARGET_UPD_SKIP_FRAMES;
+}
+
+/* Do the AI for a droid */
+void aiUpdateDroid(DROID *psDroid)
+{
+	bool		lookForTarget, updateTarget;
+
+	ASSERT(psDroid != nullptr, "Invalid droid pointer");
+	if (!psDroid || isDead((BASE_OBJECT *)psDroid))
+	{
+		return;
+	}
+
+	if (psDroid->droidType != DROID_SENSOR && psDroid->numWeaps == 0)
+	{
+		return;
+	}
+
+	aiDroidTargetState(psDroid, lookForTarget, updateTarget);
 
 	/* For commanders and non-assigned non-commanders: look for a better target once in a while */
-	if (!lookForTarget && updateTarget && psDroid->numWeaps > 0 && !hasCommander(psDroid)
-	    && (psDroid->id + gameTime) / TARGET_UPD_SKIP_FRAMES != (psDroid->id + gameTime - deltaGameTime) / TARGET_UPD_SKIP_FRAMES)
+	if (aiDroidUpdatesTargetNow(psDroid, lookForTarget, updateTarget))
 	{
 		for (unsigned i = 0; i < psDroid->numWeaps; ++i)
 		{
@@ -1212,6 +1230,41 @@ void aiUpdateDroid(DROID *psDroid)
 	}
 }
 
+// Queue the target search aiBestNearestTarget makes for a weapon, see gridPrefetch().
+void aiQueueTargetSearch(DROID *psDroid, int weapon_slot)
+{
+	gridQueuePrefetch(psDroid->pos.x, psDroid->pos.y, aiBestNearestTargetRange(psDroid, weapon_slot, 0));
+}
+
+// Queue the target searches aiUpdateDroid will make this tick, so that gridPrefetch can run them in parallel.
+void aiPrefetchDroid(DROID *psDroid)
+{
+	bool lookForTarget, updateTarget;
+
+	if (isDead(psDroid) || vtolEmpty(psDroid))
+	{
+		return;
+	}
+	// Same checks as aiUpdateDroid and aiBestNearestTarget.
+	if ((psDroid->asWeaps[0].nStat == 0 || psDroid->numWeaps == 0) && psDroid->droidType != DROID_SENSOR)
+	{
+		return;
+	}
+
+	aiDroidTargetState(psDroid, lookForTarget, updateTarget);
+	if (aiDroidUpdatesTargetNow(psDroid, lookForTarget, updateTarget))
+	{
+		for (unsigned i = 0; i < psDroid->numWeaps; ++i)
+		{
+			aiQueueTargetSearch(psDroid, i);
+		}
+	}
+	else if (lookForTarget && !updateTarget)
+	{
+		aiQueueTargetSearch(psDroid, 0);  // aiChooseTarget and aiChooseSensorTarget only search for the first weapon.
+	}
+}
+
 /* Check if any of our weapons can hit the target... */
 bool checkAnyWeaponsTarget(BASE_OBJECT *psObject, BASE_OBJECT *psTarget)
 {
@@ -63,6 +63,12 @@ bool aiShutdown();
 /* Do the AI for a droid */
 void aiUpdateDroid(DROID *psDroid);
 
+/* Queue the grid searches aiUpdateDroid will make this tick, see gridPrefetch() */
+void aiPrefetchDroid(DROID *psDroid);
+
+/* Queue the grid search aiBestNearestTarget makes for a weapon, see gridPrefetch() */
+void aiQueueTargetSearch(DROID *psDroid, int weapon_slot);
+
 // Find the nearest best target for a droid
 // returns integer representing quality of choice, -1 if failed
 int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, int extraRange = 0);
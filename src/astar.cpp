@@ -35,22 +35,33 @@
  *    is continued until the new source is reached.  If the new source is  not reached,
  *    the droid is  on a  different island than the previous droid,  and pathfinding is
  *    restarted from the first step.
- *  Up to 30 pathfinding maps from A* are cached, in a LRU list. The PathNode heap con-
- *  tains the  priority-heap-sorted  nodes which are to be explored.  The path back  is
- *  stored in the PathExploredTile 2D array of tiles.
+ *  Up to 32 pathfinding maps from A* are cached, in  LRU lists  split into lanes by the
+ *  destination tile,  so that several  path threads can  work at the same time without
+ *  the results depending on which thread did which job. The PathNode heap contains the
+ *  priority-heap-sorted nodes which are to be explored. The path back is stored in the
+ *  PathExploredTile 2D array of tiles.
+ *  Long routes which can't reuse a cached context are first planned on a graph of map
+ *  clusters (see pathcluster.h),  and each step of that plan is then routed with A*, so
+ *  that the explored area stays small.
  */
 
 #ifndef WZ_TESTING
 #include "lib/framework/frame.h"
+#include "lib/framework/wzprofile.h"
 
 #include "astar.h"
 #include "map.h"
+#include "pathcluster.h"
 #endif
 
 #include <list>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <chrono>
 #include <memory>
+#include <random>
 
 #include "lib/netplay/netplay.h"
 
@@ -98,6 +109,193 @@ struct PathNode
 	PathCoord p;                    // Map coords.
 	unsigned  dist, est;            // Distance so far and estimate to end.
 };
+/** The A* open list, giving the best PathNode (according to PathNode::operator <) first.
+ *
+ *  With FPATH_OPENLIST::heap, all nodes are in one binary heap. With FPATH_OPENLIST::buckets, nodes with estimates in a
+ *  window just above the best estimate are kept in one small heap per estimate value, and only the others are kept in the
+ *  binary heap. Since path costs are small integers, and the estimates of new nodes are rarely far above the best one,
+ *  most nodes go in the buckets. Either way, nodes come out in exactly the same order, so the routes are identical.
+ */
+class PathOpenList
+{
+public:
+	void reset(FPATH_OPENLIST type_)
+	{
+		type = type_;
+		heap.clear();
+		if (bucketCount != 0)
+		{
+			for (auto &bucket : buckets)
+			{
+				bucket.clear();
+			}
+			std::fill(std::begin(bucketUsed), std::end(bucketUsed), 0);
+			bucketCount = 0;
+		}
+		if (type == FPATH_OPENLIST::buckets)
+		{
+			buckets.resize(NUM_BUCKETS);
+		}
+	}
+	bool empty() const
+	{
+		return bucketCount == 0 && heap.empty();
+	}
+	void push(PathNode const &node)
+	{
+		if (type == FPATH_OPENLIST::buckets)
+		{
+			if (empty())
+			{
+				base = node.est;
+			}
+			if (node.est >= base && node.est - base < NUM_BUCKETS)
+			{
+				unsigned index = node.est % NUM_BUCKETS;
+				buckets[index].push_back(node);
+				std::push_heap(buckets[index].begin(), buckets[index].end());
+				bucketUsed[index / 64] |= uint64_t(1) << index % 64;
+				++bucketCount;
+				return;
+			}
+		}
+		heap.push_back(node);                        // Add the new node to nodes.
+		std::push_heap(heap.begin(), heap.end());    // Move the new node to the right place in the heap.
+	}
+	/// Takes the current best node, and removes it from the open list.
+	PathNode pop()
+	{
+		if (bucketCount == 0 && !heap.empty() && type == FPATH_OPENLIST::buckets)
+		{
+			rebase();
+		}
+		if (bucketCount != 0)
+		{
+			unsigned index = firstUsedBucket();
+			base += (index - base % NUM_BUCKETS + NUM_BUCKETS) % NUM_BUCKETS;  // No buckets before this one are used.
+			std::vector<PathNode> &bucket = buckets[index];
+			if (heap.empty() || heap.front() < bucket.front())
+			{
+				PathNode ret = bucket.front();
+				std::pop_heap(bucket.begin(), bucket.end());
+				bucket.pop_back();
+				if (bucket.empty())
+				{
+					bucketUsed[index / 64] &= ~(uint64_t(1) << index % 64);
+				}
+				--bucketCount;
+				return ret;
+			}
+		}
+		// find the node with the lowest distance
+		// if equal totals, give preference to node closer to target
+		PathNode ret = heap.front();
+
+		// remove the node from the list
+		std::pop_heap(heap.begin(), heap.end());  // Move the best node from the front of nodes to the back of nodes, preserving the heap properties, setting the front to the next best node.
+		heap.pop_back();                          // Pop the best node (which we will be returning).
+
+		return ret;
+	}
+	/// Changes the estimates of all nodes to estimate(node).
+	template <typename Estimate>
+	void reestimate(Estimate const &estimate)
+	{
+		std::vector<PathNode> all;
+		all.swap(heap);
+		for (auto &bucket : buckets)
+		{
+			all.insert(all.end(), bucket.begin(), bucket.end());
+		}
+		reset(type);
+		if (all.empty())
+		{
+			return;
+		}
+		for (auto &node : all)
+		{
+			node.est = estimate(node);
+		}
+		if (type == FPATH_OPENLIST::heap)
+		{
+			heap.swap(all);
+			std::make_heap(heap.begin(), heap.end());  // Changing the estimates breaks the heap ordering. Fix the heap ordering.
+			return;
+		}
+		// Push the lowest estimate first, so that the window starts there.
+		std::swap(all.front(), *std::min_element(all.begin(), all.end(), [](PathNode const &a, PathNode const &b) { return a.est < b.est; }));
+		for (auto const &node : all)
+		{
+			push(node);
+		}
+	}
+
+private:
+	enum { NUM_BUCKETS = 1024 };  ///< Width of the window of estimates kept in buckets.
+
+	/// Moves the window to start at the best node in the heap, and moves the nodes which fit into the buckets.
+	void rebase()
+	{
+		std::vector<PathNode> all;
+		all.swap(heap);
+		base = all.front().est;
+		for (auto const &node : all)
+		{
+			push(node);
+		}
+	}
+	/// Returns the used bucket with the lowest estimate.
+	unsigned firstUsedBucket() const
+	{
+		unsigned start = base % NUM_BUCKETS;
+		for (unsigned i = 0; i <= NUM_BUCKETS / 64; ++i)
+		{
+			unsigned word = (start / 64 + i) % (NUM_BUCKETS / 64);
+			uint64_t bits = bucketUsed[word];
+			if (i == 0)
+			{
+				bits &= ~uint64_t(0) << start % 64;  // Estimates from base upwards.
+			}
+			else if (i == NUM_BUCKETS / 64)
+			{
+				bits &= ~(~uint64_t(0) << start % 64);  // Wrapped around, highest estimates in the window.
+			}
+			if (bits != 0)
+			{
+				return word * 64 + lowestBit(bits);
+			}
+		}
+		ASSERT(false, "No used bucket found");
+		return start;
+	}
+	static unsigned lowestBit(uint64_t bits)
+	{
+		// De Bruijn sequence lookup of the index of the lowest set bit.
+		static const uint8_t index[64] =
+		{
+			0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+			62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+			63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+			46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+		};
+		return index[((bits & (~bits + 1)) * UINT64_C(0x03f79d71b4cb0a89)) >> 58];
+	}
+
+	FPATH_OPENLIST type = FPATH_OPENLIST::heap;
+	std::vector<PathNode> heap;                     ///< All nodes, or with FPATH_OPENLIST::buckets, the nodes outside the window.
+	std::vector<std::vector<PathNode>> buckets;     ///< Heap of nodes with each estimate from base to base + NUM_BUCKETS - 1, indexed by est % NUM_BUCKETS.
+	uint64_t bucketUsed[NUM_BUCKETS / 64] = {};     ///< Bit set for each non-empty bucket.
+	size_t bucketCount = 0;                         ///< Number of nodes in buckets.
+	unsigned base = 0;                              ///< Lowest estimate which can be in a bucket.
+};
+
+/// Open list implementation used by new searches.
+static std::atomic<FPATH_OPENLIST> fpathOpenListType(FPATH_OPENLIST::buckets);
+/// Whether hierarchical route planning is wanted, from the config.
+static std::atomic<bool> fpathHierarchical(false);
+/// Whether the game in progress uses hierarchical route planning. Changes routes, so must be the same for all players, and in replays.
+static std::atomic<bool> fpathHierarchicalGame(false);
+
 struct PathExploredTile
 {
 	PathExploredTile() : iteration(0xFFFF), dx(0), dy(0), dist(0), visited(false) {}
@@ -116,6 +314,77 @@ struct PathBlockingType
 	int owner;
 	FPATH_MOVETYPE moveType;
 };
+/** One bit per tile, with a border one tile wide around the map, and each row padded to whole 64-bit words.
+ *
+ *  Because of the border, the neighbours of any tile on the map can be read without bounds checks, and since the three
+ *  bits of a row of neighbours are always within two consecutive bytes, all 8 neighbours take only three reads.
+ */
+struct PathBitMap
+{
+	/// Allocates space for the map, clearing all tiles, and setting the border to borderValue.
+	void reset(int width, int height, bool borderValue)
+	{
+		stride = (width + 2 + 8 + 63) / 64 * 8;  // Bytes, leaving an extra byte at the end of each row for neighbour reads.
+		words.assign(stride / 8 * (height + 2), 0);
+		if (borderValue)
+		{
+			for (int x = -1; x <= width; ++x)
+			{
+				set(x, -1, true);
+				set(x, height, true);
+			}
+			for (int y = 0; y < height; ++y)
+			{
+				set(-1, y, true);
+				set(width, y, true);
+			}
+		}
+	}
+	void clear()
+	{
+		words.clear();
+		stride = 0;
+	}
+	bool empty() const
+	{
+		return words.empty();
+	}
+	bool get(int x, int y) const
+	{
+		size_t bit = x + 1;
+		return (bytes()[(y + 1) * stride + bit / 8] >> (bit % 8) & 1) != 0;
+	}
+	void set(int x, int y, bool value)
+	{
+		size_t bit = x + 1;
+		uint8_t &byte = reinterpret_cast<uint8_t *>(words.data())[(y + 1) * stride + bit / 8];
+		byte = (byte & ~(1 << (bit % 8))) | value << (bit % 8);
+	}
+	/// Returns tiles (x - 1, y), (x, y) and (x + 1, y) as bits 0, 1 and 2.
+	unsigned getRow3(int x, int y) const
+	{
+		uint8_t const *row = bytes() + (y + 1) * stride;
+		size_t bit = x;  // Bit of tile x - 1.
+		return ((row[bit / 8] | row[bit / 8 + 1] << 8) >> (bit % 8)) & 7;
+	}
+	/// Returns the 8 neighbours of the tile, with bit dir set if the tile at aDirOffset[dir] is set.
+	uint8_t getNeighbours(int x, int y) const
+	{
+		unsigned above = getRow3(x, y - 1);  // dir 3, 4, 5
+		unsigned middle = getRow3(x, y);     // dir 2, (self), 6
+		unsigned below = getRow3(x, y + 1);  // dir 1, 0, 7
+		return above << 3 | (middle & 1) << 2 | (middle & 4) << 4 | (below & 1) << 1 | (below & 2) >> 1 | (below & 4) << 5;
+	}
+
+	uint8_t const *bytes() const
+	{
+		return reinterpret_cast<uint8_t const *>(words.data());
+	}
+
+	std::vector<uint64_t> words;
+	size_t stride = 0;  ///< Bytes per row.
+};
+
 /// Pathfinding blocking map
 struct PathBlockingMap
 {
@@ -127,8 +396,9 @@ struct PathBlockingMap
 	}
 
 	PathBlockingType type;
-	std::vector<bool> map;
-	std::vector<bool> dangerMap;	// using threatBits
+	PathBitMap map;
+	PathBitMap dangerMap;	// using threatBits
+	std::shared_ptr<PathClusterGraph const> clusterGraph;  ///< Graph of map clusters for hierarchical path finding, null if that was off when the map was made.
 };
 
 struct PathNonblockingArea
@@ -147,6 +417,15 @@ struct PathNonblockingArea
 	{
 		return x >= x1 && x < x2 && y >= y1 && y < y2;
 	}
+	/// Returns true if any of the tiles next to (x, y) are nonblocking.
+	bool isNearNonblocking(int x, int y) const
+	{
+		return x + 1 >= x1 && x - 1 < x2 && y + 1 >= y1 && y - 1 < y2;
+	}
+	bool empty() const
+	{
+		return x1 >= x2 || y1 >= y2;
+	}
 
 	int16_t x1 = 0;
 	int16_t x2 = 0;
@@ -165,24 +444,34 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map.get(x, y);
+	}
+	/// Same as isBlocked for each neighbour of (x, y), with bit dir set if the tile at aDirOffset[dir] is blocked. (x, y) must be on the map.
+	uint8_t blockedNeighbours(int x, int y) const
+	{
+		uint8_t blocked = blockingMap->map.getNeighbours(x, y);
+		if (blocked != 0 && dstIgnore.isNearNonblocking(x, y))
+		{
+			blocked &= ~nonblockingNeighbours(x, y);
+		}
+		return blocked;
 	}
 	bool isDangerous(int x, int y) const
 	{
-		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap[x + y * mapWidth];
+		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap.get(x, y);
 	}
 	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
 	{
 		// Must check myGameTime == blockingMap_->type.gameTime, otherwise blockingMap could be a deleted pointer which coincidentally compares equal to the valid pointer blockingMap_.
 		return myGameTime == blockingMap_->type.gameTime && blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_;
 	}
-	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_)
+	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_, FPATH_OPENLIST openList)
 	{
 		blockingMap = blockingMap_;
 		tileS = tileS_;
 		dstIgnore = dstIgnore_;
 		myGameTime = blockingMap->type.gameTime;
-		nodes.clear();
+		nodes.reset(openList);
 
 		// Make the iteration not match any value of iteration in map.
 		if (++iteration == 0xFFFF)
@@ -204,19 +493,40 @@ struct PathfindContext
 	 */
 	uint16_t        iteration;
 
-	std::vector<PathNode> nodes;        ///< Edge of explored region of the map.
+	PathOpenList nodes;                 ///< Edge of explored region of the map.
 	std::vector<PathExploredTile> map;  ///< Map, with paths leading back to tileS.
 	std::shared_ptr<PathBlockingMap> blockingMap; ///< Map of blocking tiles for the type of object which needs a path.
 	PathNonblockingArea dstIgnore;      ///< Area of structure at destination which should be considered nonblocking.
+
+private:
+	uint8_t nonblockingNeighbours(int x, int y) const;
+};
+
+/// Contexts and scratch space used by a single lane. Only one path thread may use a lane at a time.
+struct PathfindLane
+{
+	std::list<PathfindContext> contexts;  ///< Last recently used list of contexts.
+	std::vector<Vector2i> path;           ///< Route being built, kept to save allocations.
+	PathfindContext refineContext;        ///< Context for routing the steps of hierarchical routes, not cached.
+	std::vector<Vector2i> waypoints;      ///< Steps of the hierarchical route being built.
 };
 
-/// Last recently used list of contexts.
-static std::list<PathfindContext> fpathContexts;
+/// Maximum number of contexts cached per lane.
+static const size_t fpathMaxContextsPerLane = 4;
+
+static PathfindLane fpathLanes[FPATH_CONTEXT_LANES];
 
 /// Lists of blocking maps from current tick.
 static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
 /// Game time for all blocking maps in fpathBlockingMaps.
 static uint32_t fpathCurrentGameTime;
+/// Cluster graph of the most recent blocking map of each type. Only used from the main thread.
+static std::vector<std::pair<PathBlockingType, std::shared_ptr<PathClusterGraph const>>> fpathClusterGraphs;
+
+/// Routes this far apart (in tiles, along either axis) are planned on the cluster graph first, if no cached context can be used.
+#define FPATH_CLUSTER_MIN_DISTANCE (2 * PATH_CLUSTER_SIZE)
+/// Most that hierarchical routes may add to the total length of the routes in fpathTestClusters(), compared to plain A*.
+#define FPATH_CLUSTER_MAX_TOTAL_RATIO 1.05
 
 // Convert a direction into an offset
 // dir 0 => x = 0, y = -1
@@ -232,26 +542,34 @@ static const Vector2i aDirOffset[] =
 	Vector2i(1, 1),
 };
 
+uint8_t PathfindContext::nonblockingNeighbours(int x, int y) const
+{
+	uint8_t nonblocking = 0;
+	for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+	{
+		nonblocking |= dstIgnore.isNonblocking(x + aDirOffset[dir].x, y + aDirOffset[dir].y) << dir;
+	}
+	return nonblocking;
+}
+
 void fpathHardTableReset()
 {
-	fpathContexts.clear();
+	for (auto &lane : fpathLanes)
+	{
+		lane.contexts.clear();
+		lane.path.clear();
+		lane.refineContext = PathfindContext();
+	}
 	fpathBlockingMaps.clear();
+	fpathClusterGraphs.clear();
 }
 
-/** Get the nearest entry in the open list
- */
-/// Takes the current best node, and removes from the node heap.
-static inline PathNode fpathTakeNode(std::vector<PathNode> &nodes)
+unsigned fpathContextLane(PATHJOB const *psJob)
 {
-	// find the node with the lowest distance
-	// if equal totals, give preference to node closer to target
-	PathNode ret = nodes.front();
-
-	// remove the node from the list
-	std::pop_heap(nodes.begin(), nodes.end());  // Move the best node from the front of nodes to the back of nodes, preserving the heap properties, setting the front to the next best node.
-	nodes.pop_back();                           // Pop the best node (which we will be returning).
-
-	return ret;
+	// Contexts are matched by destination tile, so every job which could reuse a context must end up in the same lane.
+	uint32_t x = map_coord(psJob->destX);
+	uint32_t y = map_coord(psJob->destY);
+	return ((x * 73856093u) ^ (y * 19349663u)) % FPATH_CONTEXT_LANES;
 }
 
 /** Estimate the distance to the target point
@@ -336,20 +654,15 @@ static inline void fpathNewNode(PathfindContext &context, PathCoord dest, PathCo
 	expl.visited = false;
 
 	// Add the node to the node heap.
-	context.nodes.push_back(node);                               // Add the new node to nodes.
-	std::push_heap(context.nodes.begin(), context.nodes.end());  // Move the new node to the right place in the heap.
+	context.nodes.push(node);
 }
 
 /// Recalculates estimates to new tileF tile.
 static void fpathAStarReestimate(PathfindContext &context, PathCoord tileF)
 {
-	for (auto &node : context.nodes)
-	{
-		node.est = node.dist + fpathGoodEstimate(node.p, tileF);
-	}
-
-	// Changing the estimates breaks the heap ordering. Fix the heap ordering.
-	std::make_heap(context.nodes.begin(), context.nodes.end());
+	context.nodes.reestimate([tileF](PathNode const &node) {
+		return node.dist + fpathGoodEstimate(node.p, tileF);
+	});
 }
 
 /// Returns nearest explored tile to tileF.
@@ -362,7 +675,7 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 	bool foundIt = false;
 	while (!context.nodes.empty() && !foundIt)
 	{
-		PathNode node = fpathTakeNode(context.nodes);
+		PathNode node = context.nodes.pop();
 		if (context.map[node.p.x + node.p.y * mapWidth].visited)
 		{
 			continue;  // Already been here.
@@ -383,9 +696,20 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 			foundIt = true;  // Break out of loop, but not before inserting neighbour nodes, since the neighbours may be important if the context gets reused.
 		}
 
+		// Find the blocking tiles around the node in one go, instead of checking each tile separately.
+		unsigned blocked = context.blockedNeighbours(node.p.x, node.p.y);
+		bool nodeIgnored = context.dstIgnore.isNonblocking(node.p.x, node.p.y);
+
 		// loop through possible moves in 8 directions to find a valid move
 		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
 		{
+			// See if the node is a blocking tile
+			if ((blocked & 1 << dir) != 0)
+			{
+				// tile is blocked, skip it
+				continue;
+			}
+
 			// Try a new location
 			int x = node.p.x + aDirOffset[dir].x;
 			int y = node.p.y + aDirOffset[dir].y;
@@ -398,32 +722,15 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 			   3  2  1
 			   odd:orthogonal-adjacent tiles even:non-orthogonal-adjacent tiles
 			*/
-			if (dir % 2 != 0 && !context.dstIgnore.isNonblocking(node.p.x, node.p.y) && !context.dstIgnore.isNonblocking(x, y))
+			if (dir % 2 != 0 && !nodeIgnored && !context.dstIgnore.isNonblocking(x, y))
 			{
-				int x2, y2;
-
 				// We cannot cut corners
-				x2 = node.p.x + aDirOffset[(dir + 1) % 8].x;
-				y2 = node.p.y + aDirOffset[(dir + 1) % 8].y;
-				if (context.isBlocked(x2, y2))
-				{
-					continue;
-				}
-				x2 = node.p.x + aDirOffset[(dir + 7) % 8].x;
-				y2 = node.p.y + aDirOffset[(dir + 7) % 8].y;
-				if (context.isBlocked(x2, y2))
+				if ((blocked & (1 << (dir + 1) % 8 | 1 << (dir + 7) % 8)) != 0)
 				{
 					continue;
 				}
 			}
 
-			// See if the node is a blocking tile
-			if (context.isBlocked(x, y))
-			{
-				// tile is blocked, skip it
-				continue;
-			}
-
 			// Now insert the point into the appropriate list, if not already visited.
 			fpathNewNode(context, tileF, PathCoord(x, y), node.dist, node.p);
 		}
@@ -432,17 +739,115 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 	return nearestCoord;
 }
 
-static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore)
+static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore, FPATH_OPENLIST openList = fpathOpenListType.load())
 {
-	context.assign(blockingMap, tileS, dstIgnore);
+	context.assign(blockingMap, tileS, dstIgnore, openList);
 
 	// Add the start point to the open list
 	fpathNewNode(context, tileF, tileRealS, 0, tileRealS);
 	ASSERT(!context.nodes.empty(), "fpathNewNode failed to add node.");
 }
 
+/// Appends the route from endCoord back to context.tileS to path, in world coordinates.
+static bool fpathAStarTraceBack(PathfindContext const &context, PathCoord endCoord, std::vector<Vector2i> &path)
+{
+	size_t start = path.size();
+	Vector2i newP(0, 0);
+	for (Vector2i p(world_coord(endCoord.x) + TILE_UNITS / 2, world_coord(endCoord.y) + TILE_UNITS / 2); true; p = newP)
+	{
+		ASSERT_OR_RETURN(false, worldOnMap(p.x, p.y), "Assigned XY coordinates (%d, %d) not on map!", (int)p.x, (int)p.y);
+		ASSERT_OR_RETURN(false, path.size() - start < (static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight)), "Pathfinding got in a loop.");
+
+		path.push_back(p);
+
+		PathExploredTile const &tile = context.map[map_coord(p.x) + map_coord(p.y) * mapWidth];
+		newP = p - Vector2i(tile.dx, tile.dy) * (TILE_UNITS / 64);
+		Vector2i mapP = map_coord(newP);
+		int xSide = newP.x - world_coord(mapP.x) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on right-hand side of the tile, or -1 if newP is on the left-hand side of the tile.
+		int ySide = newP.y - world_coord(mapP.y) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on bottom side of the tile, or -1 if newP is on the top side of the tile.
+		if (context.isBlocked(mapP.x + xSide, mapP.y))
+		{
+			newP.x = world_coord(mapP.x) + TILE_UNITS / 2; // Point too close to a blocking tile on left or right side, so move the point to the middle.
+		}
+		if (context.isBlocked(mapP.x, mapP.y + ySide))
+		{
+			newP.y = world_coord(mapP.y) + TILE_UNITS / 2; // Point too close to a blocking tile on rop or bottom side, so move the point to the middle.
+		}
+		if (map_coord(p) == Vector2i(context.tileS.x, context.tileS.y) || p == newP)
+		{
+			break;  // We stopped moving, because we reached the destination or the closest reachable tile to context.tileS. Give up now.
+		}
+	}
+	return true;
+}
+
+/// Returns true if the route should be planned on the cluster graph of the blocking map, instead of with plain A*.
+static bool fpathAStarUseClusters(PATHJOB const *psJob, PathCoord tileOrig, PathCoord tileDest, PathNonblockingArea const &dstIgnore)
+{
+	if (!fpathHierarchicalGame || psJob->blockingMap->clusterGraph == nullptr || !dstIgnore.empty())
+	{
+		return false;  // The cluster graph doesn't know about structures at the destination which should be ignored.
+	}
+	return std::max(abs(tileOrig.x - tileDest.x), abs(tileOrig.y - tileDest.y)) >= FPATH_CLUSTER_MIN_DISTANCE;
+}
+
+/** Plans the route on the cluster graph, and then routes each step of the plan with A*, setting path to the route.
+ *  Returns false if the destination can't be reached this way, in which case plain A* must be used instead.
+ */
+static bool fpathAStarClusterPath(PathfindLane &lane, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileOrig, PathCoord tileDest, std::vector<Vector2i> &path)
+{
+	if (!pathClusterRoute(*blockingMap->clusterGraph, Vector2i(tileOrig.x, tileOrig.y), Vector2i(tileDest.x, tileDest.y), lane.waypoints))
+	{
+		return false;
+	}
+
+	path.clear();
+	PathfindContext &context = lane.refineContext;
+	PathCoord from = tileOrig;
+	for (Vector2i const &waypoint : lane.waypoints)
+	{
+		// Search from the end of the step towards the start, so that tracing back gives the step in the right order.
+		PathCoord to(waypoint.x, waypoint.y);
+		fpathInitContext(context, blockingMap, to, to, from, PathNonblockingArea());
+		if (fpathAStarExplore(context, from) != from)
+		{
+			ASSERT(false, "Cluster graph route (%d, %d) -> (%d, %d) is not possible", from.x, from.y, to.x, to.y);
+			return false;
+		}
+		size_t stepStart = path.size();
+		if (!fpathAStarTraceBack(context, from, path))
+		{
+			return false;
+		}
+		if (stepStart > 0)
+		{
+			path.erase(path.begin() + stepStart);  // Already have a point in the tile where the previous step ended.
+		}
+		from = to;
+	}
+	return true;
+}
+
+/// Routes with fpathAStarClusterPath(), setting psMove->asPath. Returns false if plain A* must be used instead.
+static bool fpathAStarHierarchicalRoute(PathfindLane &lane, MOVE_CONTROL *psMove, PATHJOB *psJob, PathCoord tileOrig, PathCoord tileDest)
+{
+	std::vector<Vector2i> &path = lane.path;
+	if (!fpathAStarClusterPath(lane, psJob->blockingMap, tileOrig, tileDest, path))
+	{
+		return false;
+	}
+
+	// Found exact path, so use exact coordinates for last point, no reason to lose precision
+	path.back() = Vector2i(psJob->destX, psJob->destY);
+	psMove->asPath = path;
+	psMove->destination = path.back();
+	return true;
+}
+
 ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 {
+	WZ_PROFILE_ZONE("fpathAStarRoute");
+
 	ASR_RETVAL      retval = ASR_OK;
 
 	bool            mustReverse = true;
@@ -453,8 +858,10 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 	PathCoord endCoord;  // Either nearest coord (mustReverse = true) or orig (mustReverse = false).
 
-	std::list<PathfindContext>::iterator contextIterator = fpathContexts.begin();
-	for (contextIterator = fpathContexts.begin(); contextIterator != fpathContexts.end(); ++contextIterator)
+	PathfindLane &lane = fpathLanes[fpathContextLane(psJob)];
+	std::list<PathfindContext> &contexts = lane.contexts;
+	std::list<PathfindContext>::iterator contextIterator = contexts.begin();
+	for (contextIterator = contexts.begin(); contextIterator != contexts.end(); ++contextIterator)
 	{
 		if (!contextIterator->matches(psJob->blockingMap, tileDest, dstIgnore))
 		{
@@ -487,13 +894,19 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		break;  // Found the path! Don't search more contexts.
 	}
 
-	if (contextIterator == fpathContexts.end())
+	if (contextIterator == contexts.end() && fpathAStarUseClusters(psJob, tileOrig, tileDest, dstIgnore)
+	    && fpathAStarHierarchicalRoute(lane, psMove, psJob, tileOrig, tileDest))
+	{
+		return ASR_OK;
+	}
+
+	if (contextIterator == contexts.end())
 	{
 		// We did not find an appropriate context. Make one.
 
-		if (fpathContexts.size() < 30)
+		if (contexts.size() < fpathMaxContextsPerLane)
 		{
-			fpathContexts.push_back(PathfindContext());
+			contexts.push_back(PathfindContext());
 		}
 		--contextIterator;
 
@@ -513,34 +926,11 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Get route, in reverse order.
-	static std::vector<Vector2i> path;  // Declared static to save allocations.
+	std::vector<Vector2i> &path = lane.path;
 	path.clear();
-
-	Vector2i newP(0, 0);
-	for (Vector2i p(world_coord(endCoord.x) + TILE_UNITS / 2, world_coord(endCoord.y) + TILE_UNITS / 2); true; p = newP)
+	if (!fpathAStarTraceBack(context, endCoord, path))
 	{
-		ASSERT_OR_RETURN(ASR_FAILED, worldOnMap(p.x, p.y), "Assigned XY coordinates (%d, %d) not on map!", (int)p.x, (int)p.y);
-		ASSERT_OR_RETURN(ASR_FAILED, path.size() < (static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight)), "Pathfinding got in a loop.");
-
-		path.push_back(p);
-
-		PathExploredTile &tile = context.map[map_coord(p.x) + map_coord(p.y) * mapWidth];
-		newP = p - Vector2i(tile.dx, tile.dy) * (TILE_UNITS / 64);
-		Vector2i mapP = map_coord(newP);
-		int xSide = newP.x - world_coord(mapP.x) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on right-hand side of the tile, or -1 if newP is on the left-hand side of the tile.
-		int ySide = newP.y - world_coord(mapP.y) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on bottom side of the tile, or -1 if newP is on the top side of the tile.
-		if (context.isBlocked(mapP.x + xSide, mapP.y))
-		{
-			newP.x = world_coord(mapP.x) + TILE_UNITS / 2; // Point too close to a blocking tile on left or right side, so move the point to the middle.
-		}
-		if (context.isBlocked(mapP.x, mapP.y + ySide))
-		{
-			newP.y = world_coord(mapP.y) + TILE_UNITS / 2; // Point too close to a blocking tile on rop or bottom side, so move the point to the middle.
-		}
-		if (map_coord(p) == Vector2i(context.tileS.x, context.tileS.y) || p == newP)
-		{
-			break;  // We stopped moving, because we reached the destination or the closest reachable tile to context.tileS. Give up now.
-		}
+		return ASR_FAILED;
 	}
 	if (retval == ASR_OK)
 	{
@@ -588,9 +978,9 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Move context to beginning of last recently used list.
-	if (contextIterator != fpathContexts.begin())  // Not sure whether or not the splice is a safe noop, if equal.
+	if (contextIterator != contexts.begin())  // Not sure whether or not the splice is a safe noop, if equal.
 	{
-		fpathContexts.splice(fpathContexts.begin(), fpathContexts, contextIterator);
+		contexts.splice(contexts.begin(), contexts, contextIterator);
 	}
 
 	psMove->destination = psMove->asPath[path.size() - 1];
@@ -598,6 +988,22 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	return retval;
 }
 
+/// Updates the cluster graph for the blocking type, reusing the parts of the previous graph of the type which didn't change.
+static std::shared_ptr<PathClusterGraph const> fpathUpdateClusterGraph(PathBlockingType const &type, std::vector<uint8_t> &&tiles)
+{
+	auto i = std::find_if(fpathClusterGraphs.begin(), fpathClusterGraphs.end(), [&](std::pair<PathBlockingType, std::shared_ptr<PathClusterGraph const>> const &graph) {
+		return fpathIsEquivalentBlocking(graph.first.propulsion, graph.first.owner, graph.first.moveType,
+		                                 type.propulsion,       type.owner,       type.moveType);
+	});
+	if (i == fpathClusterGraphs.end())
+	{
+		fpathClusterGraphs.emplace_back(type, nullptr);
+		i = fpathClusterGraphs.end() - 1;
+	}
+	i->second = pathClusterUpdate(i->second, std::move(tiles), mapWidth, mapHeight);
+	return i->second;
+}
+
 void fpathSetBlockingMap(PATHJOB *psJob)
 {
 	if (fpathCurrentGameTime != gameTime)
@@ -626,26 +1032,52 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 
 		// blockMap now points to an empty map with no data. Fill the map.
 		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight));
+		PathBitMap &map = blockMap->map;
+		map.reset(mapWidth, mapHeight, true);  // Everything off the map is blocking.
+		// The cluster graph is only used by hierarchical path finding, so only pay for it when that is on. Checked per
+		// map, so turning it on mid-game builds the graphs from the next tick.
+		bool clusters = fpathHierarchicalGame;
+		std::vector<uint8_t> clusterTiles;
+		if (clusters)
+		{
+			clusterTiles.resize(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight));
+		}
+		else
+		{
+			fpathClusterGraphs.clear();
+		}
 		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
 		for (int y = 0; y < mapHeight; ++y)
 			for (int x = 0; x < mapWidth; ++x)
 			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
+				bool blocking = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+				map.set(x, y, blocking);
+				checksumMap ^= blocking * (factor = 3 * factor + 1);
+				if (clusters)
+				{
+					clusterTiles[x + y * mapWidth] = blocking ? PATH_CLUSTER_BLOCKED : 0;
+				}
 			}
 		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
 		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight));
+			PathBitMap &dangerMap = blockMap->dangerMap;
+			dangerMap.reset(mapWidth, mapHeight, false);
 			for (int y = 0; y < mapHeight; ++y)
 				for (int x = 0; x < mapWidth; ++x)
 				{
-					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
+					bool danger = (auxTile(x, y, type.owner) & AUXBITS_THREAT) != 0;
+					dangerMap.set(x, y, danger);
+					checksumDangerMap ^= danger * (factor = 3 * factor + 1);
+					if (clusters)
+					{
+						clusterTiles[x + y * mapWidth] |= danger ? PATH_CLUSTER_DANGER : 0;
+					}
 				}
 		}
+		if (clusters)
+		{
+			blockMap->clusterGraph = fpathUpdateClusterGraph(type, std::move(clusterTiles));
+		}
 		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
 
 		psJob->blockingMap = fpathBlockingMaps.back();
@@ -657,3 +1089,233 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 		psJob->blockingMap = *i;
 	}
 }
+
+/// Makes a blocking map for wheeled droids on the current map, for tests. Does not touch the blocking map cache, so doesn't affect sync.
+static std::shared_ptr<PathBlockingMap> fpathMakeTestBlockingMap()
+{
+	std::shared_ptr<PathBlockingMap> blockingMap = std::make_shared<PathBlockingMap>();
+	blockingMap->type.gameTime = gameTime;
+	blockingMap->type.propulsion = PROPULSION_TYPE_WHEELED;
+	blockingMap->type.owner = 0;
+	blockingMap->type.moveType = FMT_BLOCK;
+	blockingMap->map.reset(mapWidth, mapHeight, true);
+	for (int y = 0; y < mapHeight; ++y)
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			blockingMap->map.set(x, y, fpathBlockingTile(x, y, PROPULSION_TYPE_WHEELED));
+		}
+	return blockingMap;
+}
+
+void fpathBenchmarkBlockingMap()
+{
+	ASSERT_OR_RETURN(, mapWidth > 0 && mapHeight > 0, "No map loaded");
+
+	// The blocking map for wheeled droids on the current map, both as a PathBitMap and as the plain bit vector it replaced.
+	std::shared_ptr<PathBlockingMap> blockingMap = fpathMakeTestBlockingMap();
+	PathBitMap const &packedMap = blockingMap->map;
+	std::vector<bool> plainMap(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight));
+	for (int y = 0; y < mapHeight; ++y)
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			plainMap[x + y * mapWidth] = packedMap.get(x, y);
+		}
+
+	// Count the blocked neighbours of every tile, the way the A* inner loop used to, and the way it does now.
+	const int passes = 20;
+	unsigned plainCount = 0, packedCount = 0;
+	auto plainStart = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; ++pass)
+		for (int y = 0; y < mapHeight; ++y)
+			for (int x = 0; x < mapWidth; ++x)
+				for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+				{
+					int nx = x + aDirOffset[dir].x, ny = y + aDirOffset[dir].y;
+					plainCount += nx < 0 || ny < 0 || nx >= mapWidth || ny >= mapHeight || plainMap[nx + ny * mapWidth];
+				}
+	auto packedStart = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; ++pass)
+		for (int y = 0; y < mapHeight; ++y)
+			for (int x = 0; x < mapWidth; ++x)
+			{
+				uint8_t blocked = packedMap.getNeighbours(x, y);
+				for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+				{
+					packedCount += blocked >> dir & 1;
+				}
+			}
+	auto packedEnd = std::chrono::steady_clock::now();
+
+	long long plainUs = std::chrono::duration_cast<std::chrono::microseconds>(packedStart - plainStart).count();
+	long long packedUs = std::chrono::duration_cast<std::chrono::microseconds>(packedEnd - packedStart).count();
+	ASSERT(plainCount == packedCount, "Blocking maps disagree, %u != %u blocked neighbours", plainCount, packedCount);
+	debug(LOG_INFO, "Blocking map neighbour lookups on %dx%d map, %d passes: bit vector %lld us, packed map %lld us (%.2fx), %u blocked neighbours",
+	      mapWidth, mapHeight, passes, plainUs, packedUs, packedUs > 0 ? (double)plainUs / packedUs : 0., plainCount / passes);
+}
+
+bool fpathTestOpenLists(int numRoutes)
+{
+	ASSERT_OR_RETURN(false, mapWidth > 0 && mapHeight > 0, "No map loaded");
+
+	std::shared_ptr<PathBlockingMap> blockingMap = fpathMakeTestBlockingMap();
+	std::mt19937 rng(mapWidth * 65536 + mapHeight);  // Not gameRand, must not affect sync.
+	auto randomTile = [&]() {
+		return PathCoord(rng() % mapWidth, rng() % mapHeight);
+	};
+
+	// Each route is found from scratch, and then the same context is continued to another start, like fpathAStarRoute does.
+	const FPATH_OPENLIST types[] = {FPATH_OPENLIST::heap, FPATH_OPENLIST::buckets};
+	PathfindContext contexts[ARRAY_SIZE(types)];
+	std::vector<Vector2i> paths[ARRAY_SIZE(types)];
+	std::chrono::steady_clock::duration times[ARRAY_SIZE(types)] = {};
+	int routes = 0, mismatches = 0;
+	for (int i = 0; i < numRoutes; ++i)
+	{
+		PathCoord orig = randomTile(), dest = randomTile(), orig2 = randomTile();
+		if (blockingMap->map.get(orig.x, orig.y) || blockingMap->map.get(dest.x, dest.y) || blockingMap->map.get(orig2.x, orig2.y))
+		{
+			continue;
+		}
+		for (unsigned t = 0; t < ARRAY_SIZE(types); ++t)
+		{
+			auto start = std::chrono::steady_clock::now();
+			PathfindContext &context = contexts[t];
+			paths[t].clear();
+			fpathInitContext(context, blockingMap, orig, orig, dest, PathNonblockingArea(), types[t]);
+			PathCoord endCoord = fpathAStarExplore(context, dest);
+			fpathAStarTraceBack(context, endCoord, paths[t]);
+			fpathInitContext(context, blockingMap, dest, endCoord, orig, PathNonblockingArea(), types[t]);
+			fpathAStarExplore(context, orig);
+			fpathAStarReestimate(context, orig2);
+			endCoord = fpathAStarExplore(context, orig2);
+			fpathAStarTraceBack(context, endCoord, paths[t]);
+			times[t] += std::chrono::steady_clock::now() - start;
+		}
+		++routes;
+		if (paths[0] != paths[1])
+		{
+			++mismatches;
+			debug(LOG_ERROR, "Open lists give different routes (%d, %d) -> (%d, %d) -> (%d, %d)", orig.x, orig.y, dest.x, dest.y, orig2.x, orig2.y);
+		}
+	}
+
+	debug(LOG_INFO, "Open list test on %dx%d map: %d routes, %d mismatches, heap %lld us, buckets %lld us", mapWidth, mapHeight, routes, mismatches,
+	      (long long)std::chrono::duration_cast<std::chrono::microseconds>(times[0]).count(),
+	      (long long)std::chrono::duration_cast<std::chrono::microseconds>(times[1]).count());
+	return mismatches == 0;
+}
+
+/// Length of a route, in world units.
+static double fpathRouteLength(PathCoord orig, std::vector<Vector2i> const &path)
+{
+	double length = 0;
+	Vector2i prev = world_coord(Vector2i(orig.x, orig.y)) + Vector2i(TILE_UNITS / 2, TILE_UNITS / 2);
+	for (Vector2i const &p : path)
+	{
+		length += std::hypot(double(p.x - prev.x), double(p.y - prev.y));
+		prev = p;
+	}
+	return length;
+}
+
+bool fpathTestClusters(int numRoutes)
+{
+	ASSERT_OR_RETURN(false, mapWidth > 0 && mapHeight > 0, "No map loaded");
+
+	std::shared_ptr<PathBlockingMap> blockingMap = fpathMakeTestBlockingMap();
+	std::vector<uint8_t> clusterTiles(static_cast<size_t>(mapWidth) * static_cast<size_t>(mapHeight));
+	for (int y = 0; y < mapHeight; ++y)
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			clusterTiles[x + y * mapWidth] = blockingMap->map.get(x, y) ? PATH_CLUSTER_BLOCKED : 0;
+		}
+	blockingMap->clusterGraph = pathClusterUpdate(nullptr, std::move(clusterTiles), mapWidth, mapHeight);
+	std::mt19937 rng(mapWidth * 65536 + mapHeight);  // Not gameRand, must not affect sync.
+	auto randomTile = [&]() {
+		return PathCoord(rng() % mapWidth, rng() % mapHeight);
+	};
+
+	PathfindLane lane;
+	PathfindContext context;
+	std::vector<Vector2i> plainPath, clusterPath;
+	std::chrono::steady_clock::duration plainTime = {}, clusterTime = {};
+	int routes = 0, failures = 0;
+	double plainLength = 0, clusterLength = 0, worstRatio = 1;
+	for (int i = 0; i < numRoutes; ++i)
+	{
+		PathCoord orig = randomTile(), dest = randomTile();
+		if (blockingMap->map.get(orig.x, orig.y) || blockingMap->map.get(dest.x, dest.y)
+		    || std::max(abs(orig.x - dest.x), abs(orig.y - dest.y)) < FPATH_CLUSTER_MIN_DISTANCE)
+		{
+			continue;
+		}
+
+		// Plain A*, searching from the destination like fpathAStarRoute does.
+		auto start = std::chrono::steady_clock::now();
+		plainPath.clear();
+		fpathInitContext(context, blockingMap, dest, dest, orig, PathNonblockingArea());
+		bool reachable = fpathAStarExplore(context, orig) == orig;
+		fpathAStarTraceBack(context, orig, plainPath);
+		auto plainEnd = std::chrono::steady_clock::now();
+		if (!reachable)
+		{
+			continue;  // Different islands, plain A* would be used for the closest reachable tile anyway.
+		}
+
+		bool found = fpathAStarClusterPath(lane, blockingMap, orig, dest, clusterPath);
+		clusterTime += std::chrono::steady_clock::now() - plainEnd;
+		plainTime += plainEnd - start;
+		++routes;
+		if (!found || clusterPath.empty() || map_coord(clusterPath.back()) != Vector2i(dest.x, dest.y))
+		{
+			++failures;
+			debug(LOG_ERROR, "Cluster graph found no route (%d, %d) -> (%d, %d), but plain A* did", orig.x, orig.y, dest.x, dest.y);
+			continue;
+		}
+		double plain = fpathRouteLength(orig, plainPath), cluster = fpathRouteLength(orig, clusterPath);
+		plainLength += plain;
+		clusterLength += cluster;
+		if (plain > 0 && cluster / plain > worstRatio)
+		{
+			worstRatio = cluster / plain;
+			debug(LOG_INFO, "Cluster graph route (%d, %d) -> (%d, %d) is %.1f%% longer than plain A*", orig.x, orig.y, dest.x, dest.y, (worstRatio - 1) * 100);
+		}
+	}
+
+	double meanRatio = plainLength > 0 ? clusterLength / plainLength : 1;
+	debug(LOG_INFO, "Cluster test on %dx%d map: %d routes, %d failures, %.2f%% longer in total, %.2f%% longer at worst, plain A* %lld us, clusters %lld us",
+	      mapWidth, mapHeight, routes, failures, (meanRatio - 1) * 100, (worstRatio - 1) * 100,
+	      (long long)std::chrono::duration_cast<std::chrono::microseconds>(plainTime).count(),
+	      (long long)std::chrono::duration_cast<std::chrono::microseconds>(clusterTime).count());
+	return failures == 0 && meanRatio <= FPATH_CLUSTER_MAX_TOTAL_RATIO;
+}
+
+void fpathSetOpenListType(FPATH_OPENLIST type)
+{
+	fpathOpenListType = type;
+}
+
+FPATH_OPENLIST fpathGetOpenListType()
+{
+	return fpathOpenListType;
+}
+
+void fpathSetHierarchical(bool enabled)
+{
+	fpathHierarchical = enabled;
+}
+
+bool fpathGetHierarchical()
+{
+	return fpathHierarchical;
+}
+
+void fpathSetHierarchicalGame(bool enabled)
+{
+	fpathHierarchicalGame = enabled;
+}
+
+bool fpathGetHierarchicalGame()
+{
+	return fpathHierarchicalGame;
+}
@@ -34,7 +34,35 @@ enum ASR_RETVAL
 	ASR_NEAREST,    ///< found a partial route to a nearby position
 };
 
+/** Data structure used for the A* open list. Both give identical routes.
+ *
+ *  @ingroup pathfinding
+ */
+enum class FPATH_OPENLIST
+{
+	heap,           ///< Binary heap.
+	buckets,        ///< Bucket queue keyed on the route length estimate, with a binary heap for outliers.
+};
+
+/** Number of independent context caches used by fpathAStarRoute.
+ *
+ *  Jobs are split into lanes by destination. Jobs in the same lane must be routed one at a time, in the order they
+ *  were queued, but different lanes may be routed in parallel. The resulting paths do not depend on the number of
+ *  threads used.
+ *
+ *  @ingroup pathfinding
+ */
+#define FPATH_CONTEXT_LANES 8
+
+/** Returns which lane (between 0 and FPATH_CONTEXT_LANES - 1) the job must be routed in.
+ *
+ *  @ingroup pathfinding
+ */
+unsigned fpathContextLane(PATHJOB const *psJob);
+
 /** Use the A* algorithm to find a path
+ *
+ *  Thread-safe, as long as no two threads route jobs from the same lane at the same time.
  *
  *  @ingroup pathfinding
  */
@@ -52,4 +80,47 @@ void fpathSetBlockingMap(PATHJOB *psJob);
  */
 void fpathHardTableReset();
 
+/** Times neighbour lookups in the blocking map of the current map, against a plain bit vector, and logs the results.
+ *
+ *  @ingroup pathfinding
+ */
+void fpathBenchmarkBlockingMap();
+
+/** Finds random routes on the current map with each open list type, and checks that the routes are identical.
+ *
+ *  @return true if all routes were identical.
+ *  @ingroup pathfinding
+ */
+bool fpathTestOpenLists(int numRoutes);
+
+/** Finds random routes on the current map with plain A*, and again on the cluster graph, and compares their lengths.
+ *
+ *  @return true if the cluster graph found every route, and they weren't much longer in total.
+ *  @ingroup pathfinding
+ */
+bool fpathTestClusters(int numRoutes);
+
+/** Selects the open list used by path finding jobs started from now on. Thread-safe.
+ *
+ *  @ingroup pathfinding
+ */
+void fpathSetOpenListType(FPATH_OPENLIST type);
+FPATH_OPENLIST fpathGetOpenListType();
+
+/** Selects whether long routes should be planned on the cluster graph first, in games started from now on.
+ *  Hierarchical routes are close to, but not always as short as, the routes found by plain A*, so it is off by default.
+ *
+ *  @ingroup pathfinding
+ */
+void fpathSetHierarchical(bool enabled);
+bool fpathGetHierarchical();
+
+/** Selects whether the game in progress plans long routes on the cluster graph. Thread-safe.
+ *  Changes the routes, so it must be the same for all players, and when playing back a replay.
+ *
+ *  @ingroup pathfinding
+ */
+void fpathSetHierarchicalGame(bool enabled);
+bool fpathGetHierarchicalGame();
+
 #endif // __INCLUDED_SRC_ASTART_H__
@@ -0,0 +1,533 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * benchmark.cpp
+ *
+ * Times the parts of the game state update, for --benchmark.
+ */
+#include <3rdparty/json/json.hpp> // Must come before WZ includes
+
+#include <algorithm>
+#include <vector>
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/gamelib/gtime.h"
+#include "lib/netplay/netsocket.h"
+
+#include "astar.h"
+#include "benchmark.h"
+#include "droid.h"
+#include "map.h"
+#include "mapgrid.h"
+#include "multiplay.h"
+#include "objmem.h"
+#include "projectile.h"
+#include "random.h"
+#include "stats.h"
+
+#define BENCHMARK_STRESS_WEAPON      "MG1Mk1"
+#define BENCHMARK_STRESS_BODY        "Body1REC"
+#define BENCHMARK_STRESS_PROPULSION  "HalfTrack"
+#define BENCHMARK_STRESS_TARGETS     100                ///< Droids in the blob being fired at.
+#define BENCHMARK_STRESS_SPACING     40                 ///< Roughly the distance between droids in the blob.
+#define BENCHMARK_STRESS_SHOOTERS    32
+#define BENCHMARK_STRESS_RING        (TILE_UNITS * 4)   ///< Distance of the shooters from the middle of the blob.
+
+#define BENCHMARK_SOCKETS_PORT       2199               ///< Not the game port, so a game can run at the same time.
+#define BENCHMARK_SOCKETS_MESSAGE    512                ///< Bytes per message, about the size of a busy game tick.
+#define BENCHMARK_SOCKETS_ROUNDS     200                ///< Round trips per connection.
+#define BENCHMARK_SOCKETS_TIMEOUT    std::chrono::seconds(60)
+
+struct BenchmarkSection
+{
+	std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::duration thisTick = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::duration maxTick = std::chrono::steady_clock::duration::zero();
+};
+
+static const char *benchmarkSectionNames[BENCHMARK_NUM_SECTIONS] =
+{
+	"scripts",
+	"visibility",
+	"droids",
+	"structures",
+	"projectiles",
+	"objmem",
+	"tick",
+};
+
+static const char *benchmarkCounterNames[BENCHMARK_NUM_COUNTERS] =
+{
+	"radarSensors",
+	"radarDetectors",
+	"radarPairs",
+	"projectilesInFlight",
+	"projectileGridQueries",
+	"projectileCandidates",
+	"gridQueries",
+	"gridPrefetched",
+	"gridPrefetchHits",
+};
+
+static uint32_t benchmarkTickCount = 0;  ///< Ticks to run, 0 if not benchmarking.
+static uint32_t benchmarkTicksDone = 0;
+static BenchmarkSection benchmarkSections[BENCHMARK_NUM_SECTIONS];
+static uint64_t benchmarkCounters[BENCHMARK_NUM_COUNTERS];
+static std::chrono::steady_clock::time_point benchmarkStartTime;
+static bool benchmarkStarted = false;
+
+static uint32_t benchmarkStressRounds = 0;  ///< Rounds per second fired by the projectile stress test, 0 if disabled.
+static bool benchmarkStressPlaced = false;
+static int benchmarkStressWeapon = -1;
+static Vector2i benchmarkStressCentre(0, 0);
+static std::vector<uint32_t> benchmarkStressShooters;  ///< Ids of the shooting droids, sorted.
+static uint32_t benchmarkStressFired = 0;
+
+static uint32_t benchmarkSocketConnectionCount = 0;  ///< Connections for the socket benchmark, 0 if disabled.
+
+void benchmarkSetTicks(uint32_t ticks)
+{
+	benchmarkTickCount = ticks;
+	benchmarkTicksDone = 0;
+	benchmarkStarted = false;
+}
+
+uint32_t benchmarkTicks()
+{
+	return benchmarkTickCount;
+}
+
+void benchmarkAddTime(BENCHMARK_SECTION section, std::chrono::steady_clock::duration time)
+{
+	if (!benchmarkStarted)
+	{
+		benchmarkStartTime = std::chrono::steady_clock::now() - time;
+		benchmarkStarted = true;
+	}
+	benchmarkSections[section].thisTick += time;
+}
+
+void benchmarkCount(BENCHMARK_COUNTER counter, uint64_t count)
+{
+	if (benchmarkTickCount != 0)
+	{
+		benchmarkCounters[counter] += count;
+	}
+}
+
+void benchmarkSetProjectileStress(uint32_t roundsPerSecond)
+{
+	benchmarkStressRounds = roundsPerSecond;
+	benchmarkStressPlaced = false;
+	benchmarkStressShooters.clear();
+	benchmarkStressFired = 0;
+}
+
+static DROID *benchmarkStressAddDroid(DROID_TEMPLATE const *psTemplate, Vector2i pos, unsigned player)
+{
+	pos.x = clip(pos.x, TILE_UNITS, world_coord(mapWidth) - TILE_UNITS - 1);
+	pos.y = clip(pos.y, TILE_UNITS, world_coord(mapHeight) - TILE_UNITS - 1);
+	DROID *psDroid = reallyBuildDroid(psTemplate, Position(pos.x, pos.y, map_Height(pos)), player, false);
+	if (psDroid != nullptr)
+	{
+		addDroid(psDroid, apsDroidLists);
+	}
+	return psDroid;
+}
+
+/// Places the blob of player 1 droids in the middle of the map, and the ring of player 0 droids shooting at it.
+static bool benchmarkStressPlace()
+{
+	benchmarkStressWeapon = getCompFromName(COMP_WEAPON, BENCHMARK_STRESS_WEAPON);
+	int body = getCompFromName(COMP_BODY, BENCHMARK_STRESS_BODY);
+	int propulsion = getCompFromName(COMP_PROPULSION, BENCHMARK_STRESS_PROPULSION);
+	ASSERT_OR_RETURN(false, benchmarkStressWeapon >= 0 && body >= 0 && propulsion >= 0, "Missing stats for the projectile stress test");
+
+	DROID_TEMPLATE sTemplate;
+	sTemplate.name = WzString::fromUtf8("Benchmark");
+	sTemplate.asParts[COMP_BODY] = body;
+	sTemplate.asParts[COMP_PROPULSION] = propulsion;
+	sTemplate.asWeaps[0] = benchmarkStressWeapon;
+	sTemplate.numWeaps = 1;
+
+	benchmarkStressCentre = world_coord(Vector2i(mapWidth, mapHeight)) / 2;
+	for (int i = 0; i < BENCHMARK_STRESS_TARGETS; ++i)
+	{
+		Vector2i pos = benchmarkStressCentre + iSinCosR(40503 * i, iSqrt(BENCHMARK_STRESS_SPACING * BENCHMARK_STRESS_SPACING * i));  // 40503 = 65536/φ
+		benchmarkStressAddDroid(&sTemplate, pos, 1);
+	}
+	for (int i = 0; i < BENCHMARK_STRESS_SHOOTERS; ++i)
+	{
+		Vector2i pos = benchmarkStressCentre + iSinCosR(65536 * i / BENCHMARK_STRESS_SHOOTERS, BENCHMARK_STRESS_RING);
+		DROID *psDroid = benchmarkStressAddDroid(&sTemplate, pos, 0);
+		if (psDroid != nullptr)
+		{
+			benchmarkStressShooters.push_back(psDroid->id);
+		}
+	}
+	std::sort(benchmarkStressShooters.begin(), benchmarkStressShooters.end());
+	return !benchmarkStressShooters.empty();
+}
+
+void benchmarkProjectileStress()
+{
+	if (benchmarkTickCount == 0 || benchmarkStressRounds == 0 || NETisReplay())
+	{
+		return;  // Not in replays, the extra droids and random numbers would desync them.
+	}
+	if (!benchmarkStressPlaced)
+	{
+		benchmarkStressPlaced = true;
+		if (!benchmarkStressPlace())
+		{
+			benchmarkStressRounds = 0;
+			return;
+		}
+	}
+
+	std::vector<DROID *> shooters;
+	for (DROID *psDroid = apsDroidLists[0]; psDroid != nullptr; psDroid = psDroid->psNext)
+	{
+		if (!psDroid->died && std::binary_search(benchmarkStressShooters.begin(), benchmarkStressShooters.end(), psDroid->id))
+		{
+			shooters.push_back(psDroid);
+		}
+	}
+	if (shooters.empty())
+	{
+		return;
+	}
+
+	WEAPON sWeapon;
+	sWeapon.nStat = benchmarkStressWeapon;
+	int blobRadius = iSqrt(BENCHMARK_STRESS_SPACING * BENCHMARK_STRESS_SPACING * BENCHMARK_STRESS_TARGETS);
+	uint32_t rounds = benchmarkStressRounds * (benchmarkTicksDone + 1) / GAME_UPDATES_PER_SEC - benchmarkStressFired;
+	for (uint32_t i = 0; i < rounds; ++i)
+	{
+		Vector2i target = benchmarkStressCentre + iSinCosR(gameRand(65536), gameRand(blobRadius));
+		proj_SendProjectile(&sWeapon, shooters[i % shooters.size()], 0, Vector3i(target, map_Height(target) + TILE_UNITS / 8), nullptr, false, -1);
+	}
+	benchmarkStressFired += rounds;
+}
+
+static double benchmarkMicroseconds(std::chrono::steady_clock::duration time)
+{
+	return std::chrono::duration<double, std::micro>(time).count();
+}
+
+void benchmarkSetSocketConnections(uint32_t connections)
+{
+	benchmarkSocketConnectionCount = connections;
+}
+
+uint32_t benchmarkSocketConnections()
+{
+	return benchmarkSocketConnectionCount;
+}
+
+struct BenchmarkConnection
+{
+	Socket *client = nullptr;
+	Socket *server = nullptr;
+	size_t received = 0;            ///< Bytes echoed back to the client so far.
+	unsigned rounds = 0;            ///< Round trips completed.
+	std::chrono::steady_clock::time_point sent;
+};
+
+/// Opens the connections, each accepted by the listening socket.
+static bool benchmarkSocketsConnect(std::vector<BenchmarkConnection> &connections, Socket *listenSocket, SocketAddress *addr)
+{
+	for (BenchmarkConnection &c : connections)
+	{
+		c.client = socketOpen(addr, 5000);
+		ASSERT_OR_RETURN(false, c.client != nullptr, "Couldn't connect to the loopback benchmark socket");
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while ((c.server = socketAccept(listenSocket)) == nullptr)
+		{
+			ASSERT_OR_RETURN(false, std::chrono::steady_clock::now() < deadline, "Loopback benchmark connection not accepted");
+			wzYieldCurrentThread();
+		}
+	}
+	return true;
+}
+
+/// Reads what is ready, without blocking. Returns false if the connection broke.
+static bool benchmarkSocketsRead(Socket *sock, std::vector<uint8_t> &buffer, ssize_t &size)
+{
+	size = readNoInt(sock, buffer.data(), buffer.size());
+	if (size == SOCKET_ERROR && (getSockErr() == EAGAIN || getSockErr() == EWOULDBLOCK))
+	{
+		size = 0;
+		return true;
+	}
+	return size > 0;
+}
+
+/// Each client sends a message, and when the server has echoed all of it, sends the next one.
+static bool benchmarkSocketsRun(SOCKET_POLLER type, uint32_t count, nlohmann::json &result)
+{
+	socketSetPoller(type);
+	SOCKETinit();  // Starts the write thread, with this poller.
+
+	std::vector<BenchmarkConnection> connections(count);
+	SocketSet *clientSet = allocSocketSet();
+	SocketSet *serverSet = allocSocketSet();
+	SocketAddress *addr = resolveHost("127.0.0.1", BENCHMARK_SOCKETS_PORT);
+	Socket *listenSocket = socketListen(BENCHMARK_SOCKETS_PORT);
+	bool ok = addr != nullptr && listenSocket != nullptr && benchmarkSocketsConnect(connections, listenSocket, addr);
+
+	std::vector<uint8_t> message(BENCHMARK_SOCKETS_MESSAGE, 0x5A);
+	std::vector<uint8_t> buffer(65536);
+	std::vector<double> latencies;
+	latencies.reserve(count * BENCHMARK_SOCKETS_ROUNDS);
+	auto start = std::chrono::steady_clock::now();
+	if (ok)
+	{
+		for (BenchmarkConnection &c : connections)
+		{
+			SocketSet_AddSocket(clientSet, c.client);
+			SocketSet_AddSocket(serverSet, c.server);
+			c.sent = std::chrono::steady_clock::now();
+			writeAll(c.client, message.data(), message.size());
+		}
+	}
+	uint32_t active = ok ? count : 0;
+	while (active > 0 && ok)
+	{
+		if (std::chrono::steady_clock::now() - start > BENCHMARK_SOCKETS_TIMEOUT)
+		{
+			debug(LOG_ERROR, "Loopback benchmark timed out, %u connections still running", active);
+			ok = false;
+			break;
+		}
+
+		ssize_t size;
+		if (checkSockets(serverSet, 1) > 0)
+		{
+			for (BenchmarkConnection &c : connections)
+			{
+				if (!socketReadReady(c.server))
+				{
+					continue;
+				}
+				if (!benchmarkSocketsRead(c.server, buffer, size))
+				{
+					ok = false;
+					break;
+				}
+				if (size > 0)
+				{
+					writeAll(c.server, buffer.data(), size);  // Echo.
+				}
+			}
+		}
+		if (ok && checkSockets(clientSet, 1) > 0)
+		{
+			for (BenchmarkConnection &c : connections)
+			{
+				if (!socketReadReady(c.client))
+				{
+					continue;
+				}
+				if (!benchmarkSocketsRead(c.client, buffer, size))
+				{
+					ok = false;
+					break;
+				}
+				c.received += size;
+				if (c.rounds < BENCHMARK_SOCKETS_ROUNDS && c.received >= (c.rounds + 1) * message.size())
+				{
+					auto now = std::chrono::steady_clock::now();
+					latencies.push_back(benchmarkMicroseconds(now - c.sent));
+					if (++c.rounds < BENCHMARK_SOCKETS_ROUNDS)
+					{
+						c.sent = now;
+						writeAll(c.client, message.data(), message.size());
+					}
+					else
+					{
+						--active;
+					}
+				}
+			}
+		}
+	}
+	auto wallTime = std::chrono::steady_clock::now() - start;
+
+	for (BenchmarkConnection &c : connections)
+	{
+		if (c.client != nullptr)
+		{
+			SocketSet_DelSocket(clientSet, c.client);
+			socketClose(c.client);
+		}
+		if (c.server != nullptr)
+		{
+			SocketSet_DelSocket(serverSet, c.server);
+			socketClose(c.server);
+		}
+	}
+	if (listenSocket != nullptr)
+	{
+		socketClose(listenSocket);
+	}
+	if (addr != nullptr)
+	{
+		deleteSocketAddress(addr);
+	}
+	deleteSocketSet(clientSet);
+	deleteSocketSet(serverSet);
+	SOCKETshutdown();
+
+	if (!ok || latencies.empty())
+	{
+		return false;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	double totalLatency = 0;
+	for (double latency : latencies)
+	{
+		totalLatency += latency;
+	}
+	double bytes = 2. * latencies.size() * message.size();  // There and back.
+	result["wallTimeUs"] = benchmarkMicroseconds(wallTime);
+	result["throughputMBps"] = bytes / benchmarkMicroseconds(wallTime);
+	result["latencyMeanUs"] = totalLatency / latencies.size();
+	result["latencyP50Us"] = latencies[latencies.size() / 2];
+	result["latencyP99Us"] = latencies[latencies.size() * 99 / 100];
+	result["latencyMaxUs"] = latencies.back();
+	return true;
+}
+
+bool benchmarkSockets()
+{
+	uint32_t count = benchmarkSocketConnectionCount;
+	ASSERT_OR_RETURN(false, count > 0, "Socket benchmark not enabled");
+
+	nlohmann::json pollers = nlohmann::json::object();
+	const std::pair<SOCKET_POLLER, const char *> types[] = {{SOCKET_POLLER::select, "select"}, {SOCKET_POLLER::epoll, "epoll"}};
+	SOCKET_POLLER oldType = socketGetPoller();
+	bool ok = true;
+	for (auto const &type : types)
+	{
+		if (!socketPollerAvailable(type.first))
+		{
+			continue;
+		}
+		if (type.first == SOCKET_POLLER::select && count * 2 + 16 > FD_SETSIZE)
+		{
+			pollers[type.second] = "too many sockets for select";  // Would overflow the fd_set.
+			continue;
+		}
+		nlohmann::json result = nlohmann::json::object();
+		if (!benchmarkSocketsRun(type.first, count, result))
+		{
+			debug(LOG_ERROR, "Loopback benchmark failed with %s", type.second);
+			ok = false;
+			break;
+		}
+		pollers[type.second] = result;
+	}
+	socketSetPoller(oldType);
+
+	nlohmann::json result = nlohmann::json::object();
+	result["connections"] = count;
+	result["roundsPerConnection"] = BENCHMARK_SOCKETS_ROUNDS;
+	result["messageBytes"] = BENCHMARK_SOCKETS_MESSAGE;
+	result["pollers"] = pollers;
+	fprintf(stdout, "%s\n", result.dump(1).c_str());
+	fflush(stdout);
+	return ok;
+}
+
+static void benchmarkPrintResults()
+{
+	auto wallTime = std::chrono::steady_clock::now() - benchmarkStartTime;
+
+	unsigned droids = 0, structures = 0, features = 0;
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext, ++droids) {}
+		for (STRUCTURE *psStruct = apsStructLists[player]; psStruct != nullptr; psStruct = psStruct->psNext, ++structures) {}
+	}
+	for (FEATURE *psFeat = apsFeatureLists[0]; psFeat != nullptr; psFeat = psFeat->psNext, ++features) {}
+
+	nlohmann::json sections = nlohmann::json::object();
+	for (int i = 0; i < BENCHMARK_NUM_SECTIONS; ++i)
+	{
+		BenchmarkSection const &section = benchmarkSections[i];
+		nlohmann::json s = nlohmann::json::object();
+		s["totalUs"] = benchmarkMicroseconds(section.total);
+		s["meanUs"] = benchmarkMicroseconds(section.total) / std::max<uint32_t>(benchmarkTicksDone, 1);
+		s["maxUs"] = benchmarkMicroseconds(section.maxTick);
+		sections[benchmarkSectionNames[i]] = s;
+	}
+
+	nlohmann::json counters = nlohmann::json::object();
+	for (int i = 0; i < BENCHMARK_NUM_COUNTERS; ++i)
+	{
+		nlohmann::json c = nlohmann::json::object();
+		c["total"] = benchmarkCounters[i];
+		c["mean"] = double(benchmarkCounters[i]) / std::max<uint32_t>(benchmarkTicksDone, 1);
+		counters[benchmarkCounterNames[i]] = c;
+	}
+
+	nlohmann::json result = nlohmann::json::object();
+	result["map"] = game.map;
+	result["ticks"] = benchmarkTicksDone;
+	result["gameTime"] = gameTime;
+	result["wallTimeUs"] = benchmarkMicroseconds(wallTime);
+	result["droids"] = droids;
+	result["structures"] = structures;
+	result["features"] = features;
+	result["sections"] = sections;
+	result["counters"] = counters;
+	result["gridPrefetch"] = gridGetPrefetch();
+	result["pathHierarchical"] = fpathGetHierarchicalGame();
+	result["pathClusterTest"] = fpathTestClusters(500);  // After the timings, doesn't affect them.
+	if (benchmarkStressRounds != 0)
+	{
+		result["projectileStressRoundsPerSecond"] = benchmarkStressRounds;
+	}
+
+	fprintf(stdout, "%s\n", result.dump(1).c_str());
+	fflush(stdout);
+}
+
+void benchmarkTickDone()
+{
+	if (benchmarkTickCount == 0 || benchmarkTicksDone >= benchmarkTickCount)
+	{
+		return;
+	}
+
+	for (BenchmarkSection &section : benchmarkSections)
+	{
+		section.total += section.thisTick;
+		section.maxTick = std::max(section.maxTick, section.thisTick);
+		section.thisTick = std::chrono::steady_clock::duration::zero();
+	}
+
+	if (++benchmarkTicksDone == benchmarkTickCount)
+	{
+		benchmarkPrintResults();
+		wzQuit(0);
+	}
+}
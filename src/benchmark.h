@@ -0,0 +1,118 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Simulation benchmark (--benchmark).
+ *
+ *  Runs the game for a fixed number of ticks, timing each part of gameStateUpdate(), then prints the timings as JSON
+ *  to stdout and quits.
+ *
+ *  With --benchmark-sockets, times the network sockets over loopback connections instead.
+ */
+
+#ifndef __INCLUDED_SRC_BENCHMARK_H__
+#define __INCLUDED_SRC_BENCHMARK_H__
+
+#include <chrono>
+#include <cstdint>
+
+/// Random seed used for skirmish games when benchmarking, so that each run simulates the same game.
+#define BENCHMARK_SEED 0x5EED2100
+
+/// Parts of gameStateUpdate() which are timed.
+enum BENCHMARK_SECTION
+{
+	BENCHMARK_SCRIPTS,
+	BENCHMARK_VISIBILITY,
+	BENCHMARK_DROIDS,
+	BENCHMARK_STRUCTURES,
+	BENCHMARK_PROJECTILES,
+	BENCHMARK_OBJMEM,
+	BENCHMARK_TICK,         ///< All of gameStateUpdate().
+	BENCHMARK_NUM_SECTIONS
+};
+
+/// Work counters, to check that the cost of something scales as expected.
+enum BENCHMARK_COUNTER
+{
+	BENCHMARK_RADAR_SENSORS,    ///< Objects in apsSensorList.
+	BENCHMARK_RADAR_DETECTORS,  ///< Radar detectors checked for active radars in range.
+	BENCHMARK_RADAR_PAIRS,      ///< Detector and active radar pairs which had their distance checked.
+	BENCHMARK_PROJECTILES_IN_FLIGHT,    ///< Projectiles checked for collisions.
+	BENCHMARK_PROJECTILE_GRID_QUERIES,  ///< Grid queries done to find objects projectiles might collide with.
+	BENCHMARK_PROJECTILE_CANDIDATES,    ///< Projectile and object pairs which were checked for collisions.
+	BENCHMARK_GRID_QUERIES,             ///< Unfiltered gridStartIterate() calls.
+	BENCHMARK_GRID_PREFETCHED,          ///< Grid queries run in parallel by gridPrefetch().
+	BENCHMARK_GRID_PREFETCH_HITS,       ///< gridStartIterate() calls answered from a prefetched query.
+	BENCHMARK_NUM_COUNTERS
+};
+
+/// Enables benchmarking, quitting after the given number of game ticks. 0 disables it.
+void benchmarkSetTicks(uint32_t ticks);
+/// Returns the number of ticks to benchmark, or 0 if not benchmarking.
+uint32_t benchmarkTicks();
+
+/// Enables the projectile stress test, which places a blob of droids in the middle of the map, surrounded by droids
+/// firing the given number of machinegun rounds per second at it. Only has an effect when benchmarking.
+void benchmarkSetProjectileStress(uint32_t roundsPerSecond);
+/// Fires this tick's rounds of the projectile stress test, if enabled. Called before updating the projectiles.
+void benchmarkProjectileStress();
+
+/// Enables the loopback socket benchmark (--benchmark-sockets), which runs instead of a game, with the given number of connections.
+void benchmarkSetSocketConnections(uint32_t connections);
+/// Returns the number of connections for the socket benchmark, or 0 if not enabled.
+uint32_t benchmarkSocketConnections();
+/// Echoes messages over loopback connections with each available socket poller, then prints throughput and round trip
+/// latency as JSON. Returns false if the connections couldn't be made or broke.
+bool benchmarkSockets();
+
+/// Called at the end of each gameStateUpdate(). Prints the results and quits when done.
+void benchmarkTickDone();
+
+void benchmarkAddTime(BENCHMARK_SECTION section, std::chrono::steady_clock::duration time);
+/// Adds to a counter, if benchmarking.
+void benchmarkCount(BENCHMARK_COUNTER counter, uint64_t count);
+
+/// Adds the time until going out of scope to a section, if benchmarking.
+class BenchmarkTimer
+{
+public:
+	explicit BenchmarkTimer(BENCHMARK_SECTION section)
+		: section(section)
+		, enabled(benchmarkTicks() != 0)
+	{
+		if (enabled)
+		{
+			start = std::chrono::steady_clock::now();
+		}
+	}
+	~BenchmarkTimer()
+	{
+		if (enabled)
+		{
+			benchmarkAddTime(section, std::chrono::steady_clock::now() - start);
+		}
+	}
+
+private:
+	BENCHMARK_SECTION section;
+	bool enabled;
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif // __INCLUDED_SRC_BENCHMARK_H__
@@ -78,6 +78,10 @@ static CHEAT_ENTRY cheatCodes[] =
 	{"time toggle", kf_ToggleMissionTimer},
 	{"work harder", kf_FinishResearch},
 	{"tileinfo", kf_TileInfo}, // output debug info about a tile
+	{"pathbench", kf_BenchmarkPathBlockingMap}, // time path finding blocking map lookups
+	{"pathopenlist", kf_TestPathOpenLists}, // compare routes from the path finding open list types
+	{"pathclusters", kf_TestPathClusters}, // compare hierarchical routes against plain A*
+	{"profile", kf_ToggleProfiler}, // start the simulation profiler, or stop it and write a Chrome trace
 	{"showfps", kf_ToggleFPS},	//displays your average FPS
 	{"showunits", kf_ToggleUnitCount},	//displays unit count information
 	{"showsamples", kf_ToggleSamples}, //displays the # of Sound samples in Queue & List
@@ -31,6 +31,8 @@
 #include "lib/ivis_opengl/pieclip.h"
 
 #include "levels.h"
+#include "benchmark.h"
+#include "replayverify.h"
 #include "clparse.h"
 #include "display3d.h"
 #include "frontend.h"
@@ -349,6 +351,10 @@ typedef enum
 	CLI_ADD_LOBBY_ADMINPUBLICKEY,
 	CLI_COMMAND_INTERFACE,
 	CLI_STARTPLAYERS,
+	CLI_BENCHMARK,
+	CLI_BENCHMARK_PROJECTILES,
+	CLI_BENCHMARK_SOCKETS,
+	CLI_VERIFYREPLAY,
 } CLI_OPTIONS;
 
 static const struct poptOption *getOptionsTable()
@@ -417,6 +423,10 @@ static const struct poptOption *getOptionsTable()
 		{ "addlobbyadminpublickey", POPT_ARG_STRING, CLI_ADD_LOBBY_ADMINPUBLICKEY, N_("Add a lobby admin public key (for slash commands)"), N_("b64-pub-key")},
 		{ "enablecmdinterface", POPT_ARG_STRING, CLI_COMMAND_INTERFACE, N_("Enable command interface"), N_("(stdin)")},
 		{ "startplayers", POPT_ARG_STRING, CLI_STARTPLAYERS, N_("Minimum required players to auto-start game"), N_("startplayers")},
+		{ "benchmark", POPT_ARG_STRING, CLI_BENCHMARK, N_("Run the game headless for the given number of ticks, then print timings as JSON and quit (use with --skirmish or --loadreplay)"), N_("ticks")},
+		{ "benchmark-projectiles", POPT_ARG_STRING, CLI_BENCHMARK_PROJECTILES, N_("With --benchmark on a skirmish (not a replay), fire the given number of machinegun rounds per second at a blob of droids in the middle of the map"), N_("rounds")},
+		{ "benchmark-sockets", POPT_ARG_STRING, CLI_BENCHMARK_SOCKETS, N_("Echo messages over the given number of loopback connections with each socket poller (select, epoll), then print the throughput and latency as JSON and quit"), N_("connections")},
+		{ "verifyreplay", POPT_ARG_NONE, CLI_VERIFYREPLAY, N_("Play the replay given with --loadreplay headless as fast as possible, checking the recorded sync CRCs, then print the result as JSON and quit (non-zero exit code on a desync, or if the replay ends early)"), nullptr},
 		// Terminating entry
 		{ nullptr, 0, 0,              nullptr,                                    nullptr },
 	};
@@ -565,6 +575,8 @@ bool ParseCommandLine(int argc, const char * const *argv)
 {
 	poptContext poptCon = poptGetContext(nullptr, argc, argv, getOptionsTable(), 0);
 	int iOption;
+	bool loadReplay = false;
+	bool projectileStress = false;
 
 	/* loop through command line */
 	while ((iOption = poptGetNextOpt(poptCon)) > 0)
@@ -786,6 +798,7 @@ bool ParseCommandLine(int argc, const char * const *argv)
 			bMultiPlayer = true;
 			game.maxPlayers = 4; //DEFAULTSKIRMISHMAPMAXPLAYERS;
 			SetGameMode(GS_SAVEGAMELOAD);
+			loadReplay = true;
 			break;
 		}
 		case CLI_CONTINUE:
@@ -986,9 +999,53 @@ bool ParseCommandLine(int argc, const char * const *argv)
 			debug(LOG_INFO, "Games will automatically start with [%d] players (when ready)", wz_min_autostart_players);
 			break;
 
+		case CLI_BENCHMARK:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr || atoi(token) <= 0)
+			{
+				qFatal("Bad benchmark tick count");
+			}
+			benchmarkSetTicks(atoi(token));
+			wz_cli_headless = true;
+			setHeadlessGameMode(true);
+			break;
+
+		case CLI_BENCHMARK_PROJECTILES:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr || atoi(token) <= 0)
+			{
+				qFatal("Bad benchmark projectile count");
+			}
+			benchmarkSetProjectileStress(atoi(token));
+			projectileStress = true;
+			break;
+
+		case CLI_BENCHMARK_SOCKETS:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr || atoi(token) <= 0)
+			{
+				qFatal("Bad benchmark socket connection count");
+			}
+			benchmarkSetSocketConnections(atoi(token));
+			wz_cli_headless = true;
+			setHeadlessGameMode(true);
+			break;
+
+		case CLI_VERIFYREPLAY:
+			replayVerifySetEnabled(true);
+			wz_cli_headless = true;
+			setHeadlessGameMode(true);
+			break;
+
 		};
 	}
 
+	if (loadReplay && projectileStress)
+	{
+		// The stress test adds droids and uses gameRand(), which would make the replay desync.
+		qFatal("--benchmark-projectiles can't be used with --loadreplay");
+	}
+
 	return true;
 }
 
@@ -26,13 +26,17 @@
 #include "lib/framework/wzconfig.h"
 #include "lib/framework/input.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netsocket.h" // for the socket poller
 #include "lib/sound/mixer.h"
 #include "lib/sound/sounddefs.h"
 #include "lib/ivis_opengl/screen.h"
 #include "lib/ivis_opengl/pieclip.h"
+#include "lib/ivis_opengl/piedef.h" // for the shadow cache
 #include "lib/ivis_opengl/piestate.h" // for fog
 
 #include "ai.h"
+#include "astar.h" // for the path finding open list
+#include "mapgrid.h" // for grid prefetching
 #include "component.h"
 #include "configuration.h"
 #include "difficulty.h"
@@ -483,10 +487,22 @@ bool loadConfig()
 	}
 	war_setAutoLagKickSeconds(iniGetInteger("hostAutoLagKickSeconds", war_getAutoLagKickSeconds()).value());
 	war_setDisableReplayRecording(iniGetBool("disableReplayRecord", war_getDisableReplayRecording()).value());
+	war_setScriptTimerSpread(iniGetBool("scriptTimerSpread", war_getScriptTimerSpread()).value());
+	war_setScriptTickBudget(iniGetInteger("scriptTickBudget", war_getScriptTickBudget()).value());
+	war_setScriptBudgetInterrupt(iniGetBool("scriptBudgetInterrupt", war_getScriptBudgetInterrupt()).value());
 	int openSpecSlotsIntValue = iniGetInteger("openSpectatorSlotsMP", war_getMPopenSpectatorSlots()).value();
 	war_setMPopenSpectatorSlots(static_cast<uint16_t>(std::max<int>(0, std::min<int>(openSpecSlotsIntValue, MAX_SPECTATOR_SLOTS))));
 	war_setFogEnd(iniGetInteger("fogEnd", 8000).value());
 	war_setFogStart(iniGetInteger("fogStart", 4000).value());
+	war_setPathThreads(iniGetInteger("pathThreads", war_getPathThreads()).value());
+	fpathSetOpenListType(iniGetBool("pathBucketQueue", fpathGetOpenListType() == FPATH_OPENLIST::buckets).value() ? FPATH_OPENLIST::buckets : FPATH_OPENLIST::heap);
+	fpathSetHierarchical(iniGetBool("pathHierarchical", fpathGetHierarchical()).value());
+	gridSetPrefetch(iniGetBool("gridPrefetch", gridGetPrefetch()).value());
+	if (socketPollerAvailable(SOCKET_POLLER::epoll))
+	{
+		socketSetPoller(iniGetBool("socketEpoll", socketGetPoller() == SOCKET_POLLER::epoll).value() ? SOCKET_POLLER::epoll : SOCKET_POLLER::select);
+	}
+	pie_setShadowCache(iniGetBool("shadowCachePersistent", pie_getShadowCache() == SHADOW_CACHE::persistent).value() ? SHADOW_CACHE::persistent : SHADOW_CACHE::frame);
 	ActivityManager::instance().endLoadingSettings();
 	return true;
 }
@@ -634,8 +650,17 @@ bool saveConfig()
 	iniSetBool("fog", pie_GetFogEnabled());
 	iniSetInteger("hostAutoLagKickSeconds", war_getAutoLagKickSeconds());
 	iniSetBool("disableReplayRecord", war_getDisableReplayRecording());
+	iniSetBool("scriptTimerSpread", war_getScriptTimerSpread());
+	iniSetInteger("scriptTickBudget", war_getScriptTickBudget());
+	iniSetBool("scriptBudgetInterrupt", war_getScriptBudgetInterrupt());
 	iniSetInteger("fogEnd", war_getFogEnd());
 	iniSetInteger("fogStart", war_getFogStart());
+	iniSetInteger("pathThreads", war_getPathThreads());
+	iniSetBool("pathBucketQueue", fpathGetOpenListType() == FPATH_OPENLIST::buckets);
+	iniSetBool("pathHierarchical", fpathGetHierarchical());
+	iniSetBool("gridPrefetch", gridGetPrefetch());
+	iniSetBool("socketEpoll", socketGetPoller() == SOCKET_POLLER::epoll);
+	iniSetBool("shadowCachePersistent", pie_getShadowCache() == SHADOW_CACHE::persistent);
 
 	// write out ini file changes
 	bool result = saveIniFile(file, ini);
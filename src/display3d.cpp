@@ -1240,7 +1240,15 @@ static void drawTiles(iView *player)
 	gfx_api::context::get().debugStringMarker("Draw 3D scene - blueprints");
 	displayBlueprints(viewMatrix);
 
-	pie_RemainingPasses(currentGameFrame); // draws shadows and transparent shapes
+	pie_DrawOpaqueShapes();
+	wzPerfEnd(PERF_MODELS);
+
+	wzPerfBegin(PERF_SHADOWS, "3D scene - shadows");
+	pie_DrawShadows(currentGameFrame);
+	wzPerfEnd(PERF_SHADOWS);
+
+	wzPerfBegin(PERF_TRANSLUCENT, "3D scene - translucent models");
+	pie_DrawTranslucentShapes();
 
 	if (!gamePaused())
 	{
@@ -1248,7 +1256,7 @@ static void drawTiles(iView *player)
 	}
 	locateMouse();
 
-	wzPerfEnd(PERF_MODELS);
+	wzPerfEnd(PERF_TRANSLUCENT);
 }
 
 /// Initialise the fog, skybox and some other stuff
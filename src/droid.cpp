@@ -27,6 +27,7 @@
 #include "lib/framework/math_ext.h"
 #include "lib/framework/geometry.h"
 #include "lib/framework/strres.h"
+#include "lib/framework/wzprofile.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/ivis_opengl/piematrix.h"
@@ -646,6 +647,8 @@ void _syncDebugDroid(const char *function, DROID const *psDroid, char ch)
 /* The main update routine for all droids */
 void droidUpdate(DROID *psDroid)
 {
+	WZ_PROFILE_ZONE("droidUpdate");
+
 	Vector3i        dv;
 	UDWORD          percentDamage, emissionInterval;
 	BASE_OBJECT     *psBeingTargetted = nullptr;
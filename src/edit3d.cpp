@@ -31,6 +31,7 @@ Alex McLean, Pumpkin Studios, EIDOS Interactive, 1997
 #include "objects.h"
 #include "display.h"
 #include "hci.h"
+#include "visibility.h"
 
 /*
 Definition of a tile to highlight - presently more than is required
@@ -70,6 +71,7 @@ void raiseTile(int tile3dX, int tile3dY)
 			markTileDirty(i, j);
 		}
 	}
+	visTerrainHeightChanged(tile3dX, tile3dY, tile3dX + brushSize, tile3dY + brushSize);
 }
 
 /* Lowers a tile by a #defined height */
@@ -89,6 +91,7 @@ void lowerTile(int tile3dX, int tile3dY)
 			markTileDirty(i, j);
 		}
 	}
+	visTerrainHeightChanged(tile3dX, tile3dY, tile3dX + brushSize, tile3dY + brushSize);
 }
 
 /* Ensures any adjustment to tile elevation is within allowed ranges */
@@ -155,7 +155,36 @@
 #define SHOCKWAVE_SPEED	(GAME_TICKS_PER_SEC)
 #define	MAX_SHOCKWAVE_SIZE				500
 
-static std::list<EFFECT *> activeList;
+/// Effects are kept in a fixed size pool per group, so adding one doesn't allocate, and a group filling up (say, smoke
+/// in a big battle) can't crowd out the others. The pools never grow, so effects don't move while being rendered. They
+/// are only rearranged by processEffects(), which removes expired effects by moving the last effect into their place.
+struct EffectPool
+{
+	std::vector<EFFECT> effects;  ///< The first count effects are active.
+	size_t count = 0;
+	size_t dropped = 0;           ///< Effects not added, since the pool was full.
+};
+
+static EffectPool effectPools[EFFECT_FREED];
+
+/// Size of the pool of each group. Non-essential effects leave the last EFFECT_ESSENTIAL_RESERVE of each pool free.
+static const size_t effectPoolCapacity[EFFECT_FREED] =
+{
+	4096,  // EFFECT_EXPLOSION
+	1024,  // EFFECT_CONSTRUCTION
+	4096,  // EFFECT_SMOKE
+	2048,  // EFFECT_GRAVITON
+	256,   // EFFECT_WAYPOINT
+	512,   // EFFECT_BLOOD
+	512,   // EFFECT_DESTRUCTION
+	64,    // EFFECT_SAT_LASER
+	512,   // EFFECT_FIRE
+	512,   // EFFECT_FIREWORK
+};
+
+#define EFFECT_ESSENTIAL_RESERVE(group) (effectPoolCapacity[group] / 8)
+/// Above this many effects in a group, addMultiEffect() adds fewer effects.
+#define EFFECT_DEGRADE_THRESHOLD(group) (effectPoolCapacity[group] * 3 / 4)
 
 /* Tick counts for updates on a particular interval */
 static	UDWORD	lastUpdateStructures[EFFECT_STRUCTURE_DIVISION];
@@ -180,7 +209,6 @@ static bool updateDestruction(EFFECT *psEffect);
 static bool updateFire(EFFECT *psEffect);
 static bool updateSatLaser(EFFECT *psEffect);
 static bool updateFirework(EFFECT *psEffect);
-static bool updateEffect(EFFECT *psEffect);	// MASTER function
 
 // ----------------------------------------------------------------------------------------
 // ---- The render functions - every group type of effect has a distinct one
@@ -215,11 +243,16 @@ static UDWORD effectGetNumFrames(EFFECT *psEffect);
 
 void shutdownEffectsSystem()
 {
-	for (auto eff : activeList)
+	for (EffectPool &pool : effectPools)
 	{
-		delete eff;
+		if (pool.dropped != 0)
+		{
+			debug(LOG_3D, "Dropped %zu effects, since the pool was full", pool.dropped);
+		}
+		pool.effects = std::vector<EFFECT>();
+		pool.count = 0;
+		pool.dropped = 0;
 	}
-	activeList.clear();
 }
 
 /*!
@@ -230,6 +263,25 @@ void initEffectsSystem()
 	shutdownEffectsSystem();
 }
 
+/// Adds a copy of the effect to the pool of its group, unless the pool is full. Returns the added effect, if any.
+static EFFECT *effectPoolAdd(EFFECT const &effect)
+{
+	ASSERT_OR_RETURN(nullptr, effect.group < EFFECT_FREED, "Bad effect group %d", (int)effect.group);
+	EffectPool &pool = effectPools[effect.group];
+	if (pool.effects.empty())
+	{
+		pool.effects.resize(effectPoolCapacity[effect.group]);  // Only allocated once, so effects never move when adding.
+	}
+	size_t limit = pool.effects.size() - (TEST_ESSENTIAL(&effect) ? 0 : EFFECT_ESSENTIAL_RESERVE(effect.group));
+	if (pool.count >= limit)
+	{
+		++pool.dropped;
+		return nullptr;
+	}
+	pool.effects[pool.count] = effect;
+	return &pool.effects[pool.count++];
+}
+
 static glm::mat4 positionEffect(const EFFECT *psEffect)
 {
 	/* Establish world position */
@@ -263,6 +315,14 @@ void addMultiEffect(const Vector3i *basePos, Vector3i *scatter, EFFECT_GROUP gro
 	/* Set up the scaling for specified ones */
 	specifiedSize = size;
 
+	/* Add fewer effects, if this group is running out of room */
+	size_t count = group < EFFECT_FREED ? effectPools[group].count : 0;
+	if (group < EFFECT_FREED && count > EFFECT_DEGRADE_THRESHOLD(group))
+	{
+		size_t room = effectPoolCapacity[group] - std::min(count, effectPoolCapacity[group]);
+		number = std::max<unsigned>(number * room / (effectPoolCapacity[group] - EFFECT_DEGRADE_THRESHOLD(group)), 1);
+	}
+
 	/* If there's only one, make sure it's in the centre */
 	if (number == 1)
 	{
@@ -307,7 +367,8 @@ void addEffect(const Vector3i *pos, EFFECT_GROUP group, EFFECT_TYPE type, bool s
 	{
 		return;
 	}
-	EFFECT *psEffect = new EFFECT();
+	EFFECT effect;
+	EFFECT *psEffect = &effect;
 	/* Reset control bits */
 	psEffect->control = 0;
 
@@ -400,106 +461,59 @@ void addEffect(const Vector3i *pos, EFFECT_GROUP group, EFFECT_TYPE type, bool s
 
 	ASSERT(psEffect->imd != nullptr || group == EFFECT_DESTRUCTION || group == EFFECT_FIRE || group == EFFECT_SAT_LASER, "null effect imd");
 
-	activeList.push_back(psEffect);
+	effectPoolAdd(effect);
 }
 
+/* The update function of each group. Returns false if effect should be deleted. */
+static bool (*const effectUpdateFunctions[EFFECT_FREED])(EFFECT *psEffect) =
+{
+	updateExplosion,     // EFFECT_EXPLOSION
+	updateConstruction,  // EFFECT_CONSTRUCTION
+	updatePolySmoke,     // EFFECT_SMOKE
+	updateGraviton,      // EFFECT_GRAVITON
+	updateWaypoint,      // EFFECT_WAYPOINT
+	updateBlood,         // EFFECT_BLOOD
+	updateDestruction,   // EFFECT_DESTRUCTION
+	updateSatLaser,      // EFFECT_SAT_LASER
+	updateFire,          // EFFECT_FIRE
+	updateFirework,      // EFFECT_FIREWORK
+};
 
 /* Calls all the update functions for each different currently active effect */
 void processEffects(const glm::mat4 &viewMatrix)
 {
-	for (auto it = activeList.begin(); it != activeList.end(); )
+	for (unsigned group = 0; group < EFFECT_FREED; ++group)
 	{
-		EFFECT *psEffect = *it;
+		bool (*const updateFunction)(EFFECT *) = effectUpdateFunctions[group];
+		bool update = group == EFFECT_EXPLOSION || !gamePaused();  // Only explosions keep going while paused.
+		EffectPool &pool = effectPools[group];
 
-		if (psEffect->birthTime <= graphicsTime)  // Don't process, if it doesn't exist yet
+		// Effects added while updating are added to the end, so are also processed.
+		for (size_t i = 0; i < pool.count;)
 		{
-			if (!updateEffect(psEffect))
-			{
-				delete psEffect;
-				it = activeList.erase(it);
-				continue;
-			}
-			if (psEffect->group != EFFECT_FREED && clipXY(static_cast<SDWORD>(psEffect->position.x), static_cast<SDWORD>(psEffect->position.z)))
+			EFFECT *psEffect = &pool.effects[i];
+
+			if (psEffect->birthTime <= graphicsTime)  // Don't process, if it doesn't exist yet
 			{
-				bucketAddTypeToList(RENDER_EFFECT, psEffect, viewMatrix);
+				if (update && !updateFunction(psEffect))
+				{
+					// Replace it by the last effect, which hasn't been processed yet, so isn't in the render bucket.
+					pool.effects[i] = pool.effects[--pool.count];
+					continue;
+				}
+				if (psEffect->group != EFFECT_FREED && clipXY(static_cast<SDWORD>(psEffect->position.x), static_cast<SDWORD>(psEffect->position.z)))
+				{
+					bucketAddTypeToList(RENDER_EFFECT, psEffect, viewMatrix);
+				}
 			}
+			++i;
 		}
-		++it;
 	}
 
 	/* Add any structure effects */
 	effectStructureUpdates();
 }
 
-/* The general update function for all effects - calls a specific one for each. Returns false if effect should be deleted. */
-static bool updateEffect(EFFECT *psEffect)
-{
-	/* What type of effect are we dealing with? */
-	switch (psEffect->group)
-	{
-	case EFFECT_EXPLOSION:
-		return updateExplosion(psEffect);
-	case EFFECT_WAYPOINT:
-		if (!gamePaused())
-		{
-			return updateWaypoint(psEffect);
-		}
-		return true;
-	case EFFECT_CONSTRUCTION:
-		if (!gamePaused())
-		{
-			return updateConstruction(psEffect);
-		}
-		return true;
-	case EFFECT_SMOKE:
-		if (!gamePaused())
-		{
-			return updatePolySmoke(psEffect);
-		}
-		return true;
-	case EFFECT_GRAVITON:
-		if (!gamePaused())
-		{
-			return updateGraviton(psEffect);
-		}
-		return true;
-	case EFFECT_BLOOD:
-		if (!gamePaused())
-		{
-			return updateBlood(psEffect);
-		}
-		return true;
-	case EFFECT_DESTRUCTION:
-		if (!gamePaused())
-		{
-			return updateDestruction(psEffect);
-		}
-		return true;
-	case EFFECT_FIRE:
-		if (!gamePaused())
-		{
-			return updateFire(psEffect);
-		}
-		return true;
-	case EFFECT_SAT_LASER:
-		if (!gamePaused())
-		{
-			return updateSatLaser(psEffect);
-		}
-		return true;
-	case EFFECT_FIREWORK:
-		if (!gamePaused())
-		{
-			return updateFirework(psEffect);
-		}
-		return true;
-	case EFFECT_FREED:
-		break;
-	}
-	debug(LOG_ERROR, "Weirdy class of effect passed to updateEffect");
-	abort();
-}
-
 // ----------------------------------------------------------------------------------------
 // ALL THE UPDATE FUNCTIONS
 // ----------------------------------------------------------------------------------------
@@ -2223,37 +2237,40 @@ bool writeFXData(const char *fileName)
 {
 	int i = 0;
 	nlohmann::json mRoot = nlohmann::json::object();
-	for (auto iter = activeList.cbegin(); iter != activeList.end(); ++iter, i++)
-	{
-		EFFECT *it = *iter;
-
-		nlohmann::json effectObj = nlohmann::json::object();
-		effectObj["control"] = it->control;
-		effectObj["group"] = it->group;
-		effectObj["type"] = it->type;
-		effectObj["frameNumber"] = it->frameNumber;
-		effectObj["size"] = it->size;
-		effectObj["baseScale"] = it->baseScale;
-		effectObj["specific"] = it->specific;
-		effectObj["position"] = it->position;
-		effectObj["velocity"] = it->velocity;
-		effectObj["rotation"] = it->rotation;
-		effectObj["spin"] = it->spin;
-		effectObj["birthTime"] = it->birthTime;
-		effectObj["lastFrame"] = it->lastFrame;
-		effectObj["frameDelay"] = it->frameDelay;
-		effectObj["lifeSpan"] = it->lifeSpan;
-		effectObj["radius"] = it->radius;
-
-		if (it->imd)
-		{
-			effectObj["imd_name"] = modelName(it->imd);
-		}
+	for (EffectPool const &pool : effectPools)
+	{
+		for (size_t n = 0; n < pool.count; ++n, i++)
+		{
+			EFFECT const *it = &pool.effects[n];
+
+			nlohmann::json effectObj = nlohmann::json::object();
+			effectObj["control"] = it->control;
+			effectObj["group"] = it->group;
+			effectObj["type"] = it->type;
+			effectObj["frameNumber"] = it->frameNumber;
+			effectObj["size"] = it->size;
+			effectObj["baseScale"] = it->baseScale;
+			effectObj["specific"] = it->specific;
+			effectObj["position"] = it->position;
+			effectObj["velocity"] = it->velocity;
+			effectObj["rotation"] = it->rotation;
+			effectObj["spin"] = it->spin;
+			effectObj["birthTime"] = it->birthTime;
+			effectObj["lastFrame"] = it->lastFrame;
+			effectObj["frameDelay"] = it->frameDelay;
+			effectObj["lifeSpan"] = it->lifeSpan;
+			effectObj["radius"] = it->radius;
+
+			if (it->imd)
+			{
+				effectObj["imd_name"] = modelName(it->imd);
+			}
 
-		auto effectKey = "effect_" + WzString::number(i);
-		mRoot[effectKey.toUtf8()] = std::move(effectObj);
+			auto effectKey = "effect_" + WzString::number(i);
+			mRoot[effectKey.toUtf8()] = std::move(effectObj);
 
-		// Move on to reading the next effect
+			// Move on to reading the next effect
+		}
 	}
 
 	std::ostringstream stream;
@@ -2278,7 +2295,8 @@ bool readFXData(const char *fileName)
 	for (int i = 0; i < list.size(); ++i)
 	{
 		ini.beginGroup(list[i]);
-		EFFECT *curEffect = new EFFECT();
+		EFFECT effect;
+		EFFECT *curEffect = &effect;
 
 		curEffect->control      = ini.value("control").toInt();
 		curEffect->group        = (EFFECT_GROUP)ini.value("group").toInt();
@@ -2326,7 +2344,10 @@ bool readFXData(const char *fileName)
 		// Move on to reading the next effect
 		ini.endGroup();
 
-		activeList.push_back(curEffect);
+		if (curEffect->group < EFFECT_FREED)
+		{
+			effectPoolAdd(effect);
+		}
 	}
 
 	/* Hopefully everything's just fine by now */
@@ -295,6 +295,10 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave)
 			}
 		}
 	}
+	if (!psStats->tileDraw && !FromSave)
+	{
+		visTerrainHeightChanged(b.map.x, b.map.y, b.map.x + b.size.x - 1, b.map.y + b.size.y - 1);
+	}
 	psFeature->pos.z = map_TileHeight(b.map.x, b.map.y);//jps 18july97
 
 	return psFeature;
@@ -25,6 +25,7 @@
  */
 
 #include <future>
+#include <thread>
 #include <unordered_map>
 
 #include "lib/framework/frame.h"
@@ -32,11 +33,13 @@
 #include "lib/netplay/netplay.h"
 
 #include "lib/framework/wzapp.h"
+#include "lib/framework/wzprofile.h"
 
 #include "objects.h"
 #include "map.h"
 #include "multiplay.h"
 #include "astar.h"
+#include "warzoneconfig.h"
 
 #include "fpath.h"
 
@@ -56,30 +59,46 @@ struct PATHRESULT
 
 
 // threading stuff
-static WZ_THREAD        *fpathThread = nullptr;
+static std::vector<WZ_THREAD *> fpathThreads;
 static WZ_MUTEX         *fpathMutex = nullptr;
 static WZ_SEMAPHORE     *fpathSemaphore = nullptr;
 using packagedPathJob = wz::packaged_task<PATHRESULT()>;
-static std::list<packagedPathJob>    pathJobs;
+static std::list<packagedPathJob>    pathJobs[FPATH_CONTEXT_LANES];  ///< Queued jobs, per lane. Protected by fpathMutex.
+static bool             pathLaneBusy[FPATH_CONTEXT_LANES];          ///< A thread is currently running a job from the lane. Protected by fpathMutex.
+static unsigned         pathNextLane = 0;                           ///< Lane to look at first, so that no lane gets starved. Protected by fpathMutex.
 static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
 
-static bool             waitingForResult = false;
-static uint32_t         waitingForResultId;
-static WZ_SEMAPHORE     *waitingForResultSemaphore = nullptr;
-
 static PATHRESULT fpathExecute(PATHJOB psJob);
 
 
-/** This runs in a separate thread */
+/// Returns a lane with queued jobs, which no other thread is working on, or -1 if there are none. Call with fpathMutex locked.
+static int fpathFindIdleLane()
+{
+	for (unsigned i = 0; i < FPATH_CONTEXT_LANES; ++i)
+	{
+		unsigned lane = (pathNextLane + i) % FPATH_CONTEXT_LANES;
+		if (!pathLaneBusy[lane] && !pathJobs[lane].empty())
+		{
+			pathNextLane = (lane + 1) % FPATH_CONTEXT_LANES;
+			return lane;
+		}
+	}
+	return -1;
+}
+
+/** This runs in one or more separate threads */
 static int fpathThreadFunc(void *)
 {
+	wzProfileThreadName("path");
 	wzMutexLock(fpathMutex);
 
 	while (!fpathQuit)
 	{
-		if (pathJobs.empty())
+		int lane = fpathFindIdleLane();
+		if (lane < 0)
 		{
-			ASSERT(!waitingForResult, "Waiting for a result (id %u) that doesn't exist.", waitingForResultId);
+			// Either there is nothing to do, or the remaining jobs are in lanes which another thread is busy with.
+			// The thread which is busy with a lane wakes us up when done, if the lane still has jobs queued.
 			wzMutexUnlock(fpathMutex);
 			wzSemaphoreWait(fpathSemaphore);  // Go to sleep until needed.
 			wzMutexLock(fpathMutex);
@@ -87,21 +106,35 @@ static int fpathThreadFunc(void *)
 		}
 
 		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
+		packagedPathJob job = std::move(pathJobs[lane].front());
+		pathJobs[lane].pop_front();
+		pathLaneBusy[lane] = true;
 
 		wzMutexUnlock(fpathMutex);
 		job();
 		wzMutexLock(fpathMutex);
 
-		waitingForResult = false;
-		objTrace(waitingForResultId, "These are the droids you are looking for.");
-		wzSemaphorePost(waitingForResultSemaphore);
+		pathLaneBusy[lane] = false;
+		if (!pathJobs[lane].empty())
+		{
+			wzSemaphorePost(fpathSemaphore);  // Let another thread continue with this lane, in case this thread picks a different one.
+		}
 	}
 	wzMutexUnlock(fpathMutex);
 	return 0;
 }
 
+/// Number of path threads to start, from the config, or based on the number of CPU cores if not set.
+static unsigned fpathThreadCount()
+{
+	int count = war_getPathThreads();
+	if (count <= 0)
+	{
+		count = std::max<int>(std::thread::hardware_concurrency(), 2) - 1;  // Leave a core for the main thread.
+	}
+	return std::max(std::min<unsigned>(count, FPATH_CONTEXT_LANES), 1u);  // Additional threads would have no lane to work on.
+}
+
 
 // initialise the findpath module
 bool fpathInitialise()
@@ -109,13 +142,24 @@ bool fpathInitialise()
 	// The path system is up
 	fpathQuit = false;
 
-	if (!fpathThread)
+	// Other players may have a different config, so networked games always use plain A*. Replays restore the recorded choice.
+	if (!NETisReplay())
+	{
+		fpathSetHierarchicalGame(!NetPlay.bComms && fpathGetHierarchical());
+	}
+
+	if (fpathThreads.empty())
 	{
 		fpathMutex = wzMutexCreate();
 		fpathSemaphore = wzSemaphoreCreate(0);
-		waitingForResultSemaphore = wzSemaphoreCreate(0);
-		fpathThread = wzThreadCreate(fpathThreadFunc, nullptr);
-		wzThreadStart(fpathThread);
+		unsigned count = fpathThreadCount();
+		for (unsigned i = 0; i < count; ++i)
+		{
+			WZ_THREAD *thread = wzThreadCreate(fpathThreadFunc, nullptr);
+			fpathThreads.push_back(thread);
+			wzThreadStart(thread);
+		}
+		debug(LOG_INFO, "Started %u path-finding threads", count);
 	}
 
 	return true;
@@ -124,20 +168,24 @@ bool fpathInitialise()
 
 void fpathShutdown()
 {
-	if (fpathThread)
+	if (!fpathThreads.empty())
 	{
-		// Signal the path finding thread to quit
+		// Signal the path finding threads to quit
 		fpathQuit = true;
-		wzSemaphorePost(fpathSemaphore);  // Wake up thread.
+		for (size_t i = 0; i < fpathThreads.size(); ++i)
+		{
+			wzSemaphorePost(fpathSemaphore);  // Wake up threads.
+		}
 
-		wzThreadJoin(fpathThread);
-		fpathThread = nullptr;
+		for (WZ_THREAD *thread : fpathThreads)
+		{
+			wzThreadJoin(thread);
+		}
+		fpathThreads.clear();
 		wzMutexDestroy(fpathMutex);
 		fpathMutex = nullptr;
 		wzSemaphoreDestroy(fpathSemaphore);
 		fpathSemaphore = nullptr;
-		wzSemaphoreDestroy(waitingForResultSemaphore);
-		waitingForResultSemaphore = nullptr;
 	}
 	fpathHardTableReset();
 }
@@ -391,18 +439,20 @@ queuePathfinding:
 	packagedPathJob task([job]() { return fpathExecute(job); });
 	pathResults[id] = task.get_future();
 
-	// Add to end of list
+	// Add to end of the list for the lane, jobs in the same lane are always processed in order.
+	unsigned lane = fpathContextLane(&job);
 	wzMutexLock(fpathMutex);
-	bool isFirstJob = pathJobs.empty();
-	pathJobs.push_back(std::move(task));
+	size_t earlierJobs = pathJobs[lane].size();
+	bool laneIdle = !pathLaneBusy[lane] && earlierJobs == 0;
+	pathJobs[lane].push_back(std::move(task));
 	wzMutexUnlock(fpathMutex);
 
-	if (isFirstJob)
+	if (laneIdle)
 	{
-		wzSemaphorePost(fpathSemaphore);  // Wake up processing thread.
+		wzSemaphorePost(fpathSemaphore);  // Wake up a processing thread.
 	}
 
-	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
+	objTrace(id, "Queued up a path-finding request to (%d, %d), %d items earlier in lane %u", tX, tY, (int)earlierJobs, lane);
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
 	return FPR_WAIT;	// wait while polling result queue
 }
@@ -505,7 +555,10 @@ static size_t fpathJobQueueLength()
 	size_t count = 0;
 
 	wzMutexLock(fpathMutex);
-	count = pathJobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	for (auto const &jobs : pathJobs)
+	{
+		count += jobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	}
 	wzMutexUnlock(fpathMutex);
 	return count;
 }
@@ -539,10 +592,10 @@ void fpathTest(int x, int y, int x2, int y2)
 	(void)fpathJobQueueLength();
 
 	/* Check initial state */
-	assert(fpathThread != nullptr);
+	assert(!fpathThreads.empty());
 	assert(fpathMutex != nullptr);
 	assert(fpathSemaphore != nullptr);
-	assert(pathJobs.empty());
+	assert(fpathJobQueueLength() == 0);
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
 
@@ -75,6 +75,7 @@
 #include "cmddroid.h"
 #include "warzoneconfig.h"
 #include "multiplay.h"
+#include "replayverify.h"
 #include "frontend.h"
 #include "levels.h"
 #include "mission.h"
@@ -2278,6 +2279,7 @@ bool loadGameInit(const char *fileName)
 		WZGameReplayOptionsHandler optionsHandler;
 		if (!NETloadReplay(fileName, optionsHandler))
 		{
+			replayVerifyLoadFailed(fileName);
 			return false;
 		}
 
@@ -5903,7 +5905,7 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 		}
 		// The original code here didn't work and so the scriptwriters worked round it by using the module ID - so making it work now will screw up
 		// the scripts -so in ALL CASES overwrite the ID!
-		psStructure->id = psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98; // hack to remove struct id zero
+		objmemSetObjectId(psStructure, psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98); // hack to remove struct id zero
 		psStructure->periodicalDamage = psSaveStructure->periodicalDamage;
 		periodicalDamageTime = psSaveStructure->periodicalDamageStart;
 		psStructure->periodicalDamageStart = periodicalDamageTime;
@@ -5995,7 +5997,7 @@ static bool loadWzMapStructure(WzMap::Map& wzMap)
 		{
 			// The original code here didn't work and so the scriptwriters worked round it by using the module ID - so making it work now will screw up
 			// the scripts -so in ALL CASES overwrite the ID!
-			psStructure->id = structure.id.value() > 0 ? structure.id.value() : 0xFEDBCA98; // hack to remove struct id zero
+			objmemSetObjectId(psStructure, structure.id.value() > 0 ? structure.id.value() : 0xFEDBCA98); // hack to remove struct id zero
 		}
 		if (structure.modules > 0)
 		{
@@ -6099,7 +6101,7 @@ static bool loadSaveStructure2(const char *pFileName, STRUCTURE **ppList)
 		}
 		if (id > 0)
 		{
-			psStructure->id = id;	// force correct ID
+			objmemSetObjectId(psStructure, id);	// force correct ID
 		}
 
 		// common BASE_OBJECT info
@@ -6646,7 +6648,7 @@ bool loadSaveFeature(char *pFileData, UDWORD filesize)
 			scriptSetDerrickPos(pFeature->pos.x, pFeature->pos.y);
 		}
 		//restore values
-		pFeature->id = psSaveFeature->id;
+		objmemSetObjectId(pFeature, psSaveFeature->id);
 		pFeature->rot.direction = DEG(psSaveFeature->direction);
 		pFeature->periodicalDamage = psSaveFeature->periodicalDamage;
 		if (psHeader->version >= VERSION_14)
@@ -6691,11 +6693,11 @@ static bool loadWzMapFeature(WzMap::Map &wzMap)
 		//restore values
 		if (feature.id.has_value())
 		{
-			pFeature->id = feature.id.value();
+			objmemSetObjectId(pFeature, feature.id.value());
 		}
 		else
 		{
-			pFeature->id = generateSynchronisedObjectId();
+			objmemSetObjectId(pFeature, generateSynchronisedObjectId());
 		}
 		pFeature->rot.direction = feature.direction;
 		pFeature->player = (feature.player.has_value()) ? feature.player.value() : PLAYER_FEATURE;
@@ -6758,11 +6760,11 @@ bool loadSaveFeature2(const char *pFileName)
 		int id = ini.value("id", -1).toInt();
 		if (id > 0)
 		{
-			pFeature->id = id;
+			objmemSetObjectId(pFeature, id);
 		}
 		else
 		{
-			pFeature->id = generateSynchronisedObjectId();
+			objmemSetObjectId(pFeature, generateSynchronisedObjectId());
 		}
 		pFeature->rot = ini.vector3i("rotation");
 		pFeature->player = ini.value("player", PLAYER_FEATURE).toInt();
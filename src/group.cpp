@@ -31,6 +31,7 @@
 #include "group.h"
 #include "droid.h"
 #include "order.h"
+#include "objmem.h"
 #include <map>
 
 // Group system variables: grpGlobalManager enables to remove all the groups to Shutdown the system
@@ -145,6 +146,11 @@ void DROID_GROUP::add(DROID *psDroid)
 			psList = psDroid;
 		}
 
+		if (type == GT_TRANSPORTER)
+		{
+			objmemIndexObject(psDroid);  // Droids in transporters are not in any object list, but can still be found by id.
+		}
+
 		if (type == GT_COMMAND)
 		{
 			syncDebug("Droid %d joining command group %d", psDroid->id, psCommander != nullptr ? psCommander->id : 0);
@@ -23,6 +23,8 @@
 #include "lib/framework/wzapp.h"
 #include "lib/framework/rational.h"
 #include "lib/framework/physfs_ext.h"
+#include "lib/framework/wzprofile.h"
+#include "lib/framework/wztime.h"
 #include "objects.h"
 #include "levels.h"
 #include "basedef.h"
@@ -55,6 +57,7 @@
 #include "multimenu.h"
 #include "atmos.h"
 #include "advvis.h"
+#include "visibility.h"
 
 #include "intorder.h"
 #include "lib/widget/listwidget.h"
@@ -74,6 +77,7 @@
 #include "loadsave.h"
 #include "game.h"
 #include "droid.h"
+#include "astar.h"
 #include "spectatorwidgets.h"
 
 #include "activity.h"
@@ -315,6 +319,7 @@ void	kf_HalveHeights()
 			psTile->height /= 2;
 		}
 	}
+	visTerrainChanged();  // Every height changed, so no memoized structure wavecast is still right.
 }
 
 // --------------------------------------------------------------------------
@@ -694,8 +699,8 @@ void kf_ToggleOrders()	// Displays orders & action of currently selected unit.
 /* Writes out the frame rate */
 void	kf_FrameRate()
 {
-	CONPRINTF("FPS %d; PIEs %zu; polys %zu",
-	                          frameRate(), loopPieCount, loopPolyCount);
+	CONPRINTF("FPS %d; PIEs %zu; polys %zu; draws %zu",
+	                          frameRate(), loopPieCount, loopPolyCount, loopDrawCount);
 	if (runningMultiplayer())
 	{
 		CONPRINTF("NETWORK:  Bytes: s-%zu r-%zu  Uncompressed Bytes: s-%zu r-%zu  Packets: s-%zu r-%zu",
@@ -830,6 +835,48 @@ void	kf_TileInfo()
 	addConsoleMessage(_("Tile info dumped into log"), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
 }
 
+/* Times path finding blocking map lookups on the current map */
+void	kf_BenchmarkPathBlockingMap()
+{
+	fpathBenchmarkBlockingMap();
+	addConsoleMessage(_("Path blocking map benchmark dumped into log"), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+}
+
+/* Checks that both path finding open list types give identical routes on the current map */
+void	kf_TestPathOpenLists()
+{
+	bool identical = fpathTestOpenLists(500);
+	addConsoleMessage(identical ? _("Path open lists agree, timings dumped into log") : _("Path open lists disagree, see log"), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+}
+
+/* Checks that hierarchical path finding gives routes about as short as plain A* on the current map */
+void	kf_TestPathClusters()
+{
+	bool close = fpathTestClusters(500);
+	addConsoleMessage(close ? _("Hierarchical routes are close to plain A*, lengths dumped into log") : _("Hierarchical routes are worse than plain A*, see log"), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+}
+
+/* Starts the simulation profiler, or stops it and writes the recorded zones as a Chrome trace */
+void	kf_ToggleProfiler()
+{
+	if (!wzProfileEnabled())
+	{
+		wzProfileStart();
+		addConsoleMessage(_("Profiling started"), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+		return;
+	}
+	wzProfileStop();
+	std::string filename = "profile-" + formatLocalDateTime("%Y-%m-%d_%H%M%S") + ".json";
+	if (wzProfileWriteTrace(filename.c_str()))
+	{
+		addConsoleMessage(astringf(_("Profile written to %s"), filename.c_str()).c_str(), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+	}
+	else
+	{
+		addConsoleMessage(_("Could not write profile, see log"), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+	}
+}
+
 /* Toggles fog on/off */
 void	kf_ToggleFog()
 {
@@ -175,6 +175,10 @@ void kf_ToggleRadarTerrain();            //radar terrain
 void kf_ToggleRadarAllyEnemy();          //enemy/ally color toggle
 
 void kf_TileInfo();
+void kf_BenchmarkPathBlockingMap();
+void kf_TestPathOpenLists();
+void kf_TestPathClusters();
+void kf_ToggleProfiler();
 
 void kf_NoAssert();
 
@@ -34,6 +34,8 @@
 #include "lib/framework/physfs_ext.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/exceptionhandler/dumpinfo.h"
+#include "benchmark.h"
+#include "replayverify.h"
 #include "clparse.h"
 #include "init.h"
 #include "objects.h"
@@ -1127,9 +1129,12 @@ bool levLoadData(char const *name, Sha256 const *hash, char *pSaveName, GAME_TYP
 	ssprintf(buf, "Current Level/map is %s", psCurrLevel->pName);
 	addDumpInfo(buf);
 
-	if (autogame_enabled())
+	if (autogame_enabled() || benchmarkTicks() != 0 || replayVerifyEnabled())
 	{
 		gameTimeSetMod(Rational(500));
+	}
+	if (autogame_enabled())
+	{
 		if (getHostLaunch() != HostLaunch::Skirmish) // tests will specify the AI manually
 		{
 			if (selectedPlayer < MAX_PLAYERS && !NetPlay.players[selectedPlayer].isSpectator)
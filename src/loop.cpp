@@ -27,6 +27,7 @@
 #include "lib/framework/input.h"
 #include "lib/framework/strres.h"
 #include "lib/framework/wzapp.h"
+#include "lib/framework/wzprofile.h"
 
 #include "lib/ivis_opengl/pieblitfunc.h"
 #include "lib/ivis_opengl/piestate.h" //ivis render code
@@ -73,6 +74,11 @@
 #include "warcam.h"
 #include "lighting.h"
 #include "mapgrid.h"
+#include "benchmark.h"
+#include "replayverify.h"
+#include "action.h"
+#include "ai.h"
+#include "move.h"
 #include "edit3d.h"
 #include "fpath.h"
 #include "cmddroid.h"
@@ -99,6 +105,7 @@
  */
 size_t loopPieCount;
 size_t loopPolyCount;
+size_t loopDrawCount;
 
 /*
  * local variables
@@ -336,7 +343,7 @@ static GAMECODE renderLoop()
 		wzPerfEnd(PERF_GUI);
 	}
 
-	pie_GetResetCounts(&loopPieCount, &loopPolyCount);
+	pie_GetResetCounts(&loopPieCount, &loopPolyCount, &loopDrawCount);
 
 	// deal with the mission state
 	switch (loopMissionState)
@@ -500,8 +507,27 @@ void countUpdate(bool synch)
 	}
 }
 
+/* Sense pass of the droid update: work out which neighbourhoods the droids are about to search for targets and
+ * obstacles, and search them in parallel. This only reads the grid, so the (serial) droidUpdate calls make exactly
+ * the same decisions as without it, they just don't need to search the grid themselves. */
+static void senseDroids()
+{
+	for (unsigned i = 0; i < MAX_PLAYERS; i++)
+	{
+		for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psCurr->psNext)
+		{
+			aiPrefetchDroid(psCurr);
+			actionPrefetchDroid(psCurr);
+			movePrefetchDroid(psCurr);
+		}
+	}
+	gridPrefetch();
+}
+
 static void gameStateUpdate()
 {
+	WZ_PROFILE_ZONE("gameStateUpdate");
+
 	syncDebug("map = \"%s\", pseudorandom 32-bit integer = 0x%08X, allocated = %d %d %d %d %d %d %d %d %d %d, position = %d %d %d %d %d %d %d %d %d %d", game.map, gameRandU32(),
 	          NetPlay.players[0].allocated, NetPlay.players[1].allocated, NetPlay.players[2].allocated, NetPlay.players[3].allocated, NetPlay.players[4].allocated, NetPlay.players[5].allocated, NetPlay.players[6].allocated, NetPlay.players[7].allocated, NetPlay.players[8].allocated, NetPlay.players[9].allocated,
 	          NetPlay.players[0].position, NetPlay.players[1].position, NetPlay.players[2].position, NetPlay.players[3].position, NetPlay.players[4].position, NetPlay.players[5].position, NetPlay.players[6].position, NetPlay.players[7].position, NetPlay.players[8].position, NetPlay.players[9].position
@@ -524,20 +550,29 @@ static void gameStateUpdate()
 
 	if (!paused && !scriptPaused())
 	{
+		BenchmarkTimer timer(BENCHMARK_SCRIPTS);
 		updateScripts();
 	}
 
 	// Update abandoned structures
 	handleAbandonedStructures();
 
-	// Update the visibility change stuff
-	visUpdateLevel();
+	{
+		BenchmarkTimer timer(BENCHMARK_VISIBILITY);
+
+		// Update the visibility change stuff
+		visUpdateLevel();
+	}
 
 	// Put all droids/structures/features into the grid.
 	gridReset();
 
-	// Check which objects are visible.
-	processVisibility();
+	{
+		BenchmarkTimer timer(BENCHMARK_VISIBILITY);
+
+		// Check which objects are visible.
+		processVisibility();
+	}
 
 	// Update the map.
 	mapUpdate();
@@ -548,46 +583,63 @@ static void gameStateUpdate()
 	// update the command droids
 	cmdDroidUpdate();
 
+	{
+		BenchmarkTimer timer(BENCHMARK_DROIDS);
+		senseDroids();
+	}
+
 	for (unsigned i = 0; i < MAX_PLAYERS; i++)
 	{
 		//update the current power available for a player
 		updatePlayerPower(i);
 
-		DROID *psNext;
-		for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
 		{
-			// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
-			psNext = psCurr->psNext;
-			droidUpdate(psCurr);
-		}
+			BenchmarkTimer timer(BENCHMARK_DROIDS);
 
-		for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
-		{
-			/* Copy the next pointer - not 100% sure if the droid could
-			get destroyed but this covers us anyway */
-			psNext = psCurr->psNext;
-			missionDroidUpdate(psCurr);
-		}
+			DROID *psNext;
+			for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
+				psNext = psCurr->psNext;
+				droidUpdate(psCurr);
+			}
 
-		// FIXME: These for-loops are code duplicationo
-		STRUCTURE *psNBuilding;
-		for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
-		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, false);
+			for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				/* Copy the next pointer - not 100% sure if the droid could
+				get destroyed but this covers us anyway */
+				psNext = psCurr->psNext;
+				missionDroidUpdate(psCurr);
+			}
 		}
-		for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+
 		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, true); // update for mission
+			BenchmarkTimer timer(BENCHMARK_STRUCTURES);
+
+			// FIXME: These for-loops are code duplicationo
+			STRUCTURE *psNBuilding;
+			for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, false);
+			}
+			for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, true); // update for mission
+			}
 		}
 	}
 
 	missionTimerUpdate();
 
-	proj_UpdateAll();
+	benchmarkProjectileStress();
+	{
+		BenchmarkTimer timer(BENCHMARK_PROJECTILES);
+		proj_UpdateAll();
+	}
 
 	FEATURE *psNFeat;
 	for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
@@ -596,8 +648,12 @@ static void gameStateUpdate()
 		featureUpdate(psCFeat);
 	}
 
-	// Free dead droid memory.
-	objmemUpdate();
+	{
+		BenchmarkTimer timer(BENCHMARK_OBJMEM);
+
+		// Free dead droid memory.
+		objmemUpdate();
+	}
 
 	// Must end update, since we may or may not have ticked, and some message queue processing code may vary depending on whether it's in an update.
 	gameTimeUpdateEnd();
@@ -673,8 +729,13 @@ GAMECODE gameLoop()
 
 		unsigned before = wzGetTicks();
 		syncDebug("Begin game state update, gameTime = %d", gameTime);
-		gameStateUpdate();
+		{
+			BenchmarkTimer timer(BENCHMARK_TICK);
+			gameStateUpdate();
+		}
 		syncDebug("End game state update, gameTime = %d", gameTime);
+		benchmarkTickDone();
+		replayVerifyTickDone();
 		unsigned after = wzGetTicks();
 
 		renderBudget -= (after - before) * renderFraction.n;
@@ -684,6 +745,7 @@ GAMECODE gameLoop()
 		ASSERT(deltaGraphicsTime == 0, "Shouldn't update graphics and game state at once.");
 	}
 	numForcedUpdatesLastCall = numFastForwardTicks;
+	replayVerifyFrameDone();
 
 	if (realTime - lastFlushTime >= 400u)
 	{
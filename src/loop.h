@@ -59,6 +59,7 @@ extern LEVEL_TYPE nextMissionType;
 
 extern size_t loopPieCount;
 extern size_t loopPolyCount;
+extern size_t loopDrawCount;
 
 GAMECODE gameLoop();
 void videoLoop();
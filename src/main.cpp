@@ -89,6 +89,7 @@
 #include "mission.h"
 #include "modding.h"
 #include "multiplay.h"
+#include "replayverify.h"
 #include "notifications.h"
 #include "qtscript.h"
 #include "research.h"
@@ -1029,8 +1030,15 @@ static void startGameLoop()
 	setMaxFastForwardTicks(WZ_DEFAULT_MAX_FASTFORWARD_TICKS, true); // default value / spectator "catch-up" behavior
 	if (NETisReplay())
 	{
-		// for replays, ensure we don't start off fast-forwarding
-		setMaxFastForwardTicks(0, true);
+		// for replays, ensure we don't start off fast-forwarding, unless verifying as fast as possible
+		if (replayVerifyEnabled())
+		{
+			setMaxFastForwardTicks(REPLAY_VERIFY_FASTFORWARD_TICKS, false);
+		}
+		else
+		{
+			setMaxFastForwardTicks(0, true);
+		}
 	}
 }
 
@@ -1793,6 +1801,12 @@ int realmain(int argc, char *argv[])
 		fflush(stdout);
 	}
 
+	// The socket benchmark needs no data, so run it before loading any
+	if (benchmarkSocketConnections() != 0)
+	{
+		return benchmarkSockets() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	// Find out where to find the data
 	scanDataDirs();
 
@@ -51,6 +51,7 @@
 #include "astar.h"
 #include "fpath.h"
 #include "levels.h"
+#include "visibility.h"
 #include "lib/framework/wzapp.h"
 
 #define GAME_TICKS_FOR_DANGER (GAME_TICKS_PER_SEC * 2)
@@ -1107,6 +1108,7 @@ bool mapShutdown()
 	mapDecals = nullptr;
 	psMapTiles = nullptr;
 	mapWidth = mapHeight = 0;
+	visTerrainChanged();
 	numTile_names = 0;
 	Tile_names = nullptr;
 	return true;
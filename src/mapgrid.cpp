@@ -25,34 +25,137 @@
  *
  */
 #include "lib/framework/types.h"
+#include "lib/framework/wzapp.h"
+#include "lib/framework/wzprofile.h"
 #include "objects.h"
 #include "map.h"
 
 #include "mapgrid.h"
 #include "pointtree.h"
+#include "benchmark.h"
 
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+/// Don't bother starting the prefetch threads for fewer queries than this.
+#define GRID_PREFETCH_MIN_QUERIES 128
+/// Maximum number of prefetch threads, not counting the main thread.
+#define GRID_PREFETCH_MAX_THREADS 3
 
 static PointTree *gridPointTree = nullptr;  // A quad-tree-like object.
+// gridPointTree is merged from two layers. Structures and features don't move, so their layer is kept between ticks,
+// and only rebuilt if one of them is added or removed. Points in the same place are ordered by object id, so the
+// query results only depend on the objects, not on the order things happened in.
+static PointTree *gridStaticTree = nullptr;
+static PointTree *gridDroidTree = nullptr;
+typedef std::vector<std::pair<BASE_OBJECT *, uint32_t>> GridObjectList;
+static GridObjectList gridStaticObjects;     ///< Objects in gridStaticTree, with ids (in case of reused pointers), in list order.
+static GridObjectList gridStaticObjectsNext;
 static PointTree::Filter *gridFiltersUnseen;
 static PointTree::Filter *gridFiltersDroidsByPlayer;
 
+struct GridQuery
+{
+	bool operator ==(GridQuery const &b) const
+	{
+		return x == b.x && y == b.y && radius == b.radius;
+	}
+
+	int32_t x, y;
+	uint32_t radius;
+};
+
+struct GridQueryHash
+{
+	size_t operator ()(GridQuery const &q) const
+	{
+		return ((uint32_t)q.x * 73856093u) ^ ((uint32_t)q.y * 19349663u) ^ (q.radius * 83492791u);
+	}
+};
+
+static std::vector<GridQuery> gridPrefetchQueries;                                   ///< Queries to run on the next gridPrefetch().
+static std::vector<PointTree::ResultVector> gridPrefetchResults;                     ///< Unfiltered point tree results, one per query.
+static std::unordered_map<GridQuery, unsigned, GridQueryHash> gridPrefetchIndex;     ///< Index into gridPrefetchResults, valid until the next gridReset().
+static std::atomic<size_t> gridPrefetchNext(0);                                      ///< Next query for a thread to pick up.
+static size_t gridPrefetchBegin = 0;                                                 ///< First query of the current gridPrefetch() call.
+static std::vector<WZ_THREAD *> gridPrefetchThreads;
+static WZ_SEMAPHORE *gridPrefetchStart = nullptr;
+static WZ_SEMAPHORE *gridPrefetchDone = nullptr;
+static volatile bool gridPrefetchQuit = false;
+static bool gridPrefetchEnabled = true;
+
+/// Runs queries until there are none left. Only reads the point tree, so may run on several threads at once.
+static void gridPrefetchWork()
+{
+	WZ_PROFILE_ZONE("gridPrefetchWork");
+
+	size_t end = gridPrefetchQueries.size();
+	for (size_t i = gridPrefetchNext++; i < end; i = gridPrefetchNext++)
+	{
+		GridQuery const &q = gridPrefetchQueries[i];
+		static_cast<PointTree const *>(gridPointTree)->query(q.x, q.y, q.radius, gridPrefetchResults[gridPrefetchBegin + i]);
+	}
+}
+
+static int gridPrefetchThreadFunc(void *)
+{
+	wzProfileThreadName("grid prefetch");
+	while (true)
+	{
+		wzSemaphoreWait(gridPrefetchStart);
+		if (gridPrefetchQuit)
+		{
+			break;
+		}
+		gridPrefetchWork();
+		wzSemaphorePost(gridPrefetchDone);
+	}
+	return 0;
+}
+
 // initialise the grid system
 bool gridInitialise()
 {
 	ASSERT(gridPointTree == nullptr, "gridInitialise already called, without calling gridShutDown.");
 	gridPointTree = new PointTree;
+	gridStaticTree = new PointTree;
+	gridDroidTree = new PointTree;
+	gridStaticObjects.clear();
 	gridFiltersUnseen = new PointTree::Filter[MAX_PLAYERS];
 	gridFiltersDroidsByPlayer = new PointTree::Filter[MAX_PLAYERS];
 
 	return true;  // Yay, nothing failed!
 }
 
+/// Started on the first gridPrefetch() with enough queries, so that there are no extra threads when prefetching is off.
+static void gridStartPrefetchThreads()
+{
+	gridPrefetchQuit = false;
+	gridPrefetchStart = wzSemaphoreCreate(0);
+	gridPrefetchDone = wzSemaphoreCreate(0);
+	unsigned count = std::min<unsigned>(std::max<int>(std::thread::hardware_concurrency(), 2) - 1, GRID_PREFETCH_MAX_THREADS);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		WZ_THREAD *thread = wzThreadCreate(gridPrefetchThreadFunc, nullptr);
+		gridPrefetchThreads.push_back(thread);
+		wzThreadStart(thread);
+	}
+}
+
 // reset the grid system
 void gridReset()
 {
-	gridPointTree->clear();
+	WZ_PROFILE_ZONE("gridReset");
+
+	// The prefetched results are only valid for the old point tree.
+	gridPrefetchQueries.clear();
+	gridPrefetchIndex.clear();
+
+	gridDroidTree->clear();
+	gridStaticObjectsNext.clear();
 
-	// Put all existing objects into the point tree.
+	// Put all existing droids into the droid layer, and check whether the structures and features changed.
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
 	{
 		BASE_OBJECT *start[3] = {(BASE_OBJECT *)apsDroidLists[player], (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
@@ -62,7 +165,14 @@ void gridReset()
 			{
 				if (!psObj->died)
 				{
-					gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
+					if (psObj->type == OBJ_DROID)
+					{
+						gridDroidTree->insert(psObj, psObj->pos.x, psObj->pos.y, psObj->id);
+					}
+					else
+					{
+						gridStaticObjectsNext.emplace_back(psObj, psObj->id);
+					}
 					for (unsigned char &viewer : psObj->seenThisTick)
 					{
 						viewer = 0;
@@ -72,7 +182,38 @@ void gridReset()
 		}
 	}
 
-	gridPointTree->sort();
+	if (gridStaticObjectsNext != gridStaticObjects)
+	{
+		gridStaticTree->clear();
+		for (auto const &obj : gridStaticObjectsNext)
+		{
+			gridStaticTree->insert(obj.first, obj.first->pos.x, obj.first->pos.y, obj.second);
+		}
+		gridStaticTree->sort();
+		std::swap(gridStaticObjects, gridStaticObjectsNext);
+	}
+	gridDroidTree->sort();
+	gridPointTree->merge(*gridStaticTree, *gridDroidTree);
+
+#ifdef DEBUG
+	PointTree check;
+	for (unsigned player = 0; player < MAX_PLAYERS; player++)
+	{
+		BASE_OBJECT *start[3] = {(BASE_OBJECT *)apsDroidLists[player], (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
+		for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
+		{
+			for (BASE_OBJECT *psObj = start[type]; psObj != nullptr; psObj = psObj->psNext)
+			{
+				if (!psObj->died)
+				{
+					check.insert(psObj, psObj->pos.x, psObj->pos.y, psObj->id);
+				}
+			}
+		}
+	}
+	check.sort();
+	ASSERT(check == *gridPointTree, "Grid layers are out of date.");
+#endif
 
 	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
 	{
@@ -84,8 +225,35 @@ void gridReset()
 // shutdown the grid system
 void gridShutDown()
 {
+	gridPrefetchQuit = true;
+	for (size_t i = 0; i < gridPrefetchThreads.size(); ++i)
+	{
+		wzSemaphorePost(gridPrefetchStart);  // Wake up threads.
+	}
+	for (WZ_THREAD *thread : gridPrefetchThreads)
+	{
+		wzThreadJoin(thread);
+	}
+	gridPrefetchThreads.clear();
+	if (gridPrefetchStart != nullptr)
+	{
+		wzSemaphoreDestroy(gridPrefetchStart);
+		gridPrefetchStart = nullptr;
+		wzSemaphoreDestroy(gridPrefetchDone);
+		gridPrefetchDone = nullptr;
+	}
+	gridPrefetchQueries.clear();
+	gridPrefetchResults.clear();
+	gridPrefetchIndex.clear();
+
 	delete gridPointTree;
 	gridPointTree = nullptr;
+	delete gridStaticTree;
+	gridStaticTree = nullptr;
+	delete gridDroidTree;
+	gridDroidTree = nullptr;
+	gridStaticObjects.clear();
+	gridStaticObjectsNext.clear();
 	delete[] gridFiltersUnseen;
 	gridFiltersUnseen = nullptr;
 	delete[] gridFiltersDroidsByPlayer;
@@ -103,9 +271,27 @@ static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
 template<class Condition>
 static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
 {
+	static GridList gridList;
 	if (filter == nullptr)
 	{
-		gridPointTree->query(x, y, radius);
+		benchmarkCount(BENCHMARK_GRID_QUERIES, 1);
+		auto prefetched = gridPrefetchIndex.find(GridQuery{x, y, radius});
+		if (prefetched != gridPrefetchIndex.end())
+		{
+			PointTree::ResultVector const &results = gridPrefetchResults[prefetched->second];
+#ifdef DEBUG
+			PointTree::ResultVector check;
+			static_cast<PointTree const *>(gridPointTree)->query(x, y, radius, check);
+			ASSERT(check == results, "Prefetched grid query (%d, %d, %u) is out of date.", x, y, radius);
+#endif
+			benchmarkCount(BENCHMARK_GRID_PREFETCH_HITS, 1);
+			// Use the prefetched results as if just queried, so lastQueryResults (and gridIterateDup()) stay right.
+			gridPointTree->lastQueryResults.assign(results.begin(), results.end());
+		}
+		else
+		{
+			gridPointTree->query(x, y, radius);
+		}
 	}
 	else
 	{
@@ -130,7 +316,6 @@ static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t r
 	// In case you are curious.
 	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
 	*/
-	static GridList gridList;
 	gridList.resize(gridPointTree->lastQueryResults.size());
 	for (unsigned n = 0; n < gridList.size(); ++n)
 	{
@@ -166,6 +351,73 @@ GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
 	return gridStartIterateFiltered(x, y, radius, nullptr, ConditionTrue());
 }
 
+void gridSetPrefetch(bool enable)
+{
+	gridPrefetchEnabled = enable;
+}
+
+bool gridGetPrefetch()
+{
+	return gridPrefetchEnabled;
+}
+
+void gridQueuePrefetch(int32_t x, int32_t y, uint32_t radius)
+{
+	if (gridPrefetchEnabled)
+	{
+		gridPrefetchQueries.push_back(GridQuery{x, y, radius});
+	}
+}
+
+void gridPrefetch()
+{
+	WZ_PROFILE_ZONE("gridPrefetch");
+
+	if (gridPrefetchQueries.size() < GRID_PREFETCH_MIN_QUERIES)
+	{
+		gridPrefetchQueries.clear();  // Not worth waking the threads, gridStartIterate will just run the queries itself.
+		return;
+	}
+	if (gridPrefetchStart == nullptr)
+	{
+		gridStartPrefetchThreads();
+	}
+	if (gridPrefetchThreads.empty())
+	{
+		gridPrefetchQueries.clear();  // Single core, nothing to run the queries in parallel with.
+		return;
+	}
+
+	// Drop queries we already have results for, including duplicates within this batch.
+	gridPrefetchBegin = gridPrefetchIndex.size();
+	size_t numQueries = 0;
+	for (GridQuery const &q : gridPrefetchQueries)
+	{
+		if (gridPrefetchIndex.emplace(q, gridPrefetchBegin + numQueries).second)
+		{
+			gridPrefetchQueries[numQueries++] = q;
+		}
+	}
+	gridPrefetchQueries.resize(numQueries);
+	benchmarkCount(BENCHMARK_GRID_PREFETCHED, numQueries);
+	if (gridPrefetchResults.size() < gridPrefetchBegin + numQueries)
+	{
+		gridPrefetchResults.resize(gridPrefetchBegin + numQueries);  // Kept between ticks, to avoid reallocating the result vectors.
+	}
+
+	gridPrefetchNext = 0;
+	for (size_t i = 0; i < gridPrefetchThreads.size(); ++i)
+	{
+		wzSemaphorePost(gridPrefetchStart);
+	}
+	gridPrefetchWork();  // Help out, rather than just waiting.
+	for (size_t i = 0; i < gridPrefetchThreads.size(); ++i)
+	{
+		wzSemaphoreWait(gridPrefetchDone);
+	}
+	gridPrefetchQueries.clear();
+}
+
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
 	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
@@ -40,6 +40,17 @@ void gridReset();
 /// Find all objects within radius.
 GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
 
+/// Enables or disables prefetching (the gridPrefetch config option). When disabled, gridQueuePrefetch() does nothing.
+void gridSetPrefetch(bool enable);
+bool gridGetPrefetch();
+
+/// Queues a gridStartIterate(x, y, radius) query, to be run by the next gridPrefetch().
+void gridQueuePrefetch(int32_t x, int32_t y, uint32_t radius);
+
+/// Runs all queued queries on several threads. Later gridStartIterate calls with the same arguments reuse the results,
+/// until the next gridReset(). The results are the same as without prefetching, since the grid only changes in gridReset().
+void gridPrefetch();
+
 /// Find all objects within radius.
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
 
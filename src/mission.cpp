@@ -1337,6 +1337,7 @@ void swapMissionPointers()
 	std::swap(psMapTiles, mission.psMapTiles);
 	std::swap(mapWidth,   mission.mapWidth);
 	std::swap(mapHeight,  mission.mapHeight);
+	visTerrainChanged();
 	for (int i = 0; i < ARRAY_SIZE(mission.psBlockMap); ++i)
 	{
 		std::swap(psBlockMap[i], mission.psBlockMap[i]);
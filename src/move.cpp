@@ -2052,6 +2052,34 @@ static void checkLocalFeatures(DROID *psDroid)
 
 
 /* Frame update for the movement of a tracked droid */
+// Queue the grid searches moveUpdateDroid is likely to make this tick, before the droid moves, so that gridPrefetch can run them in parallel.
+void movePrefetchDroid(DROID *psDroid)
+{
+	if (psDroid->died)
+	{
+		return;
+	}
+
+	switch (psDroid->sMove.Status)
+	{
+	case MOVENAVIGATE:
+	case MOVEPOINTTOPOINT:
+	case MOVESHUFFLE:
+		if (!isTransporter(psDroid))
+		{
+			gridQueuePrefetch(psDroid->pos.x, psDroid->pos.y, AVOID_DIST);  // moveGetObstacleVector
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (asPropulsionStats[psDroid->asBits[COMP_PROPULSION]].propulsionType != PROPULSION_TYPE_LIFT)
+	{
+		gridQueuePrefetch(psDroid->pos.x, psDroid->pos.y, OBJ_MAXRADIUS);  // moveCheckSquished and moveCalcDroidSlide
+	}
+}
+
 void moveUpdateDroid(DROID *psDroid)
 {
 	UDWORD				oldx, oldy;
@@ -49,6 +49,9 @@ void moveReallyStopDroid(DROID *psDroid);
 /* Get a droid to do a frame's worth of moving */
 void moveUpdateDroid(DROID *psDroid);
 
+/* Queue the grid searches moveUpdateDroid is likely to need, see gridPrefetch() */
+void movePrefetchDroid(DROID *psDroid);
+
 SDWORD moveCalcDroidSpeed(DROID *psDroid);
 
 /* update body and turret to local slope */
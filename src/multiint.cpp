@@ -72,6 +72,7 @@
 #include "objmem.h"
 #include "gateway.h"
 #include "clparse.h"
+#include "benchmark.h"
 #include "configuration.h"
 #include "intdisplay.h"
 #include "design.h"
@@ -80,6 +81,7 @@
 #include "loadsave.h"			// for blueboxes.
 #include "component.h"
 #include "map.h"
+#include "astar.h"
 #include "console.h"			// chat box stuff
 #include "frend.h"
 #include "advvis.h"
@@ -4774,6 +4776,10 @@ void WzMultiplayerOptionsTitleUI::addPlayerBox(bool players)
 static void SendFireUp()
 {
 	uint32_t randomSeed = rand();  // Pick a random random seed for the synchronised random number generator.
+	if (benchmarkTicks() != 0)
+	{
+		randomSeed = BENCHMARK_SEED;  // Simulate the same game each time.
+	}
 
 	NETbeginEncode(NETbroadcastQueue(), NET_FIREUP);
 	NETuint32_t(&randomSeed);
@@ -8163,6 +8169,9 @@ bool WZGameReplayOptionsHandler::saveOptions(nlohmann::json& object) const
 	// Save `NetPlay.bComms`
 	object["netplay.bComms"] = NetPlay.bComms;
 
+	// Save whether routes are planned on the cluster graph, since it changes the routes
+	object["pathHierarchical"] = fpathGetHierarchicalGame();
+
 //	// Save `NetPlay.isHost` (but don't load it)
 //	object["netplay.isHost"] = NetPlay.isHost;
 
@@ -8325,6 +8334,9 @@ bool WZGameReplayOptionsHandler::restoreOptions(const nlohmann::json& object, Em
 	// restore `NetPlay.bComms` (?)
 	NetPlay.bComms = object.at("netplay.bComms").get<bool>();
 
+	// restore whether routes are planned on the cluster graph (older replays don't have it, and used plain A*)
+	fpathSetHierarchicalGame(object.value("pathHierarchical", false));
+
 	// restore multistats
 	if (!loadMultiStatsFromJSON(object.at("multistats")))
 	{
@@ -68,6 +68,7 @@
 #include "lib/netplay/netplay.h"								// the netplay library.
 #include "modding.h"
 #include "multiplay.h"								// warzone net stuff.
+#include "replayverify.h"
 #include "multijoin.h"								// player management stuff.
 #include "multirecv.h"								// incoming messages stuff
 #include "multistat.h"
@@ -78,6 +79,7 @@
 #include "multiint.h"
 #include "activity.h"
 #include "lib/framework/wztime.h"
+#include "lib/framework/wzprofile.h"
 #include "chat.h" // for InGameChatMessage
 #include "warzoneconfig.h"
 #include "stdinreader.h"
@@ -1135,6 +1137,8 @@ bool shouldProcessMessage(NETQUEUE& queue, uint8_t type)
 // Recv Messages. Get a message and dispatch to relevant function.
 bool recvMessage()
 {
+	WZ_PROFILE_ZONE("recvMessage");
+
 	NETQUEUE queue;
 	uint8_t type;
 
@@ -1224,6 +1228,7 @@ bool recvMessage()
 				}
 				addConsoleMessage(_("REPLAY HAS ENDED"), CENTRE_JUSTIFY, SYSTEM_MESSAGE, false, MAX_CONSOLE_MESSAGE_DURATION);
 				addConsoleMessage(_("(Press ESC to quit.)"), CENTRE_JUSTIFY, SYSTEM_MESSAGE, false, MAX_CONSOLE_MESSAGE_DURATION);
+				replayVerifyReplayEnded();
 				break;
 			default:
 				processedMessage1 = false;
@@ -42,6 +42,9 @@
 #include "visibility.h"
 #include "qtscript.h"
 
+#include <unordered_map>
+#include <unordered_set>
+
 // the initial value for the object ID
 #define OBJ_ID_INIT 20000
 
@@ -65,6 +68,11 @@ FLAG_POSITION	*apsFlagPosLists[MAX_PLAYERS];
 /* The list of destroyed objects */
 BASE_OBJECT		*psDestroyedObj = nullptr;
 
+uint32_t		objListGeneration = 0;
+
+/* Index of the objects in the lists above (and in transporters), by id. Objects leave it when destroyed. */
+static std::unordered_map<uint32_t, BASE_OBJECT *> objIdIndex;
+
 /* Forward function declarations */
 #ifdef DEBUG
 static void objListIntegCheck();
@@ -84,6 +92,85 @@ bool objmemInitialise()
 /* Release the object heaps */
 void objmemShutdown()
 {
+	objIdIndex.clear();
+}
+
+void objmemIndexObject(BASE_OBJECT *psObj)
+{
+	objIdIndex[psObj->id] = psObj;
+}
+
+void objmemUnindexObject(BASE_OBJECT *psObj)
+{
+	auto it = objIdIndex.find(psObj->id);
+	if (it != objIdIndex.end() && it->second == psObj)  // Don't remove another object which happens to have the same id.
+	{
+		objIdIndex.erase(it);
+	}
+}
+
+void objmemSetObjectId(BASE_OBJECT *psObj, uint32_t id)
+{
+	auto it = objIdIndex.find(psObj->id);
+	bool indexed = it != objIdIndex.end() && it->second == psObj;
+	objmemUnindexObject(psObj);
+	psObj->id = id;
+	if (indexed)
+	{
+		objmemIndexObject(psObj);
+	}
+}
+
+bool objmemCheckIdIndex()
+{
+	std::unordered_set<BASE_OBJECT const *> listed;
+	bool ok = true;
+	auto checkObject = [&](BASE_OBJECT *psObj) {
+		listed.insert(psObj);
+		auto it = objIdIndex.find(psObj->id);
+		if (it == objIdIndex.end() || it->second != psObj)
+		{
+			debug(LOG_ERROR, "%s is not in the object index under its id", objInfo(psObj));
+			ok = false;
+		}
+	};
+	auto checkList = [&](BASE_OBJECT *psList) {
+		for (BASE_OBJECT *psObj = psList; psObj != nullptr; psObj = psObj->psNext)
+		{
+			checkObject(psObj);
+			if (psObj->type == OBJ_DROID && isTransporter((DROID *)psObj))
+			{
+				for (DROID *psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
+				{
+					if (psTrans != psObj)
+					{
+						checkObject(psTrans);
+					}
+				}
+			}
+		}
+	};
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		checkList(apsDroidLists[player]);
+		checkList(apsStructLists[player]);
+		checkList(mission.apsDroidLists[player]);
+		checkList(mission.apsStructLists[player]);
+	}
+	checkList(apsFeatureLists[0]);
+	checkList(mission.apsFeatureLists[0]);
+	checkList(apsLimboDroids[0]);
+
+	for (auto const &entry : objIdIndex)
+	{
+		// Only look inside listed objects, anything else may already be freed.
+		if (listed.count(entry.second) == 0 || entry.second->id != entry.first)
+		{
+			debug(LOG_ERROR, "Stale object index entry for id %u", entry.first);
+			ok = false;
+		}
+	}
+	return ok;
 }
 
 // Check that psVictim is not referred to by any other object in the game. We can dump out some extra data in debug builds that help track down sources of dangling pointer errors.
@@ -228,6 +315,9 @@ static inline void addObjectToList(OBJECT *list[], OBJECT *object, int player)
 	// Prepend the object to the top of the list
 	object->psNext = list[player];
 	list[player] = object;
+	++objListGeneration;
+
+	objmemIndexObject(object);
 }
 
 /* Add the object to its list
@@ -254,6 +344,9 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 	ASSERT(gameTime - deltaGameTime <= gameTime || gameTime == 2, "Expected %u <= %u, bad time", gameTime - deltaGameTime, gameTime);
 
+	objmemUnindexObject(object);
+	++objListGeneration;
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[object->player] == object)
 	{
@@ -299,6 +392,7 @@ template <typename OBJECT>
 static inline void removeObjectFromList(OBJECT *list[], OBJECT *object, int player)
 {
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
+	++objListGeneration;
 
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[player] == object)
@@ -357,6 +451,7 @@ static inline void removeObjectFromFuncList(OBJECT *list[], OBJECT *object, int
 template <typename OBJECT>
 static inline void releaseAllObjectsInList(OBJECT *list[])
 {
+	++objListGeneration;
 	// Iterate through all players' object lists
 	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
 	{
@@ -756,8 +851,9 @@ void checkFactoryFlags()
 
 /**************************  OBJECT ACCESS FUNCTIONALITY ********************************/
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+#ifdef DEBUG
+// Find a base object from it's id, by searching the object lists. Used to check objIdIndex.
+static BASE_OBJECT *findBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
 {
 	BASE_OBJECT		*psObj;
 	DROID			*psTrans;
@@ -813,13 +909,12 @@ BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
 			psObj = psObj->psNext;
 		}
 	}
-	ASSERT(false, "failed to find id %d for player %d", id, player);
 
 	return nullptr;
 }
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromId(UDWORD id)
+// Find a base object from it's id, by searching the object lists. Used to check objIdIndex.
+static BASE_OBJECT *findBaseObjFromId(UDWORD id)
 {
 	unsigned int i;
 	UDWORD			player;
@@ -900,10 +995,40 @@ BASE_OBJECT *getBaseObjFromId(UDWORD id)
 			}
 		}
 	}
-	ASSERT(!"couldn't find a BASE_OBJ with ID", "getBaseObjFromId() failed for id %d", id);
 
 	return nullptr;
 }
+#endif
+
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+{
+	auto it = objIdIndex.find(id);
+	BASE_OBJECT *psObj = it != objIdIndex.end() ? it->second : nullptr;
+	if (psObj != nullptr && (psObj->type != type || (type != OBJ_FEATURE && psObj->player != player)))
+	{
+		psObj = nullptr;
+	}
+#ifdef DEBUG
+	ASSERT(psObj == findBaseObjFromData(id, player, type), "Object index out of date for id %d", id);
+#endif
+	ASSERT(psObj != nullptr, "failed to find id %d for player %d", id, player);
+
+	return psObj;
+}
+
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromId(UDWORD id)
+{
+	auto it = objIdIndex.find(id);
+	BASE_OBJECT *psObj = it != objIdIndex.end() ? it->second : nullptr;
+#ifdef DEBUG
+	ASSERT(psObj == findBaseObjFromId(id), "Object index out of date for id %d", id);
+#endif
+	ASSERT(psObj != nullptr, "getBaseObjFromId() failed for id %d", id);
+
+	return psObj;
+}
 
 UDWORD getRepairIdFromFlag(FLAG_POSITION *psFlag)
 {
@@ -38,6 +38,10 @@ extern FEATURE			*apsOilList[1];
 /* The list of destroyed objects */
 extern BASE_OBJECT	*psDestroyedObj;
 
+/// Incremented whenever an object is added to or removed from one of the object lists. Lists which are replaced as a
+/// whole (when swapping mission lists, or loading) are not counted, so users should also check the list heads.
+extern uint32_t objListGeneration;
+
 /* Initialise the object heaps */
 bool objmemInitialise();
 
@@ -100,6 +104,15 @@ void removeFlagPosition(FLAG_POSITION *psDel);
 // free all flag positions
 void freeAllFlagPositions();
 
+/* Add an object to the id index used by getBaseObjFromId. Done by the functions adding objects to the lists. */
+void objmemIndexObject(BASE_OBJECT *psObj);
+/* Remove an object from the id index */
+void objmemUnindexObject(BASE_OBJECT *psObj);
+/* Change the id of an object, keeping it in the id index if it was there. Used when loading saved ids. */
+void objmemSetObjectId(BASE_OBJECT *psObj, uint32_t id);
+/* Check that every listed object can be found by its id, and that the index has nothing else. For tests. */
+bool objmemCheckIdIndex();
+
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type);
 BASE_OBJECT *getBaseObjFromId(UDWORD id);
@@ -0,0 +1,481 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Hierarchical (HPA*) path finding layer.
+ *  Movement costs and rules match the tile A* in astar.cpp: 140 for straight moves, 198 for diagonal moves, five times
+ *  as much when entering a dangerous tile, and no cutting corners past blocking tiles.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "pathcluster.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+
+/// Runs of passable tiles along a border at least this long get an entrance at each end, instead of one in the middle.
+#define PATH_CLUSTER_LONG_ENTRANCE 6
+
+/// Maximum number of neighbouring clusters a tile can border on (more than 2 only if a cluster is a single tile wide).
+#define PATH_CLUSTER_MAX_ACROSS 4
+
+struct PathCluster
+{
+	std::vector<Vector2i> nodes;    ///< Entrance tiles in this cluster, sorted by position.
+	std::vector<unsigned> costs;    ///< Cost of moving from nodes[a] to nodes[b] without leaving the cluster is costs[a * nodes.size() + b], or UINT_MAX if not possible.
+};
+
+struct PathClusterGraph
+{
+	bool isBlocked(int x, int y) const
+	{
+		return x < 0 || y < 0 || x >= width || y >= height || (tiles[x + y * width] & PATH_CLUSTER_BLOCKED) != 0;
+	}
+	unsigned costFactor(Vector2i pos) const
+	{
+		return (tiles[pos.x + pos.y * width] & PATH_CLUSTER_DANGER) != 0 ? 5 : 1;
+	}
+	unsigned clusterAt(Vector2i pos) const
+	{
+		return pos.x / PATH_CLUSTER_SIZE + pos.y / PATH_CLUSTER_SIZE * clustersX;
+	}
+
+	int width = 0, height = 0;                  ///< Size of the map, in tiles.
+	int clustersX = 0, clustersY = 0;           ///< Number of clusters along each axis.
+	std::vector<uint8_t> tiles;                 ///< PATH_CLUSTER_BLOCKED and PATH_CLUSTER_DANGER bits for each tile.
+	std::vector<PathCluster> clusters;
+
+	// Global numbering of the nodes of all clusters, regenerated from clusters whenever anything changes.
+	std::vector<unsigned> firstNode;            ///< Index of the first node of each cluster.
+	std::vector<Vector2i> nodePos;              ///< Tile of each node.
+	std::vector<unsigned> nodeCluster;          ///< Cluster of each node.
+	std::vector<int> nodeAcross;                ///< PATH_CLUSTER_MAX_ACROSS per node. Nodes next to this one, in other clusters, or -1.
+};
+
+// Same order as aDirOffset in astar.cpp, odd directions are diagonal.
+static const Vector2i clusterDirOffset[] =
+{
+	Vector2i(0, 1),
+	Vector2i(-1, 1),
+	Vector2i(-1, 0),
+	Vector2i(-1, -1),
+	Vector2i(0, -1),
+	Vector2i(1, -1),
+	Vector2i(1, 0),
+	Vector2i(1, 1),
+};
+
+static bool clusterPosLess(Vector2i const &a, Vector2i const &b)
+{
+	return a.y != b.y ? a.y < b.y : a.x < b.x;
+}
+
+/// Same as fpathEstimate in astar.cpp.
+static inline unsigned clusterEstimate(Vector2i s, Vector2i f)
+{
+	unsigned xDelta = abs(s.x - f.x), yDelta = abs(s.y - f.y);
+	return std::min(xDelta, yDelta) * (198 - 140) + std::max(xDelta, yDelta) * 140;
+}
+
+/// Gets the tile area covered by a cluster.
+static void clusterBounds(PathClusterGraph const &graph, int cx, int cy, int &x0, int &y0, int &w, int &h)
+{
+	x0 = cx * PATH_CLUSTER_SIZE;
+	y0 = cy * PATH_CLUSTER_SIZE;
+	w = std::min(PATH_CLUSTER_SIZE, graph.width - x0);
+	h = std::min(PATH_CLUSTER_SIZE, graph.height - y0);
+}
+
+/** Finds the entrances across a border, adding the tiles on the near side to nodes.
+ *
+ *  The tiles first + along*i for 0 <= i < length are on the near side of the border, and first + along*i + across are
+ *  on the far side. Scanning the border from either side gives the same entrances.
+ */
+static void clusterFindEntrances(PathClusterGraph const &graph, Vector2i first, Vector2i along, Vector2i across, int length, std::vector<Vector2i> &nodes)
+{
+	int runStart = -1;
+	for (int i = 0; i <= length; ++i)
+	{
+		Vector2i nearTile = first + along * i;
+		Vector2i farTile = nearTile + across;
+		bool open = i < length && !graph.isBlocked(nearTile.x, nearTile.y) && !graph.isBlocked(farTile.x, farTile.y);
+		if (open && runStart < 0)
+		{
+			runStart = i;
+		}
+		else if (!open && runStart >= 0)
+		{
+			int runEnd = i - 1;
+			if (runEnd - runStart + 1 < PATH_CLUSTER_LONG_ENTRANCE)
+			{
+				nodes.push_back(first + along * ((runStart + runEnd) / 2));
+			}
+			else
+			{
+				nodes.push_back(first + along * runStart);
+				nodes.push_back(first + along * runEnd);
+			}
+			runStart = -1;
+		}
+	}
+}
+
+/** Calculates the cost of moving from the tile from to every tile in the cluster, without leaving the cluster.
+ *
+ *  If reverse is set, calculates the cost of moving from every tile in the cluster to the tile from, instead.
+ *  The result is indexed by (x - x0) + (y - y0) * w, where x0, y0, w are from clusterBounds.
+ */
+static void clusterDijkstra(PathClusterGraph const &graph, int cx, int cy, Vector2i from, bool reverse, std::vector<unsigned> &dist)
+{
+	int x0, y0, w, h;
+	clusterBounds(graph, cx, cy, x0, y0, w, h);
+
+	typedef std::pair<unsigned, int> OpenTile;  // Cost and index.
+	std::priority_queue<OpenTile, std::vector<OpenTile>, std::greater<OpenTile>> open;
+
+	dist.assign(w * h, UINT_MAX);
+	int fromIndex = (from.x - x0) + (from.y - y0) * w;
+	dist[fromIndex] = 0;
+	open.push(OpenTile(0, fromIndex));
+	while (!open.empty())
+	{
+		OpenTile tile = open.top();
+		open.pop();
+		if (tile.first != dist[tile.second])
+		{
+			continue;  // Already found a shorter way here.
+		}
+		Vector2i p(x0 + tile.second % w, y0 + tile.second / w);
+		for (unsigned dir = 0; dir < ARRAY_SIZE(clusterDirOffset); ++dir)
+		{
+			Vector2i q = p + clusterDirOffset[dir];
+			if (q.x < x0 || q.y < y0 || q.x >= x0 + w || q.y >= y0 + h || graph.isBlocked(q.x, q.y))
+			{
+				continue;
+			}
+			bool isDiagonal = dir % 2 != 0;
+			if (isDiagonal)
+			{
+				// We cannot cut corners. The same tiles are in the way, whichever direction we go.
+				Vector2i a = p + clusterDirOffset[(dir + 1) % 8];
+				Vector2i b = p + clusterDirOffset[(dir + 7) % 8];
+				if (graph.isBlocked(a.x, a.y) || graph.isBlocked(b.x, b.y))
+				{
+					continue;
+				}
+			}
+			// The cost depends on the tile being entered.
+			unsigned newDist = tile.first + (isDiagonal ? 198 : 140) * graph.costFactor(reverse ? p : q);
+			int qIndex = (q.x - x0) + (q.y - y0) * w;
+			if (newDist < dist[qIndex])
+			{
+				dist[qIndex] = newDist;
+				open.push(OpenTile(newDist, qIndex));
+			}
+		}
+	}
+}
+
+/// Finds the entrances of a cluster and the costs of moving between them.
+static void clusterBuild(PathClusterGraph const &graph, int cx, int cy, PathCluster &cluster)
+{
+	int x0, y0, w, h;
+	clusterBounds(graph, cx, cy, x0, y0, w, h);
+
+	cluster.nodes.clear();
+	if (cx > 0)
+	{
+		clusterFindEntrances(graph, Vector2i(x0, y0), Vector2i(0, 1), Vector2i(-1, 0), h, cluster.nodes);
+	}
+	if (cx < graph.clustersX - 1)
+	{
+		clusterFindEntrances(graph, Vector2i(x0 + w - 1, y0), Vector2i(0, 1), Vector2i(1, 0), h, cluster.nodes);
+	}
+	if (cy > 0)
+	{
+		clusterFindEntrances(graph, Vector2i(x0, y0), Vector2i(1, 0), Vector2i(0, -1), w, cluster.nodes);
+	}
+	if (cy < graph.clustersY - 1)
+	{
+		clusterFindEntrances(graph, Vector2i(x0, y0 + h - 1), Vector2i(1, 0), Vector2i(0, 1), w, cluster.nodes);
+	}
+	std::sort(cluster.nodes.begin(), cluster.nodes.end(), clusterPosLess);
+	cluster.nodes.erase(std::unique(cluster.nodes.begin(), cluster.nodes.end()), cluster.nodes.end());
+
+	size_t numNodes = cluster.nodes.size();
+	cluster.costs.resize(numNodes * numNodes);
+	std::vector<unsigned> dist;
+	for (size_t a = 0; a < numNodes; ++a)
+	{
+		clusterDijkstra(graph, cx, cy, cluster.nodes[a], false, dist);
+		for (size_t b = 0; b < numNodes; ++b)
+		{
+			Vector2i pos = cluster.nodes[b];
+			cluster.costs[a * numNodes + b] = dist[(pos.x - x0) + (pos.y - y0) * w];
+		}
+	}
+}
+
+/// Numbers the nodes of all clusters, and finds which nodes are next to each other across cluster borders.
+static void clusterIndexNodes(PathClusterGraph &graph)
+{
+	graph.firstNode.resize(graph.clusters.size() + 1);
+	graph.nodePos.clear();
+	graph.nodeCluster.clear();
+	for (unsigned c = 0; c < graph.clusters.size(); ++c)
+	{
+		graph.firstNode[c] = graph.nodePos.size();
+		graph.nodePos.insert(graph.nodePos.end(), graph.clusters[c].nodes.begin(), graph.clusters[c].nodes.end());
+		graph.nodeCluster.resize(graph.nodePos.size(), c);
+	}
+	graph.firstNode[graph.clusters.size()] = graph.nodePos.size();
+
+	graph.nodeAcross.assign(graph.nodePos.size() * PATH_CLUSTER_MAX_ACROSS, -1);
+	for (unsigned node = 0; node < graph.nodePos.size(); ++node)
+	{
+		unsigned numAcross = 0;
+		for (unsigned dir = 0; dir < ARRAY_SIZE(clusterDirOffset); dir += 2)
+		{
+			Vector2i pos = graph.nodePos[node] + clusterDirOffset[dir];
+			if (pos.x < 0 || pos.y < 0 || pos.x >= graph.width || pos.y >= graph.height)
+			{
+				continue;
+			}
+			unsigned c = graph.clusterAt(pos);
+			if (c == graph.nodeCluster[node])
+			{
+				continue;
+			}
+			std::vector<Vector2i> const &nodes = graph.clusters[c].nodes;
+			auto i = std::lower_bound(nodes.begin(), nodes.end(), pos, clusterPosLess);
+			if (i != nodes.end() && *i == pos)
+			{
+				graph.nodeAcross[node * PATH_CLUSTER_MAX_ACROSS + numAcross++] = graph.firstNode[c] + (i - nodes.begin());
+			}
+		}
+	}
+}
+
+std::shared_ptr<PathClusterGraph const> pathClusterUpdate(std::shared_ptr<PathClusterGraph const> const &oldGraph, std::vector<uint8_t> &&tiles, int width, int height)
+{
+	ASSERT_OR_RETURN(nullptr, tiles.size() == static_cast<size_t>(width) * static_cast<size_t>(height), "Bad tile array size");
+
+	std::shared_ptr<PathClusterGraph> graph = std::make_shared<PathClusterGraph>();
+	graph->width = width;
+	graph->height = height;
+	graph->clustersX = (width + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+	graph->clustersY = (height + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+	graph->tiles = std::move(tiles);
+
+	std::vector<bool> dirty(graph->clustersX * graph->clustersY, true);
+	if (oldGraph != nullptr && oldGraph->width == width && oldGraph->height == height)
+	{
+		graph->clusters = oldGraph->clusters;
+		std::fill(dirty.begin(), dirty.end(), false);
+		bool changed = false;
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x)
+			{
+				if (graph->tiles[x + y * width] == oldGraph->tiles[x + y * width])
+				{
+					continue;
+				}
+				changed = true;
+				// Entrances depend on the tiles on both sides of a border, so the neighbouring clusters are affected too.
+				int cx = x / PATH_CLUSTER_SIZE, cy = y / PATH_CLUSTER_SIZE;
+				dirty[cx + cy * graph->clustersX] = true;
+				if (cx > 0)
+				{
+					dirty[cx - 1 + cy * graph->clustersX] = true;
+				}
+				if (cx < graph->clustersX - 1)
+				{
+					dirty[cx + 1 + cy * graph->clustersX] = true;
+				}
+				if (cy > 0)
+				{
+					dirty[cx + (cy - 1) * graph->clustersX] = true;
+				}
+				if (cy < graph->clustersY - 1)
+				{
+					dirty[cx + (cy + 1) * graph->clustersX] = true;
+				}
+			}
+		if (!changed)
+		{
+			return oldGraph;
+		}
+	}
+	else
+	{
+		graph->clusters.resize(dirty.size());
+	}
+
+	for (int cy = 0; cy < graph->clustersY; ++cy)
+		for (int cx = 0; cx < graph->clustersX; ++cx)
+		{
+			if (dirty[cx + cy * graph->clustersX])
+			{
+				clusterBuild(*graph, cx, cy, graph->clusters[cx + cy * graph->clustersX]);
+			}
+		}
+	clusterIndexNodes(*graph);
+
+	return graph;
+}
+
+/// Open node in the cluster graph search. Same ordering as PathNode in astar.cpp.
+struct ClusterOpenNode
+{
+	bool operator <(ClusterOpenNode const &z) const
+	{
+		// Sort descending est, fallback to ascending dist, fallback to sorting by node.
+		if (est != z.est)
+		{
+			return est > z.est;
+		}
+		if (dist != z.dist)
+		{
+			return dist < z.dist;
+		}
+		return node > z.node;
+	}
+
+	unsigned est, dist, node;
+};
+
+bool pathClusterRoute(PathClusterGraph const &graph, Vector2i start, Vector2i goal, std::vector<Vector2i> &waypoints)
+{
+	waypoints.clear();
+	if (graph.isBlocked(start.x, start.y) || graph.isBlocked(goal.x, goal.y))
+	{
+		return false;
+	}
+	unsigned startCluster = graph.clusterAt(start);
+	unsigned goalCluster = graph.clusterAt(goal);
+	if (startCluster == goalCluster)
+	{
+		return false;
+	}
+
+	// Find the costs of getting from start to the nodes of its cluster, and from the nodes of the goal's cluster to goal.
+	std::vector<unsigned> startDist, goalDist;
+	int startX0, startY0, startW, startH, goalX0, goalY0, goalW, goalH;
+	clusterBounds(graph, startCluster % graph.clustersX, startCluster / graph.clustersX, startX0, startY0, startW, startH);
+	clusterBounds(graph, goalCluster % graph.clustersX, goalCluster / graph.clustersX, goalX0, goalY0, goalW, goalH);
+	clusterDijkstra(graph, startCluster % graph.clustersX, startCluster / graph.clustersX, start, false, startDist);
+	clusterDijkstra(graph, goalCluster % graph.clustersX, goalCluster / graph.clustersX, goal, true, goalDist);
+
+	unsigned numNodes = graph.nodePos.size();
+	unsigned goalNode = numNodes;
+	std::vector<unsigned> dist(numNodes + 1, UINT_MAX);
+	std::vector<unsigned> prev(numNodes + 1, UINT_MAX);  // UINT_MAX means the node was reached directly from start.
+	std::vector<ClusterOpenNode> open;
+
+	auto relax = [&](unsigned node, unsigned newDist, unsigned from) {
+		if (newDist >= dist[node])
+		{
+			return;  // A different path to this node is at least as short.
+		}
+		dist[node] = newDist;
+		prev[node] = from;
+		ClusterOpenNode openNode;
+		openNode.node = node;
+		openNode.dist = newDist;
+		openNode.est = newDist + (node == goalNode ? 0 : clusterEstimate(graph.nodePos[node], goal));
+		open.push_back(openNode);
+		std::push_heap(open.begin(), open.end());
+	};
+
+	for (unsigned node = graph.firstNode[startCluster]; node < graph.firstNode[startCluster + 1]; ++node)
+	{
+		Vector2i pos = graph.nodePos[node];
+		unsigned d = startDist[(pos.x - startX0) + (pos.y - startY0) * startW];
+		if (d != UINT_MAX)
+		{
+			relax(node, d, UINT_MAX);
+		}
+	}
+
+	while (!open.empty())
+	{
+		ClusterOpenNode best = open.front();
+		std::pop_heap(open.begin(), open.end());
+		open.pop_back();
+		if (best.dist != dist[best.node])
+		{
+			continue;  // Already been here, by a shorter path.
+		}
+
+		if (best.node == goalNode)
+		{
+			// Reached the goal. Keep the nodes where the route enters a new cluster, the tile A* can fill in the rest.
+			for (unsigned node = prev[goalNode]; node != UINT_MAX; node = prev[node])
+			{
+				if (prev[node] != UINT_MAX && graph.nodeCluster[prev[node]] != graph.nodeCluster[node])
+				{
+					waypoints.push_back(graph.nodePos[node]);
+				}
+			}
+			std::reverse(waypoints.begin(), waypoints.end());
+			waypoints.push_back(goal);
+			return true;
+		}
+
+		unsigned c = graph.nodeCluster[best.node];
+		PathCluster const &cluster = graph.clusters[c];
+		size_t numClusterNodes = cluster.nodes.size();
+		size_t a = best.node - graph.firstNode[c];
+
+		// Moves inside the cluster.
+		for (size_t b = 0; b < numClusterNodes; ++b)
+		{
+			unsigned cost = cluster.costs[a * numClusterNodes + b];
+			if (b != a && cost != UINT_MAX)
+			{
+				relax(graph.firstNode[c] + b, best.dist + cost, best.node);
+			}
+		}
+
+		// Moves into neighbouring clusters.
+		for (unsigned i = 0; i < PATH_CLUSTER_MAX_ACROSS; ++i)
+		{
+			int across = graph.nodeAcross[best.node * PATH_CLUSTER_MAX_ACROSS + i];
+			if (across >= 0)
+			{
+				relax(across, best.dist + 140 * graph.costFactor(graph.nodePos[across]), best.node);
+			}
+		}
+
+		// Move to the goal.
+		if (c == goalCluster)
+		{
+			Vector2i pos = graph.nodePos[best.node];
+			unsigned d = goalDist[(pos.x - goalX0) + (pos.y - goalY0) * goalW];
+			if (d != UINT_MAX)
+			{
+				relax(goalNode, best.dist + d, best.node);
+			}
+		}
+	}
+
+	return false;  // No route.
+}
@@ -0,0 +1,66 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Hierarchical (HPA*) path finding layer.
+ *
+ *  The map is divided into square clusters of tiles. Each stretch of passable tiles along the border between two
+ *  clusters gets one or two entrances, and the cost of moving between the entrances of each cluster is precomputed.
+ *  Long routes are first planned on this (much smaller) graph of entrances, and then refined with the tile A*.
+ *
+ *  The graphs are immutable once built, so they can be shared with the path threads. When the blocking tiles change,
+ *  a new graph is made, reusing all clusters which are not affected by the change.
+ */
+
+#ifndef __INCLUDED_SRC_PATHCLUSTER_H__
+#define __INCLUDED_SRC_PATHCLUSTER_H__
+
+#include "lib/framework/vector.h"
+
+#include <memory>
+#include <vector>
+
+/// Width and height of a cluster, in tiles.
+#define PATH_CLUSTER_SIZE 16
+
+/// Bits in the tile array passed to pathClusterUpdate.
+enum
+{
+	PATH_CLUSTER_BLOCKED = 0x01,    ///< Tile can't be entered.
+	PATH_CLUSTER_DANGER  = 0x02,    ///< Tile is dangerous, so entering costs more.
+};
+
+struct PathClusterGraph;
+
+/** Returns a cluster graph for the given tiles.
+ *
+ *  If oldGraph is not null, and has the same size, only the clusters near tiles which differ from oldGraph are
+ *  recalculated. The result does not depend on oldGraph.
+ *
+ *  @param tiles  Tile bits (PATH_CLUSTER_BLOCKED, PATH_CLUSTER_DANGER), in row-major order.
+ */
+std::shared_ptr<PathClusterGraph const> pathClusterUpdate(std::shared_ptr<PathClusterGraph const> const &oldGraph, std::vector<uint8_t> &&tiles, int width, int height);
+
+/** Plans a route from start to goal (in tile coordinates) on the cluster graph.
+ *
+ *  @param waypoints  Set to the tiles to pass through, not including start, ending with goal.
+ *  @return false if start and goal are in the same cluster, or if no route exists.
+ */
+bool pathClusterRoute(PathClusterGraph const &graph, Vector2i start, Vector2i goal, std::vector<Vector2i> &waypoints);
+
+#endif // __INCLUDED_SRC_PATHCLUSTER_H__
@@ -77,9 +77,9 @@ static uint64_t interleave(int32_t x, int32_t y)
 	return expandX(x) | expandY(y);
 }
 
-void PointTree::insert(void *pointData, int32_t x, int32_t y)
+void PointTree::insert(void *pointData, int32_t x, int32_t y, uint32_t order)
 {
-	points.push_back(Point(interleave(x, y), pointData));
+	points.push_back(Point{interleave(x, y), order, pointData});
 }
 
 void PointTree::clear()
@@ -87,14 +87,35 @@ void PointTree::clear()
 	points.clear();
 }
 
-static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pair<uint64_t, void *> const &b)
+template<typename P>
+static bool pointTreeSearchFunction(P const &a, P const &b)
 {
-	return a.first < b.first;  // Sort only by position, not by pointer address, even if two units are in the same place.
+	return a.key < b.key;
+}
+
+template<typename P>
+static bool pointTreeSortFunction(P const &a, P const &b)
+{
+	// Sort only by position and order, not by pointer address, even if two units are in the same place.
+	return a.key < b.key || (a.key == b.key && a.order < b.order);
 }
 
 void PointTree::sort()
 {
-	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction<Point>);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+}
+
+void PointTree::merge(PointTree const &a, PointTree const &b)
+{
+	points.resize(a.points.size() + b.points.size());
+	std::merge(a.points.begin(), a.points.end(), b.points.begin(), b.points.end(), points.begin(), pointTreeSortFunction<Point>);  // Stable, takes from a first if equal.
+}
+
+bool PointTree::operator ==(PointTree const &b) const
+{
+	return points.size() == b.points.size() && std::equal(points.begin(), points.end(), b.points.begin(), [](Point const &p, Point const &q) {
+		return p.key == q.key && p.order == q.order && p.data == q.data;
+	});
 }
 
 //#define DUMP_IMAGE  // All x and y coordinates must be in range -500 to 499, if dumping an image.
@@ -129,7 +150,7 @@ static unsigned current(std::vector<unsigned> &filterData, unsigned i)
 }
 
 template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+void PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo, ResultVector &results, IndexVector &filteredIndices) const
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -225,34 +246,34 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
+	results.clear();
 	if (IsFiltered)
 	{
-		lastFilteredQueryIndices.clear();
+		filteredIndices.clear();
 	}
 	for (int r = 0; r != numRanges; ++r)
 	{
 		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers are ignored when searching.
-		unsigned i1 = std::lower_bound(points.begin(),      points.end(), Point(ranges[r].a, (void *)nullptr), pointTreeSortFunction) - points.begin();
-		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), Point(ranges[r].z, (void *)nullptr), pointTreeSortFunction) - points.begin();
+		unsigned i1 = std::lower_bound(points.begin(),      points.end(), Point{ranges[r].a, 0, nullptr}, pointTreeSearchFunction<Point>) - points.begin();
+		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), Point{ranges[r].z, 0, nullptr}, pointTreeSearchFunction<Point>) - points.begin();
 
 		for (unsigned i = current<IsFiltered>(filter.data, i1); i < i2; i = current<IsFiltered>(filter.data, i + 1))
 		{
-			uint64_t px = points[i].first & 0xAAAAAAAAAAAAAAAAULL;
-			uint64_t py = points[i].first & 0x5555555555555555ULL;
+			uint64_t px = points[i].key & 0xAAAAAAAAAAAAAAAAULL;
+			uint64_t py = points[i].key & 0x5555555555555555ULL;
 			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
 			{
-				lastQueryResults.push_back(points[i].second);
+				results.push_back(points[i].data);
 				if (IsFiltered)
 				{
-					lastFilteredQueryIndices.push_back(i);
+					filteredIndices.push_back(i);
 				}
 #ifdef DUMP_IMAGE
 				if (doDump)
 				{
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][0] = 192;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][1] = 128;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][2] = 0;
+					ppm[((int32_t *)points[i].data)[1] + 500][((int32_t *)points[i].data)[0] + 500][0] = 192;
+					ppm[((int32_t *)points[i].data)[1] + 500][((int32_t *)points[i].data)[0] + 500][1] = 128;
+					ppm[((int32_t *)points[i].data)[1] + 500][((int32_t *)points[i].data)[0] + 500][2] = 0;
 				}
 #endif //DUMP_IMAGE
 			}
@@ -266,24 +287,30 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		fclose(f);
 	}
 #endif //DUMP_IMAGE
-
-	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
 	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
+	queryMaybeFilter<false>(unused, x, y, x2, y2, lastQueryResults, lastFilteredQueryIndices);
+	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
+{
+	query(x, y, radius, lastQueryResults);
+	return lastQueryResults;
+}
+
+void PointTree::query(int32_t x, int32_t y, uint32_t radius, ResultVector &results) const
 {
 	Filter unused;
+	IndexVector unusedIndices;
 	int32_t minXo = x - radius;
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo, results, unusedIndices);
 }
 
 PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
@@ -292,5 +319,6 @@ PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y,
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo, lastQueryResults, lastFilteredQueryIndices);
+	return lastQueryResults;
 }
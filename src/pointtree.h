@@ -37,10 +37,26 @@ public:
 		Filter(PointTree const &pointTree) : data(pointTree.points.size() + 1) {}
 		void reset(PointTree const &pointTree)
 		{
-			data.assign(pointTree.points.size() + 1, 0);
+			if (data.size() != pointTree.points.size() + 1)
+			{
+				data.assign(pointTree.points.size() + 1, 0);
+			}
+			else
+			{
+				// Only erased points can be non-zero, so don't bother clearing everything.
+				for (unsigned index : erased)
+				{
+					data[index] = 0;
+				}
+			}
+			erased.clear();
 		}
 		void erase(unsigned index)
 		{
+			if (data[index] == 0)
+			{
+				erased.push_back(index);
+			}
 			data[index] = std::max(data[index], 1u);    ///< Erases the point from query results using the filter.
 		}
 
@@ -50,15 +66,22 @@ public:
 		typedef std::vector<unsigned> Data;
 
 		Data data;
+		std::vector<unsigned> erased;  ///< Indices which were erased since the last reset.
 	};
 
-	void insert(void *pointData, int32_t x, int32_t y);                       ///< Inserts a point into the point tree.
+	/// Inserts a point into the point tree. Points in exactly the same place are sorted by order, then by insertion order.
+	void insert(void *pointData, int32_t x, int32_t y, uint32_t order = 0);
 	void clear();                                                             ///< Clears the PointTree.
 	void sort();                                                              ///< Must be done between inserting and querying, to get meaningful results.
+	/// Sets this PointTree to all the points of a and b, which must be sorted. Faster than inserting them all and sorting.
+	void merge(PointTree const &a, PointTree const &b);
+	bool operator ==(PointTree const &b) const;
 	/// Returns all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
 	/// (More specifically, returns all objects in a square with edge length 2*radius.)
 	/// Note: Not thread safe, because it modifies lastQueryResults.
 	ResultVector &query(int32_t x, int32_t y, uint32_t radius);
+	/// Same as above, but stores the points in results instead of lastQueryResults, so is thread safe (as long as nothing modifies the PointTree).
+	void query(int32_t x, int32_t y, uint32_t radius, ResultVector &results) const;
 	/// Returns all points which have not been filtered away, less than or equal to radius from (x, y), possibly plus some extra nearby points.
 	/// (More specifically, returns objects in a square with edge length 2*radius.)
 	/// Note: Not thread safe, because it modifies lastQueryResults, lastFilteredQueryIndices and the internal filter representation for faster lookups.
@@ -70,11 +93,16 @@ public:
 	IndexVector lastFilteredQueryIndices;
 
 private:
-	typedef std::pair<uint64_t, void *> Point;
+	struct Point
+	{
+		uint64_t key;   ///< Morton number of the position.
+		uint32_t order;
+		void *data;
+	};
 	typedef std::vector<Point> Vector;
 
 	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	void queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo, ResultVector &results, IndexVector &filteredIndices) const;
 
 	Vector points;
 };
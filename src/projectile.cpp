@@ -29,6 +29,7 @@
 #include "lib/framework/trig.h"
 #include "lib/framework/fixedpoint.h"
 #include "lib/framework/math_ext.h"
+#include "lib/framework/wzprofile.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio_id.h"
 #include "lib/sound/audio.h"
@@ -57,9 +58,12 @@
 #include "mapgrid.h"
 #include "random.h"
 #include "display3d.h"
+#include "benchmark.h"
 
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <type_traits>
 #ifndef GLM_ENABLE_EXPERIMENTAL
 	#define GLM_ENABLE_EXPERIMENTAL
 #endif
@@ -102,6 +106,271 @@ static std::vector<PROJECTILE*> psProjectileList;
 /* The next projectile to give out in the proj_First / proj_Next methods */
 static ProjectileIterator psProjectileNext;
 
+#define PROJ_POOL_CHUNK_SIZE 256
+
+/// Position of a projectile in direct or indirect flight, which only depends on its launch parameters and age. Sets pos
+/// (and pitch, if indirect), and returns the distance travelled. Used by both proj_InFlightFunc() and
+/// ProjectilePool::updateFlights(), so that they give identical results.
+static inline int32_t projFlightPosition(WEAPON_STATS const *psStats, Vector3i src, Vector3i dst, int32_t vXY, int32_t vZ, int timeSoFar, Vector3i &pos, uint16_t &pitch)
+{
+	int32_t currentDistance;
+	if (psStats->movementModel == MM_DIRECT)  // Go in a straight line.
+	{
+		Vector3i delta = dst - src;
+		if (psStats->weaponSubClass == WSC_LAS_SAT)
+		{
+			// LASSAT doesn't have a z
+			delta.z = 0;
+		}
+		int targetDistance = std::max(iHypot(delta.xy()), 1);
+		currentDistance = timeSoFar * psStats->flightSpeed / GAME_TICKS_PER_SEC;
+		pos = src + delta * currentDistance / targetDistance;
+	}
+	else  // MM_INDIRECT, ballistic trajectory.
+	{
+		Vector3i delta = dst - src;
+		delta.z = (vZ - (timeSoFar * ACC_GRAVITY / (GAME_TICKS_PER_SEC * 2))) * timeSoFar / GAME_TICKS_PER_SEC; // '2' because we reach our highest point in the mid of flight, when "vZ is 0".
+		int targetDistance = std::max(iHypot(delta.xy()), 1);
+		currentDistance = timeSoFar * vXY / GAME_TICKS_PER_SEC;
+		pos = src + delta * currentDistance / targetDistance;
+		pos.z = src.z + delta.z;  // Use raw z value.
+		pitch = iAtan2(vZ - (timeSoFar * ACC_GRAVITY / GAME_TICKS_PER_SEC), vXY);
+	}
+	return currentDistance;
+}
+
+/// Radius of a grid query from the centre of a tile, which finds everything within PROJ_NEIGHBOUR_RANGE of any point in it.
+#define PROJ_TILE_NEIGHBOUR_RANGE (PROJ_NEIGHBOUR_RANGE + TILE_UNITS * 3 / 4)
+
+static inline bool projIsInRadius(Vector2i delta, uint32_t radius)
+{
+	// cast to int64 to avoid integer overflow, same as the grid does.
+	return (int64_t)delta.x * delta.x + (int64_t)delta.y * delta.y <= (int64_t)radius * radius;
+}
+
+/// Storage for projectiles. Projectiles are allocated in chunks, so they stay close together in memory and don't cost
+/// a heap allocation each. Freed slots are reused, and projectiles never move, since they are referenced by pointer.
+///
+/// The launch parameters of projectiles in direct or indirect flight are also kept here, in arrays indexed by slot, so
+/// that updateFlights() can calculate all their positions for the tick in one pass, instead of each projectile doing it
+/// in proj_InFlightFunc() in between collision checks. Homing projectiles change course in flight, so aren't batched.
+///
+/// findCandidates() is the broad phase of the collision checks for the batched projectiles. It buckets them by the tile
+/// their flight ends in this tick, does one grid query per tile, and narrows that down to the objects near each
+/// projectile. The grid doesn't change until the next gridReset(), and grid query results are always in grid order, so
+/// each projectile gets exactly the objects, in the same order, that gridStartIterate(pos, PROJ_NEIGHBOUR_RANGE) would
+/// give it. The narrow phase stays in proj_InFlightFunc(), in update order, since earlier hits affect later ones.
+class ProjectilePool
+{
+public:
+	PROJECTILE *allocate(uint32_t id, unsigned player)
+	{
+		if (freeSlots.empty())
+		{
+			chunks.emplace_back(new Chunk);
+			uint32_t firstSlot = static_cast<uint32_t>(chunks.size() - 1) * PROJ_POOL_CHUNK_SIZE;
+			for (uint32_t slot = firstSlot + PROJ_POOL_CHUNK_SIZE; slot-- > firstSlot;)
+			{
+				freeSlots.push_back(slot);  // Reversed, so that the lowest slot is used first.
+			}
+			size_t numSlots = chunks.size() * PROJ_POOL_CHUNK_SIZE;
+			flightStats.resize(numSlots, nullptr);
+			flightSrc.resize(numSlots);
+			flightDst.resize(numSlots);
+			flightVXY.resize(numSlots);
+			flightVZ.resize(numSlots);
+			flightBorn.resize(numSlots);
+			flightTime.resize(numSlots);
+			flightPos.resize(numSlots);
+			flightPitch.resize(numSlots);
+			flightDistance.resize(numSlots);
+			candidateBegin.resize(numSlots);
+			candidateEnd.resize(numSlots);
+			candidateTime.resize(numSlots);
+		}
+		uint32_t slot = freeSlots.back();
+		freeSlots.pop_back();
+		PROJECTILE *psProj = new (&chunks[slot / PROJ_POOL_CHUNK_SIZE]->slots[slot % PROJ_POOL_CHUNK_SIZE]) PROJECTILE(id, player);
+		psProj->poolSlot = slot;
+		endFlight(slot);
+		return psProj;
+	}
+
+	void release(PROJECTILE *psProj)
+	{
+		uint32_t slot = psProj->poolSlot;
+		endFlight(slot);
+		psProj->~PROJECTILE();
+		freeSlots.push_back(slot);
+	}
+
+	/// Frees all chunks. All projectiles must have been released.
+	void clear()
+	{
+		ASSERT(freeSlots.size() == chunks.size() * PROJ_POOL_CHUNK_SIZE, "%zu projectiles not released", chunks.size() * PROJ_POOL_CHUNK_SIZE - freeSlots.size());
+		chunks.clear();
+		freeSlots.clear();
+		flightStats.clear();
+		flightSrc.clear();
+		flightDst.clear();
+		flightVXY.clear();
+		flightVZ.clear();
+		flightBorn.clear();
+		flightTime.clear();
+		flightPos.clear();
+		flightPitch.clear();
+		flightDistance.clear();
+		candidateBegin.clear();
+		candidateEnd.clear();
+		candidateTime.clear();
+		tileSlots.clear();
+		candidates.clear();
+	}
+
+	/// Records the launch parameters of a projectile which has just been fired, if its flight can be batched.
+	void startFlight(PROJECTILE const *psProj)
+	{
+		uint32_t slot = psProj->poolSlot;
+		WEAPON_STATS const *psStats = psProj->psWStats;
+		if (psStats->movementModel != MM_DIRECT && psStats->movementModel != MM_INDIRECT)
+		{
+			endFlight(slot);
+			return;
+		}
+		flightStats[slot] = psStats;
+		flightSrc[slot] = psProj->src;
+		flightDst[slot] = psProj->dst;
+		flightVXY[slot] = psStats->movementModel == MM_INDIRECT ? psProj->vXY : 0;
+		flightVZ[slot] = psStats->movementModel == MM_INDIRECT ? psProj->vZ : 0;
+		flightBorn[slot] = psProj->born;
+		flightTime[slot] = gameTime - 1;  // Not calculated for this tick yet.
+		candidateTime[slot] = gameTime - 1;
+	}
+
+	void endFlight(uint32_t slot)
+	{
+		flightStats[slot] = nullptr;
+	}
+
+	/// Calculates the positions of all batched projectiles at the current game time.
+	void updateFlights()
+	{
+		for (size_t slot = 0; slot < flightStats.size(); ++slot)
+		{
+			WEAPON_STATS const *psStats = flightStats[slot];
+			if (psStats == nullptr)
+			{
+				continue;
+			}
+			int timeSoFar = gameTime - flightBorn[slot];
+			flightDistance[slot] = projFlightPosition(psStats, flightSrc[slot], flightDst[slot], flightVXY[slot], flightVZ[slot], timeSoFar, flightPos[slot], flightPitch[slot]);
+			flightTime[slot] = gameTime;
+		}
+	}
+
+	/// Finds the objects that each batched projectile might collide with this tick. Must be called after updateFlights().
+	void findCandidates()
+	{
+		tileSlots.clear();
+		candidates.clear();
+		for (uint32_t slot = 0; slot < flightStats.size(); ++slot)
+		{
+			if (flightStats[slot] != nullptr && flightTime[slot] == gameTime)
+			{
+				Vector2i tile = map_coord(flightPos[slot].xy());
+				tileSlots.emplace_back((uint64_t)(uint32_t)tile.y << 32 | (uint32_t)tile.x, slot);
+			}
+		}
+		std::sort(tileSlots.begin(), tileSlots.end());
+
+		size_t numQueries = 0;
+		for (size_t i = 0; i < tileSlots.size();)
+		{
+			Vector2i tileCentre = world_coord(map_coord(flightPos[tileSlots[i].second].xy())) + Vector2i(TILE_UNITS / 2, TILE_UNITS / 2);
+			GridList const &tileList = gridStartIterate(tileCentre.x, tileCentre.y, PROJ_TILE_NEIGHBOUR_RANGE);
+			++numQueries;
+			size_t end = i;
+			for (; end < tileSlots.size() && tileSlots[end].first == tileSlots[i].first; ++end)
+			{
+				uint32_t slot = tileSlots[end].second;
+				Vector2i pos = flightPos[slot].xy();
+				candidateBegin[slot] = candidates.size();
+				for (BASE_OBJECT *psObj : tileList)
+				{
+					if (projIsInRadius(psObj->pos.xy() - pos, PROJ_NEIGHBOUR_RANGE))
+					{
+						candidates.push_back(psObj);
+					}
+				}
+				candidateEnd[slot] = candidates.size();
+				candidateTime[slot] = gameTime;
+			}
+			i = end;
+		}
+		benchmarkCount(BENCHMARK_PROJECTILE_GRID_QUERIES, numQueries);
+	}
+
+	/// Gets the objects found by findCandidates() for this tick, if the projectile is where they were found for.
+	bool getCandidates(PROJECTILE const *psProj, BASE_OBJECT *const *&begin, BASE_OBJECT *const *&end) const
+	{
+		uint32_t slot = psProj->poolSlot;
+		if (flightStats[slot] == nullptr || candidateTime[slot] != gameTime || flightPos[slot] != psProj->pos)
+		{
+			return false;
+		}
+		begin = candidates.data() + candidateBegin[slot];
+		end = candidates.data() + candidateEnd[slot];
+		return true;
+	}
+
+	/// Gets the position calculated by updateFlights() for this tick, if any.
+	bool getFlight(PROJECTILE *psProj, int32_t &currentDistance) const
+	{
+		uint32_t slot = psProj->poolSlot;
+		if (flightStats[slot] == nullptr || flightTime[slot] != gameTime)
+		{
+			return false;
+		}
+		psProj->pos = flightPos[slot];
+		if (flightStats[slot]->movementModel == MM_INDIRECT)
+		{
+			psProj->rot.pitch = flightPitch[slot];
+		}
+		currentDistance = flightDistance[slot];
+		return true;
+	}
+
+private:
+	struct Chunk
+	{
+		std::aligned_storage<sizeof(PROJECTILE), alignof(PROJECTILE)>::type slots[PROJ_POOL_CHUNK_SIZE];
+	};
+
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	std::vector<uint32_t> freeSlots;
+
+	// Batched flights, indexed by slot. flightStats is nullptr if the slot isn't batched.
+	std::vector<WEAPON_STATS const *> flightStats;
+	std::vector<Vector3i> flightSrc;
+	std::vector<Vector3i> flightDst;
+	std::vector<int32_t> flightVXY;
+	std::vector<int32_t> flightVZ;
+	std::vector<uint32_t> flightBorn;
+	std::vector<uint32_t> flightTime;  ///< Game time that flightPos, flightPitch and flightDistance were calculated for.
+	std::vector<Vector3i> flightPos;
+	std::vector<uint16_t> flightPitch;
+	std::vector<int32_t> flightDistance;
+
+	// Collision candidates, indexed by slot. Only valid if candidateTime is the current game time.
+	std::vector<uint32_t> candidateBegin;
+	std::vector<uint32_t> candidateEnd;
+	std::vector<uint32_t> candidateTime;
+	std::vector<std::pair<uint64_t, uint32_t>> tileSlots;  ///< Batched projectiles, as (tile, slot), sorted by tile.
+	std::vector<BASE_OBJECT *> candidates;
+};
+
+static ProjectilePool projectilePool;
+
 /***************************************************************************/
 
 // the last unit that did damage - used by script functions
@@ -213,10 +482,11 @@ proj_FreeAllProjectiles()
 {
 	for (auto proj: psProjectileList)
 	{
-		delete proj;
+		projectilePool.release(proj);
 	}
 	psProjectileList.clear();
 	psProjectileNext = psProjectileList.end();
+	projectilePool.clear();
 }
 
 /***************************************************************************/
@@ -424,7 +694,7 @@ bool proj_SendProjectileAngled(WEAPON *psWeap, SIMPLE_OBJECT *psAttacker, int pl
 	ASSERT_OR_RETURN(false, psStats != nullptr, "Invalid weapon stats");
 	ASSERT_OR_RETURN(false, psTarget == nullptr || !psTarget->died, "Aiming at dead target!");
 
-	PROJECTILE *psProj = new PROJECTILE(ProjectileTrackerID + ++projectileTrackerIDIncrement, player);
+	PROJECTILE *psProj = projectilePool.allocate(ProjectileTrackerID + ++projectileTrackerIDIncrement, player);
 
 	/* get muzzle offset */
 	if (psAttacker == nullptr)
@@ -544,6 +814,7 @@ bool proj_SendProjectileAngled(WEAPON *psWeap, SIMPLE_OBJECT *psAttacker, int pl
 
 	/* put the projectile object in the global list */
 	psProjectileList.push_back(psProj);
+	projectilePool.startFlight(psProj);
 
 	/* play firing audio */
 	// only play if either object is visible, i know it's a bit of a hack, but it avoids the problem
@@ -714,29 +985,21 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 	switch (psStats->movementModel)
 	{
 	case MM_DIRECT:           // Go in a straight line.
+	case MM_INDIRECT:         // Ballistic trajectory.
+		if (!projectilePool.getFlight(psProj, currentDistance))
 		{
-			Vector3i delta = psProj->dst - psProj->src;
-			if (psStats->weaponSubClass == WSC_LAS_SAT)
-			{
-				// LASSAT doesn't have a z
-				delta.z = 0;
-			}
-			int targetDistance = std::max(iHypot(delta.xy()), 1);
-			currentDistance = timeSoFar * psStats->flightSpeed / GAME_TICKS_PER_SEC;
-			psProj->pos = psProj->src + delta * currentDistance / targetDistance;
-			break;
+			currentDistance = projFlightPosition(psStats, psProj->src, psProj->dst, psProj->vXY, psProj->vZ, timeSoFar, psProj->pos, psProj->rot.pitch);
 		}
-	case MM_INDIRECT:         // Ballistic trajectory.
+#ifdef DEBUG
+		else
 		{
-			Vector3i delta = psProj->dst - psProj->src;
-			delta.z = (psProj->vZ - (timeSoFar * ACC_GRAVITY / (GAME_TICKS_PER_SEC * 2))) * timeSoFar / GAME_TICKS_PER_SEC; // '2' because we reach our highest point in the mid of flight, when "vZ is 0".
-			int targetDistance = std::max(iHypot(delta.xy()), 1);
-			currentDistance = timeSoFar * psProj->vXY / GAME_TICKS_PER_SEC;
-			psProj->pos = psProj->src + delta * currentDistance / targetDistance;
-			psProj->pos.z = psProj->src.z + delta.z;  // Use raw z value.
-			psProj->rot.pitch = iAtan2(psProj->vZ - (timeSoFar * ACC_GRAVITY / GAME_TICKS_PER_SEC), psProj->vXY);
-			break;
+			Vector3i checkPos = psProj->pos;
+			uint16_t checkPitch = psProj->rot.pitch;
+			int32_t checkDistance = projFlightPosition(psStats, psProj->src, psProj->dst, psProj->vXY, psProj->vZ, timeSoFar, checkPos, checkPitch);
+			ASSERT(checkPos == psProj->pos && checkPitch == psProj->rot.pitch && checkDistance == currentDistance, "Batched projectile flight out of sync");
 		}
+#endif
+		break;
 	case MM_HOMINGDIRECT:     // Fly towards target, even if target moves.
 	case MM_HOMINGINDIRECT:   // Fly towards target, even if target moves. Avoid terrain.
 		{
@@ -806,8 +1069,24 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 
 	/* Check nearby objects for possible collisions */
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	BASE_OBJECT *const *candidatesBegin, *const *candidatesEnd;
+	if (!projectilePool.getCandidates(psProj, candidatesBegin, candidatesEnd))
+	{
+		gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
+		candidatesBegin = gridList.data();
+		candidatesEnd = gridList.data() + gridList.size();
+		benchmarkCount(BENCHMARK_PROJECTILE_GRID_QUERIES, 1);
+	}
+#ifdef DEBUG
+	else
+	{
+		GridList const &check = gridStartIterate(psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
+		ASSERT(std::equal(check.begin(), check.end(), candidatesBegin) && check.size() == size_t(candidatesEnd - candidatesBegin), "Projectile collision candidates out of sync");
+	}
+#endif
+	benchmarkCount(BENCHMARK_PROJECTILES_IN_FLIGHT, 1);
+	benchmarkCount(BENCHMARK_PROJECTILE_CANDIDATES, candidatesEnd - candidatesBegin);
+	for (BASE_OBJECT *const *gi = candidatesBegin; gi != candidatesEnd; ++gi)
 	{
 		BASE_OBJECT *psTempObj = *gi;
 		CHECK_OBJECT(psTempObj);
@@ -1356,18 +1635,40 @@ void PROJECTILE::update()
 		break;
 	}
 
+	if (psObj->state != PROJ_INFLIGHT)
+	{
+		projectilePool.endFlight(psObj->poolSlot);
+	}
+
 	syncDebugProjectile(psObj, '>');
 }
 
+bool PROJECTILE::deleteIfDead()
+{
+	if (died == 0 || died >= gameTime - deltaGameTime)
+	{
+		return false;
+	}
+	projectilePool.release(this);
+	return true;
+}
+
 /***************************************************************************/
 
 // iterate through all projectiles and update their status
 void proj_UpdateAll()
 {
-	std::vector<PROJECTILE *> psProjectileListOld = psProjectileList;
+	WZ_PROFILE_ZONE("proj_UpdateAll");
 
-	// Update all projectiles. Penetrating projectiles may add to psProjectileList.
-	std::for_each(psProjectileListOld.begin(), psProjectileListOld.end(), std::mem_fn(&PROJECTILE::update));
+	projectilePool.updateFlights();
+	projectilePool.findCandidates();
+
+	// Update all projectiles. Penetrating projectiles may add to psProjectileList, but aren't updated until the next tick.
+	size_t numProjectiles = psProjectileList.size();
+	for (size_t i = 0; i < numProjectiles; ++i)
+	{
+		psProjectileList[i]->update();
+	}
 
 	// Remove and free dead projectiles.
 	psProjectileList.erase(std::remove_if(psProjectileList.begin(), psProjectileList.end(), std::mem_fn(&PROJECTILE::deleteIfDead)), psProjectileList.end());
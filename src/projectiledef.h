@@ -43,15 +43,7 @@ struct PROJECTILE : public SIMPLE_OBJECT
 	PROJECTILE(uint32_t id, unsigned player) : SIMPLE_OBJECT(OBJ_PROJECTILE, id, player) {}
 
 	void            update();
-	bool            deleteIfDead()
-	{
-		if (died == 0 || died >= gameTime - deltaGameTime)
-		{
-			return false;
-		}
-		delete this;
-		return true;
-	}
+	bool            deleteIfDead();  ///< Returns the projectile to the pool if it died before this tick.
 
 	UBYTE           state;                  ///< current projectile state
 	UBYTE           bVisible;               ///< whether the selected player should see the projectile
@@ -66,6 +58,7 @@ struct PROJECTILE : public SIMPLE_OBJECT
 	Spacetime       prevSpacetime;          ///< Location of projectile in previous tick.
 	UDWORD          expectedDamageCaused;   ///< Expected damage that this projectile will cause to the target.
 	int             partVisible;            ///< how much of target was visible on shooting (important for homing)
+	uint32_t        poolSlot;               ///< index of the projectile in the projectile pool
 };
 
 typedef std::vector<PROJECTILE *>::const_iterator ProjectileIterator;
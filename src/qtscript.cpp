@@ -46,6 +46,7 @@
 #include "qtscript.h"
 
 #include "lib/framework/file.h"
+#include "lib/framework/wzprofile.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
 #include "multiplay.h"
@@ -55,6 +56,7 @@
 #include "console.h"
 #include "clparse.h"
 #include "mission.h"
+#include "objmem.h"
 #include "modding.h"
 #include "version.h"
 #include "game.h"
@@ -184,6 +186,8 @@ void scripting_engine::timerNode::swap(timerNode& _rhs)
 	std::swap(player, _rhs.player);
 	std::swap(calls, _rhs.calls);
 	std::swap(type, _rhs.type);
+	std::swap(seq, _rhs.seq);
+	std::swap(runTime, _rhs.runTime);
 }
 
 scripting_engine::area_by_values_or_area_label_lookup::area_by_values_or_area_label_lookup() { }
@@ -219,6 +223,17 @@ uniqueTimerID scripting_engine::setTimer(wzapi::scripting_instance *caller, cons
 	}
 	node->type = type;
 	node->timerID = newTimerID;
+	// Spread the first call of repeating AI timers over their interval, so that timers set up together (typically all
+	// AIs at the start of the game) don't all run in the same tick. Only done for AIs running on the host, since no
+	// other peer runs them, so it doesn't matter that their timers run differently depending on the setting.
+	if (war_getScriptTimerSpread() && type == TIMER_REPEAT && milliseconds >= 2 * GAME_TICKS_PER_UPDATE
+		&& caller != nullptr && caller->player() >= 0 && caller->player() < MAX_PLAYERS && caller->isHostAI())
+	{
+		int slots = milliseconds / GAME_TICKS_PER_UPDATE;
+		node->frameTime += (timerSpreadCount++ % slots) * GAME_TICKS_PER_UPDATE;
+	}
+	node->seq = ++lastTimerSeq;
+	pushTimerHeap(node);
 	auto inserted_iter = timers.emplace(timers.end(), std::move(node));
 	timerIDMap[newTimerID] = inserted_iter;
 	return newTimerID;
@@ -228,10 +243,43 @@ uniqueTimerID scripting_engine::setTimer(wzapi::scripting_instance *caller, cons
 void scripting_engine::addTimerNode(std::shared_ptr<scripting_engine::timerNode>&& node)
 {
 	ASSERT(timerIDMap.count(node->timerID) == 0, "Duplicate timerID found: %s", WzString::number(node->timerID).toUtf8().c_str());
+	node->seq = ++lastTimerSeq;
+	if (node->type == TIMER_ONESHOT_DONE)
+	{
+		doneOneshotTimers.push_back(node->timerID);
+	}
+	else
+	{
+		pushTimerHeap(node);
+	}
 	auto inserted_iter = timers.emplace(timers.end(), std::move(node));
 	timerIDMap[(*inserted_iter)->timerID] = inserted_iter;
 }
 
+bool scripting_engine::timerHeapLater(const timerHeapEntry &a, const timerHeapEntry &b)
+{
+	return a.frameTime != b.frameTime ? a.frameTime > b.frameTime : a.seq > b.seq;
+}
+
+void scripting_engine::pushTimerHeap(const std::shared_ptr<timerNode>& node)
+{
+	timerHeap.push_back(timerHeapEntry{node->frameTime, node->seq, node});
+	std::push_heap(timerHeap.begin(), timerHeap.end(), timerHeapLater);
+}
+
+void scripting_engine::rebuildTimerHeap()
+{
+	timerHeap.clear();
+	for (const auto &node : timers)
+	{
+		if (node->type == TIMER_REPEAT || node->type == TIMER_ONESHOT_READY)
+		{
+			timerHeap.push_back(timerHeapEntry{node->frameTime, node->seq, node});
+		}
+	}
+	std::make_heap(timerHeap.begin(), timerHeap.end(), timerHeapLater);
+}
+
 /// Scripting engine (what others call the scripting context, but QtScript's nomenclature is different).
 static std::vector<wzapi::scripting_instance *> scripts;
 
@@ -416,6 +464,24 @@ bool scripting_engine::shutdownScripts()
 			info << function << "\n";
 			instance->dumpScriptLog(info.str());
 		}
+		const auto &stats = instance->performanceStats();
+		std::map<std::string, wzapi::scripting_instance::PerformanceStats::ApiCallStats> apiCalls(stats.apiCalls.begin(), stats.apiCalls.end());
+		if (!apiCalls.empty())
+		{
+			instance->dumpScriptLog("    calls | total (usec) | api function\n");
+		}
+		for (const auto &it : apiCalls)
+		{
+			std::ostringstream info;
+			info << std::right << std::setw(9) << it.second.calls << " | ";
+			info << std::right << std::setw(12) << std::chrono::duration_cast<std::chrono::microseconds>(it.second.time).count() << " | ";
+			info << it.first << "\n";
+			instance->dumpScriptLog(info.str());
+		}
+		std::ostringstream info;
+		info << "worst tick " << std::chrono::duration_cast<std::chrono::microseconds>(stats.worstTick).count() << " usec at " << stats.worstTickGameTime;
+		info << ", " << stats.ticksOverBudget << " ticks over budget, " << stats.interruptedCalls << " calls interrupted\n";
+		instance->dumpScriptLog(info.str());
 		monitor->clear();
 		delete monitor;
 		unregisterFunctions(instance);
@@ -423,6 +489,10 @@ bool scripting_engine::shutdownScripts()
 	timers.clear();
 	lastTimerID = 0;
 	timerIDMap.clear();
+	timerHeap.clear();
+	lastTimerSeq = 0;
+	doneOneshotTimers.clear();
+	timerSpreadCount = 0;
 	monitors.clear();
 	for (auto& script : scripts)
 	{
@@ -434,6 +504,8 @@ bool scripting_engine::shutdownScripts()
 
 bool updateScripts()
 {
+	WZ_PROFILE_ZONE("updateScripts");
+
 	return scripting_engine::instance().updateScripts();
 }
 
@@ -454,25 +526,72 @@ bool scripting_engine::updateScripts()
 	{
 		instance->updateGameTime(gameTime);
 	}
+	// Check how long each script took since the last tick
+	const std::chrono::steady_clock::duration budget = std::chrono::milliseconds(war_getScriptTickBudget());
+	for (auto *instance : scripts)
+	{
+		auto &stats = instance->performanceStats();
+		if (stats.thisTick > stats.worstTick)
+		{
+			stats.worstTick = stats.thisTick;
+			stats.worstTickGameTime = gameTime;
+		}
+		if (budget > std::chrono::steady_clock::duration::zero() && stats.thisTick > budget)
+		{
+			++stats.ticksOverBudget;
+			if ((stats.ticksOverBudget & (stats.ticksOverBudget - 1)) == 0) // Only the 1st, 2nd, 4th, 8th, ... time, to not spam the log.
+			{
+				debug(LOG_WARNING, "Script %s (player %d) took %.1f ms before game time %u, over its budget of %d ms (%u times so far)",
+				      instance->scriptName().c_str(), instance->player(), std::chrono::duration<double, std::milli>(stats.thisTick).count(),
+				      gameTime, war_getScriptTickBudget(), stats.ticksOverBudget);
+			}
+		}
+		++stats.ticks;
+		stats.thisTick = std::chrono::steady_clock::duration::zero();
+	}
 	// Weed out dead timers
-	removeTimersIf([](const timerNode& node)
+	for (uniqueTimerID timerID : doneOneshotTimers)
 	{
-		return (node.type == TIMER_ONESHOT_DONE);
-	});
+		auto it = timerIDMap.find(timerID);
+		if (it != timerIDMap.end() && (*it->second)->type == TIMER_ONESHOT_DONE)
+		{
+			removeTimer(timerID);
+		}
+	}
+	doneOneshotTimers.clear();
+	// Entries of removed timers stay in the heap until they are due, so rebuild it if there are too many of them.
+	if (timerHeap.size() > 2 * timers.size() + 64)
+	{
+		rebuildTimerHeap();
+	}
 	// Check for timers, and run them if applicable.
-	// TODO - load balancing
 	std::vector<std::shared_ptr<timerNode>> runlist; // make a new list here, since we might trample all over the timer list during execution
-	for (auto &node : timers)
+	while (!timerHeap.empty() && timerHeap.front().frameTime <= gameTime)
 	{
-		if (node->frameTime <= gameTime)
+		std::pop_heap(timerHeap.begin(), timerHeap.end(), timerHeapLater);
+		timerHeapEntry entry = std::move(timerHeap.back());
+		timerHeap.pop_back();
+		std::shared_ptr<timerNode> node = entry.node.lock();
+		if (node == nullptr || node->frameTime != entry.frameTime || (node->type != TIMER_REPEAT && node->type != TIMER_ONESHOT_READY))
 		{
-			node->frameTime = node->ms + gameTime;	// update for next invokation
-			if (node->type == TIMER_ONESHOT_READY)
-			{
-				node->type = TIMER_ONESHOT_DONE; // unless there is none
-			}
-			node->calls++;
-			runlist.push_back(node);
+			continue; // stale entry
+		}
+		node->frameTime = node->ms + gameTime;	// update for next invokation
+		if (node->type == TIMER_ONESHOT_READY)
+		{
+			node->type = TIMER_ONESHOT_DONE; // unless there is none
+			doneOneshotTimers.push_back(node->timerID);
+		}
+		node->calls++;
+		runlist.push_back(std::move(node));
+	}
+	// Run timers in the order they were added, regardless of when they were due.
+	std::sort(runlist.begin(), runlist.end(), [](const std::shared_ptr<timerNode> &a, const std::shared_ptr<timerNode> &b) { return a->seq < b->seq; });
+	for (const auto &node : runlist)
+	{
+		if (node->type == TIMER_REPEAT)
+		{
+			pushTimerHeap(node);
 		}
 	}
 
@@ -484,7 +603,14 @@ bool scripting_engine::updateScripts()
 		{
 			continue; // skip
 		}
+		auto timeBegin = std::chrono::steady_clock::now();
 		node->function(node->timerID, IdToObject(node->baseobjtype, node->baseobj, node->player), node->additionalTimerFuncParam.get());
+		auto runTime = std::chrono::steady_clock::now() - timeBegin;
+		node->runTime += runTime;
+		if (node->instance != nullptr)
+		{
+			node->instance->performanceStats().timers += runTime;
+		}
 	}
 
 	return true;
@@ -875,6 +1001,59 @@ std::unordered_map<wzapi::scripting_instance *, nlohmann::json> scripting_engine
 	return debug_globals;
 }
 
+bool scripting_engine::isApiCallTimingEnabled() const
+{
+	return globalDialog || wzProfileEnabled();
+}
+
+bool scripting_engine::shouldInterruptScript(const wzapi::scripting_instance *instance) const
+{
+	int budgetMs = war_getScriptTickBudget();
+	if (budgetMs <= 0 || !war_getScriptBudgetInterrupt())
+	{
+		return false;
+	}
+	const auto &stats = instance->performanceStats();
+	return stats.depth > 0 && stats.thisTick + (std::chrono::steady_clock::now() - stats.callStart) > std::chrono::milliseconds(budgetMs);
+}
+
+nlohmann::json scripting_engine::getPerformanceSnapshot() const
+{
+	auto milliseconds = [](std::chrono::steady_clock::duration time) {
+		return std::chrono::duration<double, std::milli>(time).count();
+	};
+
+	nlohmann::json result = nlohmann::json::object();
+	for (auto *instance : scripts)
+	{
+		const auto &stats = instance->performanceStats();
+		nlohmann::json apiCalls = nlohmann::json::object();
+		for (const auto &it : stats.apiCalls)
+		{
+			nlohmann::json &apiCall = apiCalls[it.first];
+			uint64_t calls = it.second.calls;
+			double totalMs = milliseconds(it.second.time);
+			if (apiCall.is_object()) // The same name may be keyed by several literals.
+			{
+				calls += apiCall["calls"].get<uint64_t>();
+				totalMs += apiCall["totalMs"].get<double>();
+			}
+			apiCall = nlohmann::json::object({{"calls", calls}, {"totalMs", totalMs}});
+		}
+		nlohmann::json info = nlohmann::json::object();
+		info["totalMs"] = milliseconds(stats.total);
+		info["timersMs"] = milliseconds(stats.timers);
+		info["meanTickMs"] = milliseconds(stats.total) / std::max<uint32_t>(stats.ticks, 1);
+		info["worstTickMs"] = milliseconds(stats.worstTick);
+		info["worstTickGameTime"] = stats.worstTickGameTime;
+		info["ticksOverBudget"] = stats.ticksOverBudget;
+		info["interruptedCalls"] = stats.interruptedCalls;
+		info["api"] = std::move(apiCalls);
+		result[instance->scriptName() + ":" + std::to_string(instance->player())] = std::move(info);
+	}
+	return result;
+}
+
 std::vector<scripting_engine::timerNodeSnapshot> scripting_engine::debug_GetTimersSnapshot() const
 {
 	std::vector<scripting_engine::timerNodeSnapshot> debug_timer_snapshot;
@@ -1118,6 +1297,12 @@ bool triggerEvent(SCRIPT_TRIGGER_TYPE trigger, BASE_OBJECT *psObj)
 
 	if ((trigger == TRIGGER_START_LEVEL || trigger == TRIGGER_GAME_LOADED) && !saveandquit_enabled().empty())
 	{
+		// The automated tests save and quit right after loading, so check that the loaded ids can be looked up.
+		if (!objmemCheckIdIndex())
+		{
+			debug(LOG_ERROR, "Loaded objects can't be found by id");
+			exit(1);
+		}
 		saveGame(saveandquit_enabled().c_str(), GTYPE_SAVE_START);
 		exit(0);
 	}
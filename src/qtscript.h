@@ -260,6 +260,8 @@ public:
 		int player;
 		int calls;
 		timerType type;
+		uint64_t seq = 0; ///< Order in which the timer was added, timers due in the same tick run in this order.
+		std::chrono::steady_clock::duration runTime = std::chrono::steady_clock::duration::zero(); ///< Total time spent running the timer function.
 		timerNode() : instance(nullptr), baseobjtype(OBJ_NUM_TYPES), additionalTimerFuncParam(nullptr) {}
 		timerNode(wzapi::scripting_instance* caller, const TimerFunc& func, const std::string& timerName, int plr, int frame, std::unique_ptr<timerAdditionalData> additionalParam = nullptr);
 		~timerNode();
@@ -285,12 +287,26 @@ private:
 	typedef std::map<wzapi::scripting_instance *, GROUPMAP *> ENGINEMAP;
 	ENGINEMAP groups;
 
-	/// List of timer events for scripts. Before running them, we sort the list then run as many as we have time for.
-	/// In this way, we implement load balancing of events and keep frame rates tidy for users. Since scripts run on the
-	/// host, we do not need to worry about each peer simulating the world differently.
+	/// Entry in the timer heap. Entries are not removed when their timer is removed or rescheduled, instead they are
+	/// skipped when popped if the timer is gone or its frameTime no longer matches.
+	struct timerHeapEntry
+	{
+		int frameTime;
+		uint64_t seq;
+		std::weak_ptr<timerNode> node;
+	};
+
+	/// List of timer events for scripts, in the order they were added.
 	std::list<std::shared_ptr<timerNode>> timers;
 	uniqueTimerID lastTimerID = 0;
 	std::unordered_map<uniqueTimerID, std::list<std::shared_ptr<timerNode>>::iterator> timerIDMap; // a map from uniqueTimerID -> entry in the timers list
+	/// Min-heap of timers by frameTime, so that each tick only looks at the timers which are due.
+	std::vector<timerHeapEntry> timerHeap;
+	uint64_t lastTimerSeq = 0;
+	/// Oneshot timers which have run, to be removed at the start of the next tick.
+	std::vector<uniqueTimerID> doneOneshotTimers;
+	/// Number of repeating timers which have been spread, see setTimer().
+	unsigned timerSpreadCount = 0;
 private:
 	scripting_engine() { }
 public:
@@ -358,17 +374,40 @@ public:
 	void executeWithPerformanceMonitoring(wzapi::scripting_instance *instance, const std::string &function, Func f)
 	{
 		using microDuration = std::chrono::duration<uint64_t, std::micro>;
+		auto &stats = instance->performanceStats();
 		auto time_begin = std::chrono::steady_clock::now();
+		if (stats.depth++ == 0)
+		{
+			stats.callStart = time_begin;
+		}
 		f(); // execute provided Func f
-		auto duration_microsec = std::chrono::duration_cast<microDuration>(std::chrono::steady_clock::now() - time_begin);
+		auto time_end = std::chrono::steady_clock::now();
+		if (--stats.depth == 0)
+		{
+			stats.total += time_end - stats.callStart;
+			stats.thisTick += time_end - stats.callStart;
+		}
+		auto duration_microsec = std::chrono::duration_cast<microDuration>(time_end - time_begin);
 		int ticks = duration_microsec.count();
 		logFunctionPerformance(instance, function, ticks);
 	}
+	/// Whether the running script function of an instance should be interrupted, because the instance has used up its
+	/// scriptTickBudget. Only called for AIs running on the host, since interrupting scripts which run on all peers
+	/// would break sync.
+	bool shouldInterruptScript(const wzapi::scripting_instance *instance) const;
+	/// Time spent in each script instance, for the script debugger and the headless game summary.
+	nlohmann::json getPerformanceSnapshot() const;
+	/// Whether the time spent in each wzapi function is recorded. Only done while the script debugger is open or the
+	/// CPU profiler is running, since it costs two clock reads per call.
+	bool isApiCallTimingEnabled() const;
 private:
 	void logFunctionPerformance(wzapi::scripting_instance *instance, const std::string &function, int ticks);
 	uniqueTimerID getNextAvailableTimerID();
 	// internal-only function that adds a Timer node (used for restoring saved games)
 	void addTimerNode(std::shared_ptr<timerNode>&& node);
+	static bool timerHeapLater(const timerHeapEntry &a, const timerHeapEntry &b);
+	void pushTimerHeap(const std::shared_ptr<timerNode>& node);
+	void rebuildTimerHeap();
 
 // MARK: triggering events (from wz game code)
 public:
@@ -449,6 +488,7 @@ public:
 		int player = -1;
 		int calls = 0;
 		timerType type = TIMER_REMOVED;
+		std::chrono::steady_clock::duration runTime = std::chrono::steady_clock::duration::zero();
 		nlohmann::json instanceTimerRestoreData;
 
 		timerNodeSnapshot() { }
@@ -465,6 +505,7 @@ public:
 			player = node->player;
 			calls = node->calls;
 			type = node->type;
+			runTime = node->runTime;
 			instanceTimerRestoreData = node->instance->saveTimerFunction(node->timerID, node->timerName, node->additionalTimerFuncParam.get());
 		}
 	};
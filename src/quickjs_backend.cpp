@@ -154,6 +154,7 @@ public:
 		ctx = JS_NewContext(rt);
 		ASSERT(ctx != nullptr, "JS_NewContext failed?");
 		global_obj = JS_GetGlobalObject(ctx);
+		JS_SetContextOpaque(ctx, this);  // For looking up the instance without a map lookup, where it matters.
 
 		engineToInstanceMap.insert(std::pair<JSContext*, quickjs_scripting_instance*>(ctx, this));
 	}
@@ -243,6 +244,8 @@ private:
 	/// Separate event namespaces for libraries
 public: // temporary
 	std::vector<std::string> eventNamespaces;
+	/// Set when the interrupt handler stopped the running script function for going over the scriptTickBudget.
+	bool budgetInterrupted = false;
 	JSValue Get_Global_Obj() const { return global_obj; }
 
 public:
@@ -1153,6 +1156,14 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 		result = JS_Call(ctx, value, JS_UNDEFINED, (int)args.size(), args.data());
 	});
 
+	if (JS_IsException(result) && instance->budgetInterrupted)
+	{
+		instance->budgetInterrupted = false;
+		JS_FreeValue(ctx, JS_GetException(ctx));
+		instance->performanceStats().interruptedCalls++;
+		debug(LOG_SCRIPT, "Interrupted %s of %s, which is over its script tick budget", function.c_str(), instance->scriptName().c_str());
+		return JS_UNDEFINED;
+	}
 	if (JS_IsException(result))
 	{
 		JSValue err = JS_GetException(ctx);
@@ -2134,17 +2145,47 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 		MSVC_PRAGMA(warning( push )) // see matching "pop" below
 		MSVC_PRAGMA(warning( disable : 4189 )) // disable "warning C4189: 'idx': local variable is initialized but not referenced"
 
+		/// Adds the time until going out of scope to the script instance's stats for a wzapi function, if
+		/// scripting_engine::isApiCallTimingEnabled().
+		class ApiCallTimer
+		{
+		public:
+			ApiCallTimer(JSContext *context, const char *wrappedFunctionName)
+			{
+				if (scripting_engine::instance().isApiCallTimingEnabled())
+				{
+					auto instance = static_cast<quickjs_scripting_instance *>(JS_GetContextOpaque(context));
+					stats = &instance->performanceStats().apiCalls[wrappedFunctionName];
+					start = std::chrono::steady_clock::now();
+				}
+			}
+			~ApiCallTimer()
+			{
+				if (stats != nullptr)
+				{
+					stats->calls++;
+					stats->time += std::chrono::steady_clock::now() - start;
+				}
+			}
+
+		private:
+			wzapi::scripting_instance::PerformanceStats::ApiCallStats *stats = nullptr;
+			std::chrono::steady_clock::time_point start;
+		};
+
 		template<typename R, typename...Args>
-		JSValue wrap__(R(*f)(const wzapi::execution_context&, Args...), WZ_DECL_UNUSED const char *wrappedFunctionName, JSContext *context, WZ_DECL_UNUSED int argc, WZ_DECL_UNUSED JSValueConst *argv)
+		JSValue wrap__(R(*f)(const wzapi::execution_context&, Args...), const char *wrappedFunctionName, JSContext *context, WZ_DECL_UNUSED int argc, WZ_DECL_UNUSED JSValueConst *argv)
 		{
+			ApiCallTimer timer(context, wrappedFunctionName);
 			size_t idx WZ_DECL_UNUSED = 0; // unused when Args... is empty
 			quickjs_execution_context execution_context(context);
 			return box(apply(f, UnboxTuple<Args...>(execution_context, idx, context, argc, argv, wrappedFunctionName)()), context);
 		}
 
 		template<typename R, typename...Args>
-		JSValue wrap__(R(*f)(), WZ_DECL_UNUSED const char *wrappedFunctionName, JSContext *context, WZ_DECL_UNUSED int argc, WZ_DECL_UNUSED JSValueConst *argv)
+		JSValue wrap__(R(*f)(), const char *wrappedFunctionName, JSContext *context, WZ_DECL_UNUSED int argc, WZ_DECL_UNUSED JSValueConst *argv)
 		{
+			ApiCallTimer timer(context, wrappedFunctionName);
 			return box(f(), context);
 		}
 
@@ -2639,6 +2680,17 @@ static const JSCFunctionListEntry js_builtin_funcs[] = {
 	QJS_CFUNC_DEF("debugGetBacktrace", 0, debugGetBacktrace ) // backend-specific
 };
 
+static int quickjsBudgetInterruptHandler(JSRuntime *rt, void *opaque)
+{
+	auto *instance = static_cast<quickjs_scripting_instance *>(opaque);
+	if (!scripting_engine::instance().shouldInterruptScript(instance))
+	{
+		return 0;
+	}
+	instance->budgetInterrupted = true;
+	return 1;
+}
+
 bool quickjs_scripting_instance::loadScript(const WzString& path, int player, int difficulty)
 {
 	UDWORD size;
@@ -2652,6 +2704,11 @@ bool quickjs_scripting_instance::loadScript(const WzString& path, int player, in
 	{
 		calcDataHash(reinterpret_cast<const uint8_t *>(bytes), size, DATA_SCRIPT);
 	}
+	else
+	{
+		// Only AIs running on the host may be interrupted, other scripts run on all peers and must not diverge
+		JS_SetInterruptHandler(rt, quickjsBudgetInterruptHandler, this);
+	}
 	m_path = path.toUtf8();
 	compiledScriptObj = JS_Eval(ctx, bytes, size, path.toUtf8().c_str(), JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
 	free(bytes);
@@ -0,0 +1,132 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * replayverify.cpp
+ *
+ * Checks the sync CRCs recorded in a replay, for --verifyreplay.
+ */
+#include <3rdparty/json/json.hpp> // Must come before WZ includes
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/gamelib/gtime.h"
+
+#include "replayverify.h"
+
+static bool replayVerifying = false;
+static bool replayVerifyDone = false;
+static uint32_t replayVerifyLastGameTime = 0;
+static int replayVerifyLastProgress = -1;  ///< Real time when the game time last advanced, -1 before the first frame.
+
+void replayVerifySetEnabled(bool enabled)
+{
+	replayVerifying = enabled;
+	replayVerifyDone = false;
+	replayVerifyLastProgress = -1;
+}
+
+bool replayVerifyEnabled()
+{
+	return replayVerifying;
+}
+
+static void replayVerifyFinish(REPLAY_VERIFY_RESULT result, nlohmann::json &&details)
+{
+	if (replayVerifyDone)
+	{
+		return;  // wzQuit() doesn't return immediately.
+	}
+	replayVerifyDone = true;
+
+	static const char *resultNames[] = {"ok", "desync", "error"};
+	details["result"] = resultNames[result];
+	fprintf(stdout, "%s\n", details.dump().c_str());
+	fflush(stdout);
+	wzQuit(result);
+}
+
+void replayVerifyTickDone()
+{
+	if (!replayVerifying || gtimeSyncErrorCount() == 0)
+	{
+		return;
+	}
+
+	nlohmann::json details = nlohmann::json::object();
+	details["gameTime"] = gameTime;
+	details["firstDesyncGameTime"] = gtimeFirstSyncErrorTime();
+	replayVerifyFinish(REPLAY_VERIFY_DESYNC, std::move(details));
+}
+
+void replayVerifyFrameDone()
+{
+	if (!replayVerifying)
+	{
+		return;
+	}
+
+	int now = wzGetTicks();
+	if (replayVerifyLastProgress < 0 || gameTime != replayVerifyLastGameTime)
+	{
+		replayVerifyLastGameTime = gameTime;
+		replayVerifyLastProgress = now;
+		return;
+	}
+	if (now - replayVerifyLastProgress < REPLAY_VERIFY_STALL_TIMEOUT)
+	{
+		return;
+	}
+
+	// A mismatch is the more useful thing to report, if there was one.
+	replayVerifyTickDone();
+
+	// Nothing more can arrive, so some player's messages ran out before the REPLAY_ENDED message was reached.
+	nlohmann::json details = nlohmann::json::object();
+	details["gameTime"] = gameTime;
+	details["reason"] = "stalled";
+	replayVerifyFinish(REPLAY_VERIFY_ERROR, std::move(details));
+}
+
+void replayVerifyReplayEnded()
+{
+	if (!replayVerifying)
+	{
+		return;
+	}
+
+	// Catch any mismatch in the last messages.
+	replayVerifyTickDone();
+
+	nlohmann::json details = nlohmann::json::object();
+	details["gameTime"] = gameTime;
+	replayVerifyFinish(REPLAY_VERIFY_OK, std::move(details));
+}
+
+void replayVerifyLoadFailed(const char *filename)
+{
+	if (!replayVerifying)
+	{
+		return;
+	}
+
+	nlohmann::json details = nlohmann::json::object();
+	details["replay"] = filename;
+	details["reason"] = "load";
+	replayVerifyFinish(REPLAY_VERIFY_ERROR, std::move(details));
+}
@@ -0,0 +1,55 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2020  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Replay verification (--verifyreplay).
+ *
+ *  Plays a replay headless as fast as possible, checking our sync CRCs against the ones recorded in the replay's
+ *  GAME_GAME_TIME messages. Prints the result as JSON to stdout, and quits with a non-zero exit code on the first
+ *  mismatch, or if the replay can't be played to its end.
+ */
+
+#ifndef __INCLUDED_SRC_REPLAYVERIFY_H__
+#define __INCLUDED_SRC_REPLAYVERIFY_H__
+
+/// Exit codes.
+enum REPLAY_VERIFY_RESULT
+{
+	REPLAY_VERIFY_OK = 0,
+	REPLAY_VERIFY_DESYNC = 1,   ///< A CRC didn't match.
+	REPLAY_VERIFY_ERROR = 2,    ///< The replay couldn't be loaded, or ran out before its REPLAY_ENDED message.
+};
+
+/// Game ticks to fast-forward per frame while verifying. The messages are all loaded already, so we are never waiting.
+#define REPLAY_VERIFY_FASTFORWARD_TICKS 100
+/// Real time in milliseconds that the game time may stand still before the replay is taken to have run out.
+#define REPLAY_VERIFY_STALL_TIMEOUT 10000
+
+void replayVerifySetEnabled(bool enabled);
+bool replayVerifyEnabled();
+
+/// Called at the end of each game tick. Quits on a CRC mismatch.
+void replayVerifyTickDone();
+/// Called once per frame. Quits if the game time has stopped advancing, since all the messages were queued when loading.
+void replayVerifyFrameDone();
+/// Called when the REPLAY_ENDED message is processed. Quits.
+void replayVerifyReplayEnded();
+/// Called if the replay couldn't be loaded. Quits.
+void replayVerifyLoadFailed(const char *filename);
+
+#endif // __INCLUDED_SRC_REPLAYVERIFY_H__
@@ -56,6 +56,7 @@
 
 #include "activity.h"
 #include "multistat.h"
+#include "qtscript.h"
 #include "clparse.h"
 
 #include <algorithm>
@@ -616,6 +617,15 @@ void stdOutGameSummary(UDWORD realTimeThrottleSeconds, bool flush_output /* = tr
 		}
 	}
 	fprintf(stdout, "--------------------------------------------------------------------------------------\n");
+	fprintf(stdout, " Script             | Total (ms) | Timers (ms) | Worst tick (ms) | Over budget | Interrupted |\n");
+	fprintf(stdout, "------------------- | ---------- | ----------- | --------------- | ----------- | ----------- |\n");
+	for (const auto &it : scripting_engine::instance().getPerformanceSnapshot().items())
+	{
+		const nlohmann::json &info = it.value();
+		fprintf(stdout, "%19.19s | %10.1f | %11.1f | %15.2f | %11u | %11u |\n", it.key().c_str(), info["totalMs"].get<double>(), info["timersMs"].get<double>(),
+		        info["worstTickMs"].get<double>(), info["ticksOverBudget"].get<unsigned>(), info["interruptedCalls"].get<unsigned>());
+	}
+	fprintf(stdout, "--------------------------------------------------------------------------------------\n");
 	if (flush_output)
 	{
 		fflush(stdout);
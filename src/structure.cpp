@@ -1241,6 +1241,7 @@ static void buildFlatten(STRUCTURE *pStructure, int h)
 			}
 		}
 	}
+	visTerrainHeightChanged(b.map.x, b.map.y, b.map.x + b.size.x, b.map.y + b.size.y);
 }
 
 static bool isPulledToTerrain(const STRUCTURE *psBuilding)
@@ -24,6 +24,7 @@
  */
 #include "lib/framework/frame.h"
 #include "lib/framework/fixedpoint.h"
+#include "lib/framework/wzprofile.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio.h"
@@ -31,6 +32,7 @@
 #include "lib/ivis_opengl/ivisdef.h"
 
 #include <limits>
+#include <unordered_map>
 
 #include "visibility.h"
 
@@ -48,6 +50,8 @@
 #include "multiplay.h"
 #include "qtscript.h"
 #include "wavecast.h"
+#include "benchmark.h"
+#include "pointtree.h"
 
 // accuracy for the height gradient
 #define GRAD_MUL 10000
@@ -228,19 +232,14 @@ SPOTTER::~SPOTTER()
 /* Record all tiles that some object confers visibility to. Only record each tile
  * once. Note that there is both a limit to how many objects can watch any given
  * tile. Strange but non fatal things will happen if these limits are exceeded. */
-static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAPTILE *psTile, std::vector<TILEPOS> &watchedTiles)
+static inline void visMarkTile(const BASE_OBJECT *psObj, TILEPOS tilePos, std::vector<TILEPOS> &watchedTiles)
 {
 	const int rayPlayer = psObj->player;
-	const int xdiff = map_coord(psObj->pos.x) - mapX;
-	const int ydiff = map_coord(psObj->pos.y) - mapY;
-	const int distSq = xdiff * xdiff + ydiff * ydiff;
-	const bool inRange = (distSq < 16);
-	uint8_t *visionType = inRange ? psTile->watchers : psTile->sensors;
+	MAPTILE *psTile = mapTile(tilePos.x, tilePos.y);
+	uint8_t *visionType = tilePos.type ? psTile->watchers : psTile->sensors;
 
 	if (visionType[rayPlayer] < UBYTE_MAX)
 	{
-		TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(inRange)};
-
 		visionType[rayPlayer]++;                        // we observe this tile
 		if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))   // we are a jammer object
 		{
@@ -252,14 +251,37 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 	}
 }
 
-/* The terrain revealing ray callback */
-static void doWaveTerrain(BASE_OBJECT *psObj)
+/* Undo visMarkTile */
+static inline void visUnmarkTile(const BASE_OBJECT *psObj, TILEPOS pos)
+{
+	// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
+	MAPTILE *psTile = mapTile(pos.x, pos.y);
+
+	ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
+	uint8_t *visionType = (pos.type == 0) ? psTile->sensors : psTile->watchers;
+	if (visionType[psObj->player] == 0 && game.type == LEVEL_TYPE::CAMPAIGN)	// hack
+	{
+		return;
+	}
+	ASSERT(visionType[psObj->player] > 0, "No %s on watched tile (%d, %d)", pos.type ? "radar" : "vision", (int)pos.x, (int)pos.y);
+	visionType[psObj->player]--;
+	if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))  // we are a jammer object — we cannot check objJammerPower(psObj) > 0 directly here, we may be in the BASE_OBJECT destructor).
+	{
+		// No jammers in campaign, no need for special hack
+		ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
+		psTile->jammers[psObj->player]--;
+		if (psTile->jammers[psObj->player] == 0)
+		{
+			psTile->jammerBits &= ~(1 << psObj->player);
+		}
+	}
+	updateTileVis(psTile);
+}
+
+/* The terrain revealing ray callback. Finds the tiles which can be seen from a tile, at height sz, without changing anything.
+ * The type of each tile is 1 if close enough to be watched, or 0 if only in sensor range. */
+static void waveTerrain(int tileX, int tileY, int sz, unsigned radius, std::vector<TILEPOS> &seenTiles)
 {
-	const int sx = psObj->pos.x;
-	const int sy = psObj->pos.y;
-	const int sz = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
-	const unsigned radius = objSensorRange(psObj);
-	const int rayPlayer = psObj->player;
 	size_t size;
 	const WavecastTile *tiles = getWavecastTable(radius, &size);
 #define MAX_WAVECAST_LIST_SIZE 1360  // Trivial upper bound to what a fully upgraded WSS can use (its number of angles). Should probably be some factor times the maximum possible radius. Is probably a lot more than needed. Tested to need at least 180.
@@ -275,11 +297,11 @@ static void doWaveTerrain(BASE_OBJECT *psObj)
 	angles[!readList][writeListPos] = 0;               // Smallest angle.
 	++writeListPos;
 
-	psObj->watchedTiles.clear();
+	seenTiles.clear();
 	for (size_t i = 0; i < size; ++i)
 	{
-		const int mapX = map_coord(sx) + tiles[i].dx;
-		const int mapY = map_coord(sy) + tiles[i].dy;
+		const int mapX = tileX + tiles[i].dx;
+		const int mapY = tileY + tiles[i].dy;
 		if (mapX < 0 || mapX >= mapWidth || mapY < 0 || mapY >= mapHeight)
 		{
 			continue;
@@ -330,10 +352,163 @@ static void doWaveTerrain(BASE_OBJECT *psObj)
 		if (seen)
 		{
 			// Can see this tile.
-			psTile->tileExploredBits |= alliancebits[rayPlayer];                        // Share exploration with allies too
-			visMarkTile(psObj, mapX, mapY, psTile, psObj->watchedTiles);   // Mark this tile as seen by our sensor
+			const int xdiff = tileX - mapX;
+			const int ydiff = tileY - mapY;
+			const bool inRange = xdiff * xdiff + ydiff * ydiff < 16;
+			seenTiles.push_back(TILEPOS{uint8_t(mapX), uint8_t(mapY), uint8_t(inRange)});
+		}
+	}
+}
+
+struct WaveTerrainKey
+{
+	bool operator ==(WaveTerrainKey const &b) const
+	{
+		return x == b.x && y == b.y && z == b.z && radius == b.radius;
+	}
+
+	int32_t x, y, z;
+	uint32_t radius;
+};
+
+struct WaveTerrainKeyHash
+{
+	size_t operator ()(WaveTerrainKey const &k) const
+	{
+		return ((uint32_t)k.x * 73856093u) ^ ((uint32_t)k.y * 19349663u) ^ ((uint32_t)k.z * 83492791u) ^ (k.radius * 2654435761u);
+	}
+};
+
+/// Tiles seen by structures, which don't move, so usually see the same tiles each time they are updated (such as after
+/// each upgrade). Entries are dropped when the terrain within their radius changes height.
+static std::unordered_map<WaveTerrainKey, std::vector<TILEPOS>, WaveTerrainKeyHash> waveTerrainCache;
+#define WAVE_TERRAIN_CACHE_MAX 4096
+
+void visTerrainHeightChanged(int x1, int y1, int x2, int y2)
+{
+	for (auto i = waveTerrainCache.begin(); i != waveTerrainCache.end();)
+	{
+		const int reach = i->first.radius / TILE_UNITS + 1;
+		if (i->first.x + reach >= x1 && i->first.x - reach <= x2 && i->first.y + reach >= y1 && i->first.y - reach <= y2)
+		{
+			i = waveTerrainCache.erase(i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void visTerrainChanged()
+{
+	waveTerrainCache.clear();
+}
+
+/// Returns the tiles which psObj can see from where it is.
+static std::vector<TILEPOS> const &doWaveTerrain(BASE_OBJECT *psObj)
+{
+	const int tileX = map_coord(psObj->pos.x);
+	const int tileY = map_coord(psObj->pos.y);
+	const int sz = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
+	const unsigned radius = objSensorRange(psObj);
+
+	if (psObj->type == OBJ_STRUCTURE)
+	{
+		WaveTerrainKey key{tileX, tileY, sz, radius};
+		auto cached = waveTerrainCache.find(key);
+		if (cached != waveTerrainCache.end())
+		{
+#ifdef DEBUG
+			std::vector<TILEPOS> check;
+			waveTerrain(tileX, tileY, sz, radius, check);
+			ASSERT(check.size() == cached->second.size() && std::equal(check.begin(), check.end(), cached->second.begin(), [](TILEPOS a, TILEPOS b) {
+				return a.x == b.x && a.y == b.y && a.type == b.type;
+			}), "Cached wavecast for (%d, %d) is out of date.", tileX, tileY);
+#endif
+			return cached->second;
+		}
+		if (waveTerrainCache.size() >= WAVE_TERRAIN_CACHE_MAX)
+		{
+			waveTerrainCache.clear();
+		}
+		std::vector<TILEPOS> &seenTiles = waveTerrainCache[key];
+		waveTerrain(tileX, tileY, sz, radius, seenTiles);
+		return seenTiles;
+	}
+
+	static std::vector<TILEPOS> seenTiles;
+	waveTerrain(tileX, tileY, sz, radius, seenTiles);
+	return seenTiles;
+}
+
+/// Which tiles an object watched before its update, for visUpdateWatchedTiles. Marks are (stamp << 2) | (1 + type) for
+/// tiles watched before the update, or (stamp << 2) | 3 for tiles which are still watched.
+static std::vector<uint32_t> visTileMarks;
+static uint32_t visTileStamp = 0;
+
+/// Changes the tiles watched by psObj to seenTiles, only touching the watch counts of tiles which changed. Gives
+/// the same result as visRemoveVisibility() followed by marking all of seenTiles. Returns false without changing
+/// anything if the watched tiles don't fit on the current map.
+static bool visUpdateWatchedTiles(BASE_OBJECT *psObj, std::vector<TILEPOS> const &seenTiles)
+{
+	for (TILEPOS pos : psObj->watchedTiles)
+	{
+		if (pos.x >= mapWidth || pos.y >= mapHeight)
+		{
+			return false;
+		}
+	}
+
+	const size_t numTiles = mapWidth * mapHeight;
+	if (visTileMarks.size() != numTiles || visTileStamp >= UINT32_MAX >> 2)
+	{
+		visTileMarks.assign(numTiles, 0);
+		visTileStamp = 0;
+	}
+	const uint32_t stamp = ++visTileStamp << 2;
+	const uint32_t kept = stamp | 3;
+
+	for (TILEPOS pos : psObj->watchedTiles)
+	{
+		visTileMarks[pos.x + pos.y * mapWidth] = stamp | (1 + pos.type);
+	}
+	static std::vector<TILEPOS> added;
+	added.clear();
+	for (TILEPOS pos : seenTiles)
+	{
+		uint32_t &mark = visTileMarks[pos.x + pos.y * mapWidth];
+		if (mark == (stamp | (1 + pos.type)))
+		{
+			mark = kept;
+		}
+		else
+		{
+			added.push_back(pos);
+		}
+	}
+
+	// Remove first, then add, like removing everything and adding everything, in case of full watch counts.
+	size_t numKept = 0;
+	for (TILEPOS pos : psObj->watchedTiles)
+	{
+		if (visTileMarks[pos.x + pos.y * mapWidth] == kept)
+		{
+			psObj->watchedTiles[numKept++] = pos;
+			updateTileVis(mapTile(pos.x, pos.y));  // The alliances might have changed.
+		}
+		else
+		{
+			visUnmarkTile(psObj, pos);
 		}
 	}
+	psObj->watchedTiles.resize(numKept);
+
+	for (TILEPOS pos : added)
+	{
+		visMarkTile(psObj, pos, psObj->watchedTiles);
+	}
+	return true;
 }
 
 /* The los ray callback */
@@ -392,28 +567,7 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 	{
 		for (TILEPOS pos : psObj->watchedTiles)
 		{
-			// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
-			MAPTILE *psTile = mapTile(pos.x, pos.y);
-
-			ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
-			uint8_t *visionType = (pos.type == 0) ? psTile->sensors : psTile->watchers;
-			if (visionType[psObj->player] == 0 && game.type == LEVEL_TYPE::CAMPAIGN)	// hack
-			{
-				continue;
-			}
-			ASSERT(visionType[psObj->player] > 0, "No %s on watched tile (%d, %d)", pos.type ? "radar" : "vision", (int)pos.x, (int)pos.y);
-			visionType[psObj->player]--;
-			if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))  // we are a jammer object — we cannot check objJammerPower(psObj) > 0 directly here, we may be in the BASE_OBJECT destructor).
-			{
-				// No jammers in campaign, no need for special hack
-				ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
-				psTile->jammers[psObj->player]--;
-				if (psTile->jammers[psObj->player] == 0)
-				{
-					psTile->jammerBits &= ~(1 << psObj->player);
-				}
-			}
-			updateTileVis(psTile);
+			visUnmarkTile(psObj, pos);
 		}
 	}
 	psObj->watchedTiles.clear();
@@ -430,6 +584,21 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 {
 	ASSERT(psObj->type != OBJ_FEATURE, "visTilesUpdate: visibility updates are not for features!");
 
+	const bool jammer = objJammerPower(psObj) > 0;
+	if (psObj->type == OBJ_DROID && jammer == psObj->flags.test(OBJECT_FLAG_JAMMED_TILES) && mapWidth && mapHeight)
+	{
+		// Droids usually just moved to the next tile, so most of the watched tiles are still watched.
+		std::vector<TILEPOS> const &seenTiles = doWaveTerrain(psObj);
+		if (visUpdateWatchedTiles(psObj, seenTiles))
+		{
+			for (TILEPOS pos : seenTiles)
+			{
+				mapTile(pos.x, pos.y)->tileExploredBits |= alliancebits[psObj->player];  // Share exploration with allies too
+			}
+			return;
+		}
+	}
+
 	// Remove previous map visibility provided by object
 	visRemoveVisibility(psObj);
 
@@ -445,8 +614,12 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 	}
 
 	// Do the whole circle in ∞ steps. No more pretty moiré patterns.
-	psObj->flags.set(OBJECT_FLAG_JAMMED_TILES, objJammerPower(psObj) > 0);
-	doWaveTerrain(psObj);
+	psObj->flags.set(OBJECT_FLAG_JAMMED_TILES, jammer);
+	for (TILEPOS pos : doWaveTerrain(psObj))
+	{
+		mapTile(pos.x, pos.y)->tileExploredBits |= alliancebits[psObj->player];  // Share exploration with allies too
+		visMarkTile(psObj, pos, psObj->watchedTiles);
+	}
 }
 
 /*reveals all the terrain in the map*/
@@ -831,8 +1004,63 @@ static void processVisibilityLevel(BASE_OBJECT *psObj, bool& addedMessage)
 	}
 }
 
+/// Makes active radars visible to the owners of radar detectors in range.
+/// Only the active radars are indexed, since there are usually far fewer of them than objects on the grid.
+static void processRadarDetectors()
+{
+	static std::vector<BASE_OBJECT *> detectors;
+	static PointTree activeRadars;
+
+	detectors.clear();
+	activeRadars.clear();
+	unsigned numSensors = 0;
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
+	{
+		++numSensors;
+		if (objRadarDetector(psObj))
+		{
+			detectors.push_back(psObj);
+		}
+		if (objActiveRadar(psObj))
+		{
+			activeRadars.insert(psObj, psObj->pos.x, psObj->pos.y, psObj->id);
+		}
+	}
+	benchmarkCount(BENCHMARK_RADAR_SENSORS, numSensors);
+	benchmarkCount(BENCHMARK_RADAR_DETECTORS, detectors.size());
+	if (detectors.empty())
+	{
+		return;
+	}
+	activeRadars.sort();
+
+	// The order doesn't matter, since each target can only be made visible to each player once.
+	uint64_t numPairs = 0;
+	for (BASE_OBJECT *psObj : detectors)
+	{
+		int range = objSensorRange(psObj) * 10;
+		if (range <= 0)
+		{
+			continue;
+		}
+		for (void *target : activeRadars.query(psObj->pos.x, psObj->pos.y, range))
+		{
+			BASE_OBJECT *psTarget = static_cast<BASE_OBJECT *>(target);
+			++numPairs;
+			if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
+			    && iHypot((psTarget->pos - psObj->pos).xy()) < range)
+			{
+				psTarget->visible[psObj->player] = UBYTE_MAX / 2;
+			}
+		}
+	}
+	benchmarkCount(BENCHMARK_RADAR_PAIRS, numPairs);
+}
+
 void processVisibility()
 {
+	WZ_PROFILE_ZONE("processVisibility");
+
 	updateSpotters();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
@@ -858,21 +1086,7 @@ void processVisibility()
 			}
 		}
 	}
-	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
-	{
-		if (objRadarDetector(psObj))
-		{
-			for (BASE_OBJECT *psTarget = apsSensorList[0]; psTarget != nullptr; psTarget = psTarget->psNextFunc)
-			{
-				if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
-				    && objActiveRadar(psTarget)
-				    && iHypot((psTarget->pos - psObj->pos).xy()) < objSensorRange(psObj) * 10)
-				{
-					psTarget->visible[psObj->player] = UBYTE_MAX / 2;
-				}
-			}
-		}
-	}
+	processRadarDetectors();
 	bool addedMessage = false;
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
@@ -33,6 +33,11 @@ bool visInitialise();
 /* Check which tiles can be seen by an object */
 void visTilesUpdate(BASE_OBJECT *psObj);
 
+/// Must be called when the height of tiles in the given (inclusive) tile rectangle changes, since the tiles seen by structures are cached.
+void visTerrainHeightChanged(int x1, int y1, int x2, int y2);
+/// Must be called when the whole map changes.
+void visTerrainChanged();
+
 void revealAll(UBYTE player);
 
 /* Check whether psViewer can see psTarget
@@ -66,10 +66,14 @@ struct WARZONE_GLOBALS
 	bool autoAdjustDisplayScale = true;
 	int autoLagKickSeconds = 60;
 	bool disableReplayRecording = false;
+	bool scriptTimerSpread = false;
+	int scriptTickBudget = 0;
+	bool scriptBudgetInterrupt = false;
 	uint32_t MPinactivityMinutes = 5;
 	uint8_t MPopenSpectatorSlots = 0;
 	int fogStart = 4000;
 	int fogEnd = 8000;
+	int pathThreads = 0; // 0 = pick based on the number of CPU cores
 };
 
 static WARZONE_GLOBALS warGlobs;
@@ -433,6 +437,36 @@ void war_setDisableReplayRecording(bool disable)
 	warGlobs.disableReplayRecording = disable;
 }
 
+bool war_getScriptTimerSpread()
+{
+	return warGlobs.scriptTimerSpread;
+}
+
+void war_setScriptTimerSpread(bool spread)
+{
+	warGlobs.scriptTimerSpread = spread;
+}
+
+int war_getScriptTickBudget()
+{
+	return warGlobs.scriptTickBudget;
+}
+
+void war_setScriptTickBudget(int milliseconds)
+{
+	warGlobs.scriptTickBudget = std::max(milliseconds, 0);
+}
+
+bool war_getScriptBudgetInterrupt()
+{
+	return warGlobs.scriptBudgetInterrupt;
+}
+
+void war_setScriptBudgetInterrupt(bool interrupt)
+{
+	warGlobs.scriptBudgetInterrupt = interrupt;
+}
+
 uint32_t war_getMPInactivityMinutes()
 {
 	return warGlobs.MPinactivityMinutes;
@@ -477,3 +511,13 @@ void war_setFogStart(int start)
 {
 	 warGlobs.fogStart = start;
 }
+
+int war_getPathThreads()
+{
+	return warGlobs.pathThreads;
+}
+
+void war_setPathThreads(int threads)
+{
+	warGlobs.pathThreads = std::max(threads, 0);
+}
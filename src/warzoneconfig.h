@@ -120,6 +120,14 @@ int war_getAutoLagKickSeconds();
 void war_setAutoLagKickSeconds(int seconds);
 bool war_getDisableReplayRecording();
 void war_setDisableReplayRecording(bool disable);
+bool war_getScriptTimerSpread();
+void war_setScriptTimerSpread(bool spread);
+/// Time in milliseconds each script may take per game tick before a warning is logged, 0 for no limit.
+int war_getScriptTickBudget();
+void war_setScriptTickBudget(int milliseconds);
+/// Whether AIs running on the host are interrupted when they go over the scriptTickBudget.
+bool war_getScriptBudgetInterrupt();
+void war_setScriptBudgetInterrupt(bool interrupt);
 uint32_t war_getMPInactivityMinutes();
 void war_setMPInactivityMinutes(uint32_t minutes);
 uint16_t war_getMPopenSpectatorSlots();
@@ -128,6 +136,8 @@ int war_getFogEnd();
 int war_getFogStart();
 void war_setFogEnd(int end);
 void war_setFogStart(int start);
+int war_getPathThreads();
+void war_setPathThreads(int threads);
 
 /**
  * Enable or disable sound initialization
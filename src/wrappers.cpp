@@ -34,6 +34,8 @@
 #include "lib/sound/audio.h"
 #include "lib/framework/wzapp.h"
 
+#include "benchmark.h"
+#include "replayverify.h"
 #include "clparse.h"
 #include "frontend.h"
 #include "keyedit.h"
@@ -107,9 +109,9 @@ static void setupLoadingScreen()
 
 bool recalculateEffectiveHeadlessValue()
 {
-	if (hostlaunch == HostLaunch::Skirmish || hostlaunch == HostLaunch::Autohost || autogame_enabled())
+	if (hostlaunch == HostLaunch::Skirmish || hostlaunch == HostLaunch::Autohost || autogame_enabled() || benchmarkTicks() != 0 || replayVerifyEnabled())
 	{
-		// only support headless mode if hostlaunch is --skirmish or --autogame
+		// only support headless mode if hostlaunch is --skirmish or --autogame, or when benchmarking or verifying a replay
 		return bHeadlessAutoGameModeCLIOption;
 	}
 	return false;
@@ -77,8 +77,11 @@
 #include "chat.h"
 #include "scores.h"
 #include "data.h"
+#include "objmem.h"
 
 #include <list>
+#include <map>
+#include <tuple>
 
 /// Assert for scripts that give useful backtraces and other info.
 #if defined(SCRIPT_ASSERT)
@@ -996,10 +999,52 @@ bool wzapi::structureIdle(WZAPI_PARAMS(const STRUCTURE *psStruct))
 	return ::structureIdle(psStruct);
 }
 
+// Scripts (AIs in particular) call the enum functions with the same arguments over and over, so the objects of each
+// list which match the arguments are cached, in list order. Only the died and visible flags, which change all the
+// time, are then checked per call. The cache is dropped when any object is added to or removed from a list, and each
+// entry remembers the head of the list it was made from, to notice lists being replaced as a whole.
+template <typename OBJECT>
+struct EnumCacheEntry
+{
+	const OBJECT *listHead = nullptr;
+	std::vector<const OBJECT *> objects;
+};
+
+static uint32_t enumCacheGeneration = 0;
+static std::map<std::tuple<DROID **, int, DROID_TYPE>, EnumCacheEntry<DROID>> enumDroidCache;  ///< By list, player and droid type.
+static std::map<std::tuple<STRUCTURE **, int, STRUCTURE_TYPE, std::string>, EnumCacheEntry<STRUCTURE>> enumStructCache;  ///< By list, player, structure type and stats name.
+static std::map<std::string, EnumCacheEntry<FEATURE>> enumFeatureCache;  ///< By stats name.
+
+template <typename OBJECT, typename KEY, typename MATCH>
+static const std::vector<const OBJECT *> &enumCacheLookup(std::map<KEY, EnumCacheEntry<OBJECT>> &cache, const KEY &key, OBJECT *listHead, MATCH match)
+{
+	if (enumCacheGeneration != objListGeneration)
+	{
+		enumDroidCache.clear();
+		enumStructCache.clear();
+		enumFeatureCache.clear();
+		enumCacheGeneration = objListGeneration;
+	}
+	EnumCacheEntry<OBJECT> &entry = cache[key];
+	if (entry.listHead != listHead)  // New entries have a null head, which is also right for empty lists.
+	{
+		entry.listHead = listHead;
+		entry.objects.clear();
+		for (OBJECT *psObj = listHead; psObj; psObj = psObj->psNext)
+		{
+			if (match(psObj))
+			{
+				entry.objects.push_back(psObj);
+			}
+		}
+	}
+	return entry.objects;
+}
+
 std::vector<const STRUCTURE *> _enumStruct_fromList(WZAPI_PARAMS(optional<int> _player, optional<wzapi::STRUCTURE_TYPE_or_statsName_string> _structureType, optional<int> _playerFilter), STRUCTURE **psStructLists)
 {
 	std::vector<const STRUCTURE *> matches;
-	WzString statsName;
+	std::string statsName;
 	STRUCTURE_TYPE type = NUM_DIFF_BUILDINGS;
 
 	int player = _player.value_or(context.player());
@@ -1008,17 +1053,21 @@ std::vector<const STRUCTURE *> _enumStruct_fromList(WZAPI_PARAMS(optional<int> _
 	if (_structureType.has_value())
 	{
 		type = _structureType.value().type;
-		statsName = WzString::fromUtf8(_structureType.value().statsName);
+		statsName = _structureType.value().statsName;
 	}
 
 	SCRIPT_ASSERT_PLAYER({}, context, player);
 	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS, "Player filter index out of range: %d", playerFilter);
-	for (STRUCTURE *psStruct = psStructLists[player]; psStruct; psStruct = psStruct->psNext)
+	WzString wzStatsName = WzString::fromUtf8(statsName);
+	auto const &candidates = enumCacheLookup(enumStructCache, std::make_tuple(psStructLists, player, type, statsName), psStructLists[player], [type, &wzStatsName](const STRUCTURE *psStruct) {
+		return (type == NUM_DIFF_BUILDINGS || type == psStruct->pStructureType->type)
+		    && (wzStatsName.isEmpty() || wzStatsName.compare(psStruct->pStructureType->id) == 0);
+	});
+	matches.reserve(candidates.size());
+	for (const STRUCTURE *psStruct : candidates)
 	{
 		if ((playerFilter == ALL_PLAYERS || psStruct->visible[playerFilter])
-		    && !psStruct->died
-		    && (type == NUM_DIFF_BUILDINGS || type == psStruct->pStructureType->type)
-		    && (statsName.isEmpty() || statsName.compare(psStruct->pStructureType->id) == 0))
+		    && !psStruct->died)
 		{
 			matches.push_back(psStruct);
 		}
@@ -1088,11 +1137,14 @@ std::vector<const DROID *> wzapi::enumDroid(WZAPI_PARAMS(optional<int> _player,
 	}
 	SCRIPT_ASSERT_PLAYER({}, context, player);
 	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS, "Player filter index out of range: %d", playerFilter);
-	for (DROID *psDroid = apsDroidLists[player]; psDroid; psDroid = psDroid->psNext)
+	auto const &candidates = enumCacheLookup(enumDroidCache, std::make_tuple(+apsDroidLists, player, droidType), apsDroidLists[player], [droidType, droidType2](const DROID *psDroid) {
+		return droidType == DROID_ANY || droidType == psDroid->droidType || droidType2 == psDroid->droidType;
+	});
+	matches.reserve(candidates.size());
+	for (const DROID *psDroid : candidates)
 	{
 		if ((playerFilter == ALL_PLAYERS || psDroid->visible[playerFilter])
-		    && !psDroid->died
-		    && (droidType == DROID_ANY || droidType == psDroid->droidType || droidType2 == psDroid->droidType))
+		    && !psDroid->died)
 		{
 			matches.push_back(psDroid);
 		}
@@ -1109,18 +1161,18 @@ std::vector<const DROID *> wzapi::enumDroid(WZAPI_PARAMS(optional<int> _player,
 std::vector<const FEATURE *> wzapi::enumFeature(WZAPI_PARAMS(int playerFilter, optional<std::string> _featureName))
 {
 	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS, "Player filter index out of range: %d", playerFilter);
-	WzString featureName;
-	if (_featureName.has_value())
-	{
-		featureName = WzString::fromUtf8(_featureName.value());
-	}
+	std::string featureName = _featureName.value_or(std::string());
+	WzString wzFeatureName = WzString::fromUtf8(featureName);
 
+	auto const &candidates = enumCacheLookup(enumFeatureCache, featureName, apsFeatureLists[0], [&wzFeatureName](const FEATURE *psFeat) {
+		return wzFeatureName.isEmpty() || wzFeatureName.compare(psFeat->psStats->id) == 0;
+	});
 	std::vector<const FEATURE *> matches;
-	for (FEATURE *psFeat = apsFeatureLists[0]; psFeat; psFeat = psFeat->psNext)
+	matches.reserve(candidates.size());
+	for (const FEATURE *psFeat : candidates)
 	{
 		if ((playerFilter == ALL_PLAYERS || psFeat->visible[playerFilter])
-		    && !psFeat->died
-		    && (featureName.isEmpty() || featureName.compare(psFeat->psStats->id) == 0))
+		    && !psFeat->died)
 		{
 			matches.push_back(psFeat);
 		}
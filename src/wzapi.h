@@ -65,6 +65,8 @@ using nonstd::nullopt;
 #include <vector>
 #include <memory>
 #include <functional>
+#include <chrono>
+#include <unordered_map>
 
 typedef uint64_t uniqueTimerID;
 class timerAdditionalData
@@ -631,6 +633,30 @@ namespace wzapi
 		void dumpScriptLog(const std::string &info);
 		void dumpScriptLog(const std::string &info, int me);
 
+	public:
+		/// Time spent running the script, see scripting_engine::executeWithPerformanceMonitoring().
+		struct PerformanceStats
+		{
+			struct ApiCallStats
+			{
+				uint64_t calls = 0;
+				std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+			};
+			std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();     ///< Time spent in script functions.
+			std::chrono::steady_clock::duration timers = std::chrono::steady_clock::duration::zero();    ///< Part of total spent in timers.
+			std::chrono::steady_clock::duration thisTick = std::chrono::steady_clock::duration::zero();  ///< Part of total spent since the last game tick.
+			std::chrono::steady_clock::duration worstTick = std::chrono::steady_clock::duration::zero();
+			uint32_t worstTickGameTime = 0;
+			uint32_t ticks = 0;
+			uint32_t ticksOverBudget = 0;     ///< Ticks in which more than the scriptTickBudget was spent.
+			uint32_t interruptedCalls = 0;    ///< Calls interrupted for being over budget.
+			int depth = 0;                    ///< Nesting of script function calls.
+			std::chrono::steady_clock::time_point callStart;  ///< When the outermost script function call started.
+			std::unordered_map<const char *, ApiCallStats> apiCalls;  ///< Keyed on the (string literal) wzapi function name.
+		};
+		PerformanceStats& performanceStats() { return m_performanceStats; }
+		const PerformanceStats& performanceStats() const { return m_performanceStats; }
+
 	public:
 		virtual void updateGameTime(uint32_t gameTime) = 0;
 		virtual void updateGroupSizes(int group, int size) = 0;
@@ -657,6 +683,7 @@ namespace wzapi
 		std::string m_scriptName;
 		std::string m_scriptPath;
 		bool m_isReceivingAllEvents = false;
+		PerformanceStats m_performanceStats;
 	};
 
 	class execution_context_base
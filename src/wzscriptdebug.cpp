@@ -206,7 +206,7 @@ static RowDataModel fillMessageModel()
 
 static RowDataModel fillTriggersModel(const std::vector<scripting_engine::timerNodeSnapshot>& trigger_snapshot, wzapi::scripting_instance *context)
 {
-	RowDataModel result(7);
+	RowDataModel result(8);
 	for (const auto &node : trigger_snapshot)
 	{
 		if (node.instance != context)
@@ -239,6 +239,7 @@ static RowDataModel fillTriggersModel(const std::vector<scripting_engine::timerN
 			columnTexts.push_back("Repeat");
 		}
 		columnTexts.push_back(WzString::number(node.calls));
+		columnTexts.push_back(WzString::number(std::chrono::duration<double, std::milli>(node.runTime).count()));
 		result.newRow(columnTexts, SCRIPTDEBUG_ROW_HEIGHT);
 	}
 	return result;
@@ -277,6 +278,7 @@ static nlohmann::ordered_json fillMainModel()
 	result["difficultyLevel"] = difficulty_type.at(getDifficultyLevel());
 	result["loopPieCount"] = loopPieCount;
 	result["loopPolyCount"] = loopPolyCount;
+	result["loopDrawCount"] = loopDrawCount;
 	result["allowDesign"] = allowDesign;
 	result["includeRedundantDesigns"] = includeRedundantDesigns;
 
@@ -287,6 +289,7 @@ static nlohmann::ordered_json fillMainModel()
 	result["No. droids"] = droids;
 	result["No. structures"] = structures;
 	result["No. features"] = features;
+	result["Script performance"] = scripting_engine::instance().getPerformanceSnapshot();
 
 	return result;
 }
@@ -1231,6 +1234,7 @@ public:
 		auto intervalLabel = createColHeaderLabel("Interval");
 		auto typeLabel = createColHeaderLabel("Type");
 		auto callsLabel = createColHeaderLabel("Calls");
+		auto runTimeLabel = createColHeaderLabel("Run time (ms)");
 		std::vector<TableColumn> columns {
 			{idLabel, TableColumn::ResizeBehavior::RESIZABLE},
 			{functionLabel, TableColumn::ResizeBehavior::RESIZABLE},
@@ -1238,7 +1242,8 @@ public:
 			{timeLabel, TableColumn::ResizeBehavior::RESIZABLE},
 			{intervalLabel, TableColumn::ResizeBehavior::RESIZABLE},
 			{typeLabel, TableColumn::ResizeBehavior::RESIZABLE},
-			{callsLabel, TableColumn::ResizeBehavior::RESIZABLE}
+			{callsLabel, TableColumn::ResizeBehavior::RESIZABLE},
+			{runTimeLabel, TableColumn::ResizeBehavior::RESIZABLE}
 		};
 		std::vector<size_t> minimumColumnWidths;
 		for (auto& column : columns)
@@ -18,12 +18,24 @@ function run
 	gdb -q --ex run --ex quit --args src/warzone2100 --window --configdir=tmp --resolution=1024x768 --shadows --sound --texturecompression $1
 }
 
+function saveandquit
+{
+	echo
+	echo " -- $2 --"
+	echo
+	# Fails if the loaded structures and features can't be found by their saved ids.
+	if ! timeout 600 src/warzone2100 --window --configdir=tmp --resolution=1024x768 $1; then
+		echo " * $2 failed"
+		exit 1
+	fi
+}
+
 function cam
 {
 	echo
 	echo " ==== $2 ===="
-	run "--game=$1 --saveandquit=savegames/campaign/$1.gam" "Initial run"
-	run "--loadcampaign=$1 --saveandquit=savegames/campaign/$1-loadsave.gam" "Loadsave run"
+	saveandquit "--game=$1 --saveandquit=savegames/campaign/$1.gam" "Initial run"
+	saveandquit "--loadcampaign=$1 --saveandquit=savegames/campaign/$1-loadsave.gam" "Loadsave run"
 }
 
 function skirmish
@@ -37,6 +49,32 @@ function skirmish
 	#run "--autogame --loadskirmish=$1" "$1 : Loading and running"
 }
 
+function verify
+{
+	echo
+	echo " -- $3 --"
+	echo
+	timeout 600 src/warzone2100 --configdir=tmp --loadreplay="skirmish/$1" --verifyreplay
+	local result=$?
+	if [ $result -ne $2 ]; then
+		echo " * Expected exit code $2 from --verifyreplay, got $result"
+		exit 1
+	fi
+}
+
+function replay
+{
+	echo
+	echo " ==== $1 : $2 ===="
+	run "--skirmish=$1.json --benchmark=600" "$1 : Recording"
+	local recorded
+	recorded=$(ls -t tmp/replay/skirmish/*.wzrp | head -n 1)
+	verify "$(basename "$recorded")" 0 "$1 : Verifying"
+	# Cut off the end, including the REPLAY_ENDED message. Verifying must fail, not hang.
+	head -c $(( $(stat -c %s "$recorded") / 2 )) "$recorded" > tmp/replay/skirmish/truncated.wzrp
+	verify truncated.wzrp 2 "$1 : Verifying truncated"
+}
+
 echo
 echo "Running Warzone2100 automated tests"
 echo -n "Time is: "
@@ -51,3 +89,5 @@ cam FASTPLAY "Fastplay"
 skirmish highground "Basic skirmish"
 skirmish miza "All AIs"
 skirmish miza_challenge "Best AI vs 7 old timers"
+
+replay highground "Replay verification"